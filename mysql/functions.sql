@@ -142,6 +142,20 @@ BEGIN
 END$$
 DELIMITER ;
 
+/**
+ * add_team_score_delta This adds to the saved score totals of a team (game_team_scores), so they don't need to be recalculated after every find
+ */
+DROP FUNCTION IF EXISTS add_team_score_delta;
+DELIMITER $$
+CREATE FUNCTION add_team_score_delta(team_idIn INT, find_pointsIn INT, extras_pointsIn INT, penalty_pointsIn INT) RETURNS INT
+    NOT DETERMINISTIC
+BEGIN
+    INSERT INTO game_team_scores (team_id, hide_points, find_points, extras_points, penalty_points) VALUES(team_idIn, 0, find_pointsIn, extras_pointsIn, penalty_pointsIn)
+        ON DUPLICATE KEY UPDATE find_points = find_points + find_pointsIn, extras_points = extras_points + extras_pointsIn, penalty_points = penalty_points + penalty_pointsIn;
+    RETURN 0;
+END$$
+DELIMITER ;
+
 /**
  * changeStatus This sets the status for a given file
  */
@@ -195,6 +209,7 @@ BEGIN
         END IF;
     END LOOP createLoop;
 
+    SET dummy = increment_data_version('scoring_rules');
     RETURN 0;
 END$$
 DELIMITER ;
@@ -211,6 +226,7 @@ BEGIN
     SET dummy = log_user_event(userIP, usernameIn, CONCAT("Tables caches and user_hidden_caches were cleared"));
     DELETE FROM caches;
     DELETE FROM user_hidden_caches;
+    SET dummy = increment_data_version('scoring_rules');
     RETURN 0;
 END$$
 DELIMITER ;
@@ -260,6 +276,7 @@ BEGIN
     DELETE FROM game_teams;
     DELETE FROM game_find_list;
     UPDATE cache_handout SET team_id = -1;
+    SET dummy = increment_data_version('scoring_rules');
     RETURN 0;
 END$$
 DELIMITER ;
@@ -313,6 +330,7 @@ BEGIN
     DECLARE dummy INT;
     DELETE FROM caches WHERE cache_number = id_number;
     SET dummy = log_user_event(userIP, username, CONCAT("Cache number ",  id_number, " deleted"));
+    SET dummy = increment_data_version('scoring_rules');
     RETURN 0;
 END$$
 DELIMITER ;
@@ -340,8 +358,10 @@ DELIMITER $$
 CREATE FUNCTION deleteFindPointsExtrasItem(idIn INT, userIP VARCHAR(50), username VARCHAR(50)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
     IF (EXISTS(SELECT * FROM game_find_points_extras WHERE id = idIn)) THEN
         DELETE FROM game_find_points_extras WHERE id = idIn;
+        SET dummy = increment_data_version('scoring_rules');
         RETURN 0;
     END IF;
     RETURN 1;
@@ -414,6 +434,19 @@ BEGIN
 END$$
 DELIMITER ;
 
+/**
+ * increment_data_version This increases the version number of some cached data, so processes holding a copy of it know to reload it
+ */
+DROP FUNCTION IF EXISTS increment_data_version;
+DELIMITER $$
+CREATE FUNCTION increment_data_version(nameIn VARCHAR(100)) RETURNS INT
+    NOT DETERMINISTIC
+BEGIN
+	INSERT INTO data_versions (name, version) VALUES(nameIn, 1) ON DUPLICATE KEY UPDATE version = version + 1;
+	RETURN 0;
+END$$
+DELIMITER ;
+
 /**
  * insertCamping This adds an entry to the camping table
  */
@@ -673,10 +706,12 @@ BEGIN
     IF (EXISTS(SELECT * FROM caches WHERE cache_number = cache_numberIn)) THEN
         UPDATE caches SET cache_name = cache_nameIn, team_name = team_nameIn, latitude = lat, longitude = lon, public_hint = public_hintIn, detailed_hint = detailed_hintIn, camo = camoIn, permanent = permanentIn, private_property = private_propertyIn, zone_bonus = zone_bonusIn, osm_distance = osm_distanceIn, actual_distance = actual_distanceIn WHERE cache_number = cache_numberIn;
         SET dummy = log_user_event(userIP, username, CONCAT("Cache number ",  CONVERT(cache_numberIn, CHAR(50)), " was updated"));
+        SET dummy = increment_data_version('scoring_rules');
         RETURN cache_numberIn;
     ELSE
         INSERT INTO caches (cache_number, cache_name, team_name, latitude, longitude, public_hint, detailed_hint, camo, permanent, private_property, zone_bonus, osm_distance, actual_distance) VALUES(cache_numberIn, cache_nameIn, team_nameIn, lat, lon, public_hintIn, detailed_hintIn, camoIn, permanentIn, private_propertyIn, zone_bonusIn, osm_distanceIn, actual_distanceIn);
         SET dummy = log_user_event(userIP, username, CONCAT("Cache number ",  CONVERT(cache_numberIn, CHAR(50)), " was created"));
+        SET dummy = increment_data_version('scoring_rules');
         RETURN 0;
     END IF;
 END$$
@@ -751,8 +786,10 @@ DELIMITER $$
 CREATE FUNCTION setFindPointsExtrasEnabled(idIn INT, enabledIn INT, userIP VARCHAR(50), username VARCHAR(50)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
     IF (EXISTS(SELECT * FROM game_find_points_extras WHERE id = idIn)) THEN
         UPDATE game_find_points_extras SET enabled = enabledIn WHERE id = idIn;
+        SET dummy = increment_data_version('scoring_rules');
         RETURN 0;
     END IF;
     RETURN 1;
@@ -815,8 +852,10 @@ DELIMITER $$
 CREATE FUNCTION setFindPointsExtrasPoints(idIn INT, point_valueIn INT, userIP VARCHAR(50), username VARCHAR(50)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
     IF (EXISTS(SELECT * FROM game_find_points_extras WHERE id = idIn)) THEN
         UPDATE game_find_points_extras SET point_value = point_valueIn WHERE id = idIn;
+        SET dummy = increment_data_version('scoring_rules');
         RETURN 0;
     END IF;
     RETURN 1;
@@ -847,8 +886,10 @@ DELIMITER $$
 CREATE FUNCTION setFindPointsTradsConfig(idIn INT, configIn TEXT, userIP VARCHAR(50), username VARCHAR(50)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
     IF (EXISTS(SELECT * FROM game_find_points_trads WHERE id = idIn)) THEN
         UPDATE game_find_points_trads SET config = configIn WHERE id = idIn;
+        SET dummy = increment_data_version('scoring_rules');
         RETURN 0;
     END IF;
     RETURN 1;
@@ -863,8 +904,10 @@ DELIMITER $$
 CREATE FUNCTION setFindPointsTradsEnabled(idIn INT, enabledIn INT, userIP VARCHAR(50), username VARCHAR(50)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
     IF (EXISTS(SELECT * FROM game_find_points_trads WHERE id = idIn)) THEN
         UPDATE game_find_points_trads SET enabled = enabledIn WHERE id = idIn;
+        SET dummy = increment_data_version('scoring_rules');
         RETURN 0;
     END IF;
     RETURN 1;
@@ -879,8 +922,10 @@ DELIMITER $$
 CREATE FUNCTION setFindPointsTradsType(idIn INT, hide_or_findIn CHAR(1), userIP VARCHAR(50), username VARCHAR(50)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
     IF (EXISTS(SELECT * FROM game_find_points_trads WHERE id = idIn)) THEN
         UPDATE game_find_points_trads SET hide_or_find = hide_or_findIn WHERE id = idIn;
+        SET dummy = increment_data_version('scoring_rules');
         RETURN 0;
     END IF;
     RETURN 1;
@@ -908,7 +953,20 @@ DELIMITER $$
 CREATE FUNCTION setHandoutCacheReturned(cache_numberIn int, returnedIn VARCHAR(500), userIP VARCHAR(100), username VARCHAR(100)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
+    DECLARE old_returned INT;
+    DECLARE new_returned INT;
+    DECLARE team INT;
+    SET old_returned = (SELECT returned FROM cache_handout WHERE cache_number = cache_numberIn);
+    SET team = (SELECT team_id FROM cache_handout WHERE cache_number = cache_numberIn);
     UPDATE cache_handout SET returned = returnedIn WHERE cache_number = cache_numberIn;
+    SET new_returned = (SELECT returned FROM cache_handout WHERE cache_number = cache_numberIn);
+    -- Handouts that aren't given to a team have team_id = -1, they don't give anyone a penalty
+    IF (team > 0) THEN
+        -- The penalty must match CACHE_RETURN_PENALTY in PointCalculator.h
+        SET dummy = increment_data_version('scoring_finds');
+        SET dummy = add_team_score_delta(team, 0, 0, -2 * (IF(new_returned > 0, 0, 1) - IF(old_returned > 0, 0, 1)));
+    END IF;
     RETURN 0;
 END$$
 DELIMITER ;
@@ -921,8 +979,10 @@ DELIMITER $$
 CREATE FUNCTION setHandoutCacheTeam(cache_numberIn INT, teamIn INT, userIP VARCHAR(100), username VARCHAR(100)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
     IF (EXISTS(SELECT * FROM cache_handout WHERE cache_number = cache_numberIn)) THEN
         UPDATE cache_handout SET team_id = teamIn WHERE cache_number = cache_numberIn;
+        SET dummy = increment_data_version('scoring_rules');
         RETURN 0;
     END IF;
     RETURN 1;
@@ -1009,11 +1069,21 @@ DELIMITER $$
 CREATE FUNCTION setTeamFindExtra(team_idIn INT, extras_id_numberIn INT, find_valueIn INT, userIP VARCHAR(50), username VARCHAR(50)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
+    DECLARE old_value INT DEFAULT 0;
     IF (EXISTS(SELECT * FROM game_find_list WHERE team_id = team_idIn AND extras_id_number = extras_id_numberIn)) THEN
+        SET old_value = (SELECT find_value FROM game_find_list WHERE team_id = team_idIn AND extras_id_number = extras_id_numberIn LIMIT 1);
         UPDATE game_find_list SET find_value = find_valueIn WHERE team_id = team_idIn AND extras_id_number = extras_id_numberIn;
     ELSE
         INSERT INTO game_find_list (team_id, extras_id_number, find_value) VALUES(team_idIn, extras_id_numberIn, find_valueIn);
     END IF;
+    SET dummy = increment_data_version('scoring_finds');
+    IF (extras_id_numberIn = -1) THEN
+        -- Minutes late, the penalty must match MINUTES_LATE_PENALTY in PointCalculator.h
+        SET dummy = add_team_score_delta(team_idIn, 0, 0, -1 * (find_valueIn - old_value));
+    ELSE
+        SET dummy = add_team_score_delta(team_idIn, 0, (find_valueIn - old_value) * IFNULL((SELECT point_value FROM game_find_points_extras WHERE id = extras_id_numberIn AND enabled > 0), 0), 0);
+    END IF;
     RETURN 0;
 END$$
 DELIMITER ;
@@ -1026,11 +1096,46 @@ DELIMITER $$
 CREATE FUNCTION setTeamFindTrad(team_idIn INT, trad_cache_numberIn INT, find_valueIn INT, userIP VARCHAR(50), username VARCHAR(50)) RETURNS INT
     NOT DETERMINISTIC
 BEGIN
+    DECLARE dummy INT;
+    DECLARE old_value INT DEFAULT 0;
     IF (EXISTS(SELECT * FROM game_find_list WHERE team_id = team_idIn AND trad_cache_number = trad_cache_numberIn)) THEN
+        SET old_value = (SELECT find_value FROM game_find_list WHERE team_id = team_idIn AND trad_cache_number = trad_cache_numberIn LIMIT 1);
         UPDATE game_find_list SET find_value = find_valueIn WHERE team_id = team_idIn AND trad_cache_number = trad_cache_numberIn;
     ELSE
         INSERT INTO game_find_list (team_id, trad_cache_number, find_value) VALUES(team_idIn, trad_cache_numberIn, find_valueIn);
     END IF;
+    -- A found cache (any value other than 0) scores the find points of the cache
+    SET dummy = increment_data_version('scoring_finds');
+    SET dummy = add_team_score_delta(team_idIn, (IF(find_valueIn != 0, 1, 0) - IF(old_value != 0, 1, 0)) * IFNULL((SELECT find_points FROM game_cache_points WHERE cache_number = trad_cache_numberIn), 0), 0, 0);
+    RETURN 0;
+END$$
+DELIMITER ;
+
+/**
+ * setScoreTotals This replaces the saved score totals (game_team_scores and game_cache_points) after they have been recalculated by ScoreEngine
+ * The totals are only saved if no finds have changed since findsVersion, as they would be missing the change
+ */
+DROP FUNCTION IF EXISTS setScoreTotals;
+DELIMITER $$
+CREATE FUNCTION setScoreTotals(rulesVersion BIGINT UNSIGNED, varsVersion BIGINT UNSIGNED, findsVersion BIGINT UNSIGNED, teamsJson JSON, cachesJson JSON) RETURNS INT
+    NOT DETERMINISTIC
+BEGIN
+    DECLARE currentFindsVersion BIGINT UNSIGNED DEFAULT 0;
+    -- Locks the row, so the find functions wait until the new totals are saved before adding to them
+    SELECT version INTO currentFindsVersion FROM data_versions WHERE name = 'scoring_finds' FOR UPDATE;
+    IF (currentFindsVersion != findsVersion) THEN
+        RETURN 1;
+    END IF;
+
+    DELETE FROM game_team_scores;
+    INSERT INTO game_team_scores (team_id, hide_points, find_points, extras_points, penalty_points)
+        SELECT team_id, hide_points, find_points, extras_points, penalty_points FROM JSON_TABLE(teamsJson, '$[*]' COLUMNS(team_id INT PATH '$[0]', hide_points INT PATH '$[1]', find_points INT PATH '$[2]', extras_points INT PATH '$[3]', penalty_points INT PATH '$[4]')) AS scores;
+    DELETE FROM game_cache_points;
+    INSERT INTO game_cache_points (cache_number, hide_points, find_points)
+        SELECT cache_number, hide_points, find_points FROM JSON_TABLE(cachesJson, '$[*]' COLUMNS(cache_number INT PATH '$[0]', hide_points INT PATH '$[1]', find_points INT PATH '$[2]')) AS points;
+
+    INSERT INTO data_versions (name, version) VALUES('scoring_totals', rulesVersion) ON DUPLICATE KEY UPDATE version = rulesVersion;
+    INSERT INTO data_versions (name, version) VALUES('scoring_totals_vars', varsVersion) ON DUPLICATE KEY UPDATE version = varsVersion;
     RETURN 0;
 END$$
 DELIMITER ;
@@ -1199,6 +1304,7 @@ BEGIN
     IF (EXISTS(SELECT * FROM vars WHERE name = var_nameIn)) THEN
         IF ((SELECT editable FROM vars WHERE name = var_nameIn) != 0 OR ignoreEditable != 0) THEN
             UPDATE vars SET vars.value = var_valueIn WHERE vars.name = var_nameIn;
+            SET dummy = increment_data_version('vars');
             SET dummy = log_user_event(userIP, username, CONCAT("Variable ",  var_nameIn, " was updated to \"", var_valueIn, "\""));
             RETURN 0;
         END IF;
@@ -1346,3 +1452,35 @@ DELIMITER ;
 --
 -- End of Functions
 --
+
+--
+-- Triggers
+--
+
+/**
+ * The webpage_menu table has no SQL functions for editing it, so use triggers to keep its data version up to date
+ */
+DROP TRIGGER IF EXISTS webpage_menu_insert;
+DROP TRIGGER IF EXISTS webpage_menu_update;
+DROP TRIGGER IF EXISTS webpage_menu_delete;
+DELIMITER $$
+CREATE TRIGGER webpage_menu_insert AFTER INSERT ON webpage_menu FOR EACH ROW
+BEGIN
+    DECLARE dummy INT;
+    SET dummy = increment_data_version('webpage_menu');
+END$$
+CREATE TRIGGER webpage_menu_update AFTER UPDATE ON webpage_menu FOR EACH ROW
+BEGIN
+    DECLARE dummy INT;
+    SET dummy = increment_data_version('webpage_menu');
+END$$
+CREATE TRIGGER webpage_menu_delete AFTER DELETE ON webpage_menu FOR EACH ROW
+BEGIN
+    DECLARE dummy INT;
+    SET dummy = increment_data_version('webpage_menu');
+END$$
+DELIMITER ;
+
+--
+-- End of Triggers
+--
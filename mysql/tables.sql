@@ -187,6 +187,25 @@ CREATE TABLE `csp_reports` (
   UNIQUE KEY `id_UNIQUE` (`id`)
 ) ENGINE=InnoDB AUTO_INCREMENT=1 DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_0900_ai_ci;
 
+--
+-- Table structure for table `data_versions`
+--
+
+DROP TABLE IF EXISTS `data_versions`;
+CREATE TABLE `data_versions` (
+  `name` varchar(100) NOT NULL,
+  `version` bigint unsigned NOT NULL DEFAULT '0',
+  PRIMARY KEY (`name`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_0900_ai_ci;
+
+--
+-- Dumping data for table `data_versions`
+--
+
+LOCK TABLES `data_versions` WRITE;
+INSERT INTO `data_versions` VALUES ('scoring_finds',0),('scoring_rules',0),('vars',0),('webpage_menu',0);
+UNLOCK TABLES;
+
 --
 -- Table structure for table `dinner_forms`
 --
@@ -348,6 +367,18 @@ CREATE TABLE `files` (
   UNIQUE KEY `filename_UNIQUE` (`filename`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_0900_ai_ci;
 
+--
+-- Table structure for table `game_cache_points`
+--
+
+DROP TABLE IF EXISTS `game_cache_points`;
+CREATE TABLE `game_cache_points` (
+  `cache_number` int NOT NULL,
+  `hide_points` int NOT NULL DEFAULT '0',
+  `find_points` int NOT NULL DEFAULT '0',
+  PRIMARY KEY (`cache_number`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_0900_ai_ci;
+
 --
 -- Table structure for table `game_find_list`
 --
@@ -405,6 +436,20 @@ INSERT INTO `game_find_points_trads` VALUES
     (5, 'Cache spacing points', 0, 'H', '{\"distance\":500,\"max_points\":2}');
 UNLOCK TABLES;
 
+--
+-- Table structure for table `game_team_scores`
+--
+
+DROP TABLE IF EXISTS `game_team_scores`;
+CREATE TABLE `game_team_scores` (
+  `team_id` int NOT NULL,
+  `hide_points` int NOT NULL DEFAULT '0',
+  `find_points` int NOT NULL DEFAULT '0',
+  `extras_points` int NOT NULL DEFAULT '0',
+  `penalty_points` int NOT NULL DEFAULT '0',
+  PRIMARY KEY (`team_id`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_0900_ai_ci;
+
 --
 -- Table structure for table `game_teams`
 --
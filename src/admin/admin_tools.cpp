@@ -19,8 +19,9 @@
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
+#include "../core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -175,3 +176,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
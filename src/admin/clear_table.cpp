@@ -21,10 +21,11 @@
 #include "../core/JlweUtils.h"
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -71,6 +72,7 @@ int main () {
                     }
                     delete res;
                     delete prep_stmt;
+                    jlwe.invalidateGlobalVars();
 
                     if (error == false) {
                         prep_stmt = jlwe.getMysqlCon()->prepareStatement("SELECT clearCacheHandoutList(?,?,?);");
@@ -178,3 +180,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -17,6 +17,7 @@
 #include "core/HtmlTemplate.h"
 #include "core/JlweCore.h"
 #include "core/JlweUtils.h"
+#include "core/RequestLoop.h"
 #include "ext/md4c/md4c-html.h"
 
 #define SOURCE_CODE_URL "https://github.com/laighside/SAGeocachingJuneLWE"
@@ -28,7 +29,7 @@ static void md4c_process_output(const MD_CHAR* text, MD_SIZE size, void* userdat
     *str_out += std::string(text, size);
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -94,3 +95,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
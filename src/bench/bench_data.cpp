@@ -0,0 +1,254 @@
+/**
+  @file    bench_data.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Writes SQL that fills a new JLWE database (made from tables.sql and functions.sql) with made up data for benchmarking
+  This includes game teams, caches, finds, event/camping/dinner registrations, payments and files
+  The same seed always gives the same data, so results from different commits can be compared
+  An access token for the admin user is added, so pages that need a login can be benchmarked with the cookie
+  accessToken=bench-admin-token
+
+  Usage: bench_data [--teams N] [--caches N] [--registrations N] [--files N] [--files-dir DIR] [--seed N] | mysql <database>
+  If --files-dir is given, the files are also created in that directory (it should be the files directory from the config file)
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Rows per INSERT statement
+#define INSERT_BATCH_SIZE 500
+
+// Centre of the made up playing field (Adelaide Hills)
+#define FIELD_LATITUDE -34.95
+#define FIELD_LONGITUDE 138.75
+
+// Writes multi-row INSERT statements for one table
+// Each statement is built up in memory and written in one go, so writers for different tables can be used at the same time
+class InsertWriter {
+public:
+    InsertWriter(const std::string &table, const std::string &columns) {
+        this->table = table;
+        this->columns = columns;
+        this->rows = 0;
+    }
+
+    ~InsertWriter() {
+        this->flush();
+    }
+
+    void add(const std::string &values) {
+        this->sql += (this->rows ? ",\n  (" : "INSERT INTO `" + this->table + "` (" + this->columns + ") VALUES\n  (") + values + ")";
+        if (++this->rows == INSERT_BATCH_SIZE)
+            this->flush();
+    }
+
+    void flush() {
+        if (this->rows)
+            std::cout << this->sql << ";\n";
+        this->sql.clear();
+        this->rows = 0;
+    }
+
+private:
+    std::string table;
+    std::string columns;
+    std::string sql;
+    unsigned int rows;
+};
+
+static std::string quote(const std::string &text) {
+    return "'" + text + "'";
+}
+
+static std::string toString(double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.6f", value);
+    return buffer;
+}
+
+int main(int argc, char *argv[]) {
+    int teams = 40;
+    int caches = 300;
+    int registrations = 200;
+    int files = 100;
+    std::string filesDir;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Usage: bench_data [--teams N] [--caches N] [--registrations N] [--files N] [--files-dir DIR] [--seed N]" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::string value = argv[++i];
+        if (arg == "--teams") {
+            teams = std::max(1, atoi(value.c_str()));
+        } else if (arg == "--caches") {
+            caches = std::max(1, atoi(value.c_str()));
+        } else if (arg == "--registrations") {
+            registrations = std::max(0, atoi(value.c_str()));
+        } else if (arg == "--files") {
+            files = std::max(0, atoi(value.c_str()));
+        } else if (arg == "--files-dir") {
+            filesDir = value;
+        } else if (arg == "--seed") {
+            seed = static_cast<unsigned int>(strtoul(value.c_str(), nullptr, 10));
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::mt19937 random(seed);
+    auto chance = [&random](double probability) {
+        return std::uniform_real_distribution<double>(0, 1)(random) < probability;
+    };
+    auto between = [&random](int min, int max) {
+        return std::uniform_int_distribution<int>(min, max)(random);
+    };
+    auto offset = [&random](double range) {
+        return std::uniform_real_distribution<double>(-range, range)(random);
+    };
+
+    std::cout << "-- Made up data for benchmarking, seed " << seed << "\n";
+    std::cout << "SET autocommit = 0;\n";
+
+    // Settings
+    std::cout << "UPDATE `vars` SET `value` = '" << caches << "' WHERE `name` = 'number_game_caches';\n";
+    std::cout << "UPDATE `vars` SET `value` = '1' WHERE `name` IN ('registration_enabled', 'public_results_enabled');\n";
+    std::cout << "UPDATE `vars` SET `value` = 'BM' WHERE `name` = 'gpx_code_prefix';\n";
+    std::cout << "INSERT INTO `user_tokens` VALUES ('bench-admin-token', 'admin', '127.0.0.1', '2099-12-31 00:00:00');\n";
+    std::cout << "UPDATE `game_find_points_trads` SET `enabled` = 1;\n";
+
+    // Teams
+    {
+        InsertWriter writer("game_teams", "team_id, team_name, team_members, competing");
+        for (int t = 1; t <= teams; t++)
+            writer.add(std::to_string(t) + ", " + quote("Team " + std::to_string(t)) + ", " + quote("Member A, Member B") + ", " + (chance(0.9) ? "1" : "0"));
+    }
+
+    // Caches, most are handed out and returned, a few are missing coordinates
+    {
+        InsertWriter handout("cache_handout", "cache_number, owner_name, returned, team_id");
+        InsertWriter details("caches", "cache_number, cache_name, team_name, latitude, longitude, public_hint, detailed_hint, camo, permanent, private_property, zone_bonus, osm_distance, actual_distance");
+        for (int c = 1; c <= caches; c++) {
+            int team = between(1, teams);
+            bool handedOut = chance(0.95);
+            handout.add(std::to_string(c) + ", " + quote(handedOut ? "Team " + std::to_string(team) : "") + ", " + (handedOut && chance(0.85) ? "1" : "0") + ", " + (handedOut ? std::to_string(team) : "-1"));
+            if (handedOut && chance(0.97)) {
+                details.add(std::to_string(c) + ", " + quote("Cache " + std::to_string(c)) + ", " + quote("Team " + std::to_string(team)) + ", " +
+                            toString(FIELD_LATITUDE + offset(0.08)) + ", " + toString(FIELD_LONGITUDE + offset(0.1)) + ", " +
+                            quote("Hint for cache " + std::to_string(c)) + ", " + quote("At the base of the tree") + ", " +
+                            (chance(0.1) ? "1" : "0") + ", 0, " + (chance(0.05) ? "1" : "0") + ", " + std::to_string(between(0, 2)) + ", " +
+                            std::to_string(between(0, 800)) + ", " + (chance(0.3) ? std::to_string(between(0, 800)) : "-1"));
+            }
+        }
+    }
+
+    // Extra find items
+    const int extrasCount = 6;
+    {
+        InsertWriter writer("game_find_points_extras", "id, short_name, long_name, point_value, enabled, single_find_only, extras_type");
+        const char *types = "OOOPOO";
+        for (int x = 1; x <= extrasCount; x++)
+            writer.add(std::to_string(x) + ", " + quote("Extra " + std::to_string(x)) + ", " + quote("Extra item number " + std::to_string(x)) + ", " +
+                       std::to_string(between(1, 10)) + ", 1, " + (x == 1 ? "1" : "0") + ", " + quote(std::string(1, types[x - 1])));
+    }
+
+    // Finds, each team finds most of the caches
+    {
+        InsertWriter writer("game_find_list", "team_id, trad_cache_number, extras_id_number, find_value");
+        for (int t = 1; t <= teams; t++) {
+            double findRate = std::uniform_real_distribution<double>(0.3, 0.9)(random);
+            for (int c = 1; c <= caches; c++) {
+                if (chance(findRate))
+                    writer.add(std::to_string(t) + ", " + std::to_string(c) + ", NULL, 1");
+            }
+            for (int x = 1; x <= extrasCount; x++) {
+                if (chance(0.5))
+                    writer.add(std::to_string(t) + ", NULL, " + std::to_string(x) + ", " + std::to_string(between(1, 3)));
+            }
+        }
+    }
+
+    // Registrations, camping, dinner and payments
+    {
+        InsertWriter event("event_registrations", "ip_address, timestamp, idempotency, email_address, gc_username, phone_number, livemode, real_names_adults, real_names_children, number_adults, number_children, past_jlwe, have_lanyard, camping, dinner, payment_type, stripe_session_id, status");
+        InsertWriter camping("camping", "ip_address, timestamp, idempotency, email_address, gc_username, phone_number, livemode, number_people, camping_type, arrive_date, leave_date, camping_comment, payment_type, stripe_session_id, status");
+        InsertWriter dinner("sat_dinner", "ip_address, timestamp, idempotency, email_address, gc_username, phone_number, dinner_form_id, livemode, number_adults, number_children, dinner_comment, payment_type, stripe_session_id, status, dinner_options_adults, dinner_options_children");
+        InsertWriter payments("payment_log", "user_key, timestamp, amount_received, payment_type, source_user");
+        InsertWriter stripe("stripe_event_log", "id, timestamp, livemode, type, api_version, payment_intent, cs_id, amount, amount_received, message");
+        InsertWriter fees("stripe_card_fees", "idempotency, fee");
+
+        for (int r = 1; r <= registrations; r++) {
+            std::string n = std::to_string(r);
+            std::string key = "bench-rego-" + n;
+            std::string username = "cacher" + n;
+            std::string email = quote(username + "@example.com");
+            std::string paymentType = chance(0.5) ? "card" : (chance(0.5) ? "bank" : "cash");
+            std::string sessionId = (paymentType == "card") ? quote("cs_bench_" + n) : "NULL";
+            int adults = between(1, 4);
+            int children = between(0, 3);
+            bool hasCamping = chance(0.4);
+            bool hasDinner = chance(0.5);
+
+            event.add("'127.0.0.1', NOW(), " + quote(key) + ", " + email + ", " + quote(username) + ", '0400000000', 1, " +
+                      quote("Adult names " + n) + ", " + quote(children ? "Child names " + n : "") + ", " + std::to_string(adults) + ", " + std::to_string(children) + ", " +
+                      (chance(0.6) ? "1" : "0") + ", " + (chance(0.5) ? "1" : "0") + ", " + quote(hasCamping ? "yes" : "no") + ", " + quote(hasDinner ? "yes" : "no") + ", " +
+                      quote(paymentType) + ", " + sessionId + ", 'S'");
+            if (hasCamping) {
+                int arrive = between(8, 10);
+                camping.add("'127.0.0.1', NOW(), " + quote(key) + ", " + email + ", " + quote(username) + ", '0400000000', 1, " + std::to_string(adults + children) + ", " +
+                            quote(chance(0.7) ? "unpowered" : "powered") + ", " + std::to_string(arrive) + ", " + std::to_string(arrive + between(1, 3)) + ", '', 'event', NULL, 'S'");
+            }
+            if (hasDinner) {
+                dinner.add("'127.0.0.1', NOW(), " + quote(key) + ", " + email + ", " + quote(username) + ", '0400000000', 1, 1, " + std::to_string(adults) + ", " + std::to_string(children) + ", '', 'event', NULL, 'S', '{}', '{}'");
+            }
+
+            int cost = adults * 2000 + (hasCamping ? 1500 : 0) + (hasDinner ? adults * 2500 : 0);
+            if (paymentType == "card") {
+                if (chance(0.9)) {
+                    std::string intent = quote("pi_bench_" + n);
+                    stripe.add(quote("evt_bench_cs_" + n) + ", 1700000000, 1, 'checkout.session.completed', '2020-08-27', " + intent + ", " + sessionId + ", " + std::to_string(cost) + ", 0, NULL");
+                    stripe.add(quote("evt_bench_pi_" + n) + ", 1700000000, 1, 'payment_intent.succeeded', '2020-08-27', " + intent + ", NULL, " + std::to_string(cost) + ", " + std::to_string(cost) + ", NULL");
+                    fees.add(quote(key) + ", " + std::to_string(cost / 50));
+                }
+            } else if (chance(0.7)) {
+                payments.add(quote(key) + ", 1700000000, " + std::to_string(chance(0.8) ? cost : cost / 2) + ", " + quote(paymentType) + ", 1");
+            }
+        }
+    }
+
+    // Files in the file manager
+    {
+        InsertWriter writer("files", "filename, directory, size, owner, year, public");
+        for (int f = 1; f <= files; f++) {
+            std::string filename = "bench_file_" + std::to_string(f) + ".pdf";
+            int size = between(1024, 4 * 1048576);
+            writer.add(quote(filename) + ", '/', " + std::to_string(size) + ", 'admin', " + std::to_string(between(2017, 2024)) + ", " + (chance(0.8) ? "1" : "0"));
+
+            if (filesDir.size()) {
+                FILE *file = fopen((filesDir + "/" + filename).c_str(), "wb");
+                if (!file) {
+                    std::cerr << "Unable to create " << filesDir << "/" << filename << std::endl;
+                    return EXIT_FAILURE;
+                }
+                std::string block(65536, 'x');
+                for (int written = 0; written < size; written += static_cast<int>(block.size()))
+                    fwrite(block.data(), 1, std::min(block.size(), static_cast<size_t>(size - written)), file);
+                fclose(file);
+            }
+        }
+    }
+
+    std::cout << "COMMIT;\n";
+    return EXIT_SUCCESS;
+}
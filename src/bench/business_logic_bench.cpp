@@ -0,0 +1,205 @@
+/**
+  @file    business_logic_bench.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Microbenchmarks for the scoring and payment code, run against the in-memory data sets so no MySQL server is needed
+  The data sets are generated (with a fixed seed) as JSON fixtures and loaded with MemoryScoringData/MemoryRegistrationData
+  Teams, caches and registrations are scaled into the thousands to show how each function grows with the event size
+
+  Uses Google Benchmark, so the usual options work, eg. --benchmark_filter=PointCalculator
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../core/MemoryRegistrationData.h"
+#include "../core/PaymentUtils.h"
+#include "../scoring/MemoryScoringData.h"
+#include "../scoring/PointCalculator.h"
+
+#include "../ext/nlohmann/json.hpp"
+
+// Same seed every run, so the results can be compared between builds
+#define FIXTURE_SEED 1234
+
+/*
+ * Fixture generators
+ */
+
+// A game with the usual five point sources, caches spread over about 20km around Adelaide,
+// each team finding about a third of the caches and a few of the extras items (if withFinds is true)
+static nlohmann::json makeScoringFixture(int teams, int caches, bool withFinds = true) {
+    std::mt19937 rng(FIXTURE_SEED);
+    std::uniform_real_distribution<double> offset(-0.1, 0.1);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    nlohmann::json fixture;
+    fixture["pointSources"] = {
+        {{"id", 1}, {"name", "Find points"}, {"hide_or_find", "F"}},
+        {{"id", 2}, {"name", "Walking points"}, {"hide_or_find", "H"}, {"config", {{"distance", 100}, {"max_points", 5}}}},
+        {{"id", 3}, {"name", "Zone points"}, {"hide_or_find", "H"}},
+        {{"id", 4}, {"name", "Creative points"}, {"hide_or_find", "H"}, {"config", {{"points", 2}}}},
+        {{"id", 5}, {"name", "Spacing points"}, {"hide_or_find", "H"}, {"config", {{"distance", 200}, {"max_points", 5}}}}
+    };
+
+    const int extras_count = 20;
+    fixture["extrasItems"] = nlohmann::json::array();
+    for (int i = 1; i <= extras_count; i++)
+        fixture["extrasItems"].push_back({{"id", i}, {"short_name", "P" + std::to_string(i)}, {"long_name", "Puzzle " + std::to_string(i)},
+                                          {"single_find_only", true}, {"type", "P"}, {"points_value", 5}});
+
+    fixture["caches"] = nlohmann::json::array();
+    for (int i = 1; i <= caches; i++)
+        fixture["caches"].push_back({{"cache_number", i}, {"team_id", (i % teams) + 1}, {"cache_name", "Cache " + std::to_string(i)},
+                                     {"latitude", -34.93 + offset(rng)}, {"longitude", 138.6 + offset(rng)},
+                                     {"zone_points", percent(rng) < 10 ? 3 : 0}, {"walking_distance", percent(rng) * 10},
+                                     {"creative", percent(rng) < 20}, {"returned", percent(rng) < 95}});
+
+    fixture["tradFinds"] = nlohmann::json::array();
+    fixture["extrasFinds"] = nlohmann::json::array();
+    for (int team = 1; team <= teams && withFinds; team++) {
+        for (int i = 1; i <= caches; i++)
+            if (percent(rng) < 33)
+                fixture["tradFinds"].push_back({{"team_id", team}, {"cache_number", i}, {"value", 1}});
+        for (int i = 1; i <= extras_count; i++)
+            if (percent(rng) < 25)
+                fixture["extrasFinds"].push_back({{"team_id", team}, {"id", i}, {"value", 1}});
+        fixture["extrasFinds"].push_back({{"team_id", team}, {"id", -1}, {"value", percent(rng) < 10 ? 5 : 0}}); // minutes late
+    }
+
+    return fixture;
+}
+
+// Registrations where everyone is going to the event, some are camping and/or going to the dinner,
+// and most have made one to three payments
+static nlohmann::json makeRegistrationFixture(int registrations) {
+    std::mt19937 rng(FIXTURE_SEED);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> small(1, 4);
+
+    const int menu_items = 12;
+    nlohmann::json fixture;
+    fixture["menus"]["1"] = nlohmann::json::array();
+    for (int i = 1; i <= menu_items; i++)
+        fixture["menus"]["1"].push_back({{"id", i}, {"name", "Item " + std::to_string(i)}, {"name_plural", "Items " + std::to_string(i)}, {"price", 1000 + i * 150}});
+
+    fixture["users"] = nlohmann::json::array();
+    for (int i = 0; i < registrations; i++) {
+        nlohmann::json user = {{"key", "bench-user-" + std::to_string(i)}, {"event", {{"adults", small(rng)}, {"children", small(rng) - 1}}}};
+
+        if (percent(rng) < 30)
+            user["camping"] = {{"price_code", percent(rng) < 50 ? "powered" : "unpowered"}, {"people", small(rng)}, {"nights", small(rng)}};
+
+        if (percent(rng) < 40) {
+            nlohmann::json meals = nlohmann::json::array();
+            int people = small(rng);
+            for (int j = 0; j < people; j++)
+                meals.push_back({{"name", "Person " + std::to_string(j)}, {"courses", {(j % menu_items) + 1, ((j + 5) % menu_items) + 1}}});
+            user["dinner"] = {{{"form_id", 1}, {"order", {{"categories", {{"adults", meals}}}}}}};
+        }
+
+        if (percent(rng) < 10)
+            user["merch_cost"] = 2500;
+
+        user["payments"] = nlohmann::json::array();
+        int payments = percent(rng) < 85 ? small(rng) % 3 + 1 : 0;
+        for (int j = 0; j < payments; j++)
+            user["payments"].push_back({{"id", std::to_string(i) + "-" + std::to_string(j)}, {"timestamp", 1700000000 + i}, {"amount", 2000}, {"type", j ? "card" : "bank"}});
+
+        fixture["users"].push_back(user);
+    }
+
+    return fixture;
+}
+
+/*
+ * Scoring benchmarks
+ */
+
+// Building the PointCalculator works out the points for every cache (the spacing points compare every pair of caches)
+static void BM_PointCalculatorConstruct(benchmark::State &state) {
+    int caches = static_cast<int>(state.range(0));
+    MemoryScoringData data;
+    data.loadFixture(makeScoringFixture(50, caches));
+
+    for (auto _ : state) {
+        PointCalculator pointCalculator(&data, caches);
+        benchmark::DoNotOptimize(pointCalculator.getCacheList()->data());
+    }
+    state.SetItemsProcessed(state.iterations() * caches);
+}
+BENCHMARK(BM_PointCalculatorConstruct)->Arg(100)->Arg(500)->Arg(1000)->Arg(2000)->Arg(5000)->Unit(benchmark::kMillisecond);
+
+// Only the spacing points (nearest cache hidden by the same team), with 50 teams and up to 20000 caches
+static void BM_SpacingPoints(benchmark::State &state) {
+    int caches = static_cast<int>(state.range(0));
+    nlohmann::json fixture = makeScoringFixture(50, caches, false);
+    fixture["pointSources"] = {fixture["pointSources"].back()};
+    MemoryScoringData data;
+    data.loadFixture(fixture);
+
+    for (auto _ : state) {
+        PointCalculator pointCalculator(&data, caches);
+        benchmark::DoNotOptimize(pointCalculator.getPointSourceList()->data());
+    }
+    state.SetItemsProcessed(state.iterations() * caches);
+}
+BENCHMARK(BM_SpacingPoints)->Arg(1000)->Arg(5000)->Arg(10000)->Arg(20000)->Unit(benchmark::kMillisecond);
+
+// The score for every team, the same work as the scoreboard (get_scores.cgi) does
+static void BM_TeamScores(benchmark::State &state) {
+    int teams = static_cast<int>(state.range(0));
+    int caches = static_cast<int>(state.range(1));
+    MemoryScoringData data;
+    data.loadFixture(makeScoringFixture(teams, caches));
+    PointCalculator pointCalculator(&data, caches);
+
+    for (auto _ : state) {
+        long long total = 0;
+        for (int team = 1; team <= teams; team++) {
+            const std::vector<int> &trad_finds = pointCalculator.getTeamTradFindList(team);
+            const std::vector<PointCalculator::ExtrasFind> &extras_finds = pointCalculator.getTeamExtrasFindList(team);
+            total += pointCalculator.getTeamHideScore(team);
+            total += pointCalculator.getTotalTradFindScore(trad_finds);
+            total += pointCalculator.getTotalExtrasFindScore(extras_finds);
+            total += pointCalculator.getCachesNotReturned(team) * CACHE_RETURN_PENALTY;
+            total += PointCalculator::getMinutesLate(extras_finds) * MINUTES_LATE_PENALTY;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * teams);
+}
+BENCHMARK(BM_TeamScores)->Args({10, 100})->Args({50, 500})->Args({100, 1000})->Args({500, 2000})->Args({1000, 5000})->Unit(benchmark::kMillisecond);
+
+/*
+ * Payment benchmarks
+ */
+
+// Cost and payments received for every registration, the same work as the registrations spreadsheet does
+static void BM_RegistrationTotals(benchmark::State &state) {
+    int registrations = static_cast<int>(state.range(0));
+    MemoryRegistrationData data;
+    data.loadFixture(makeRegistrationFixture(registrations));
+
+    std::vector<std::string> userKeys;
+    for (int i = 0; i < registrations; i++)
+        userKeys.push_back("bench-user-" + std::to_string(i));
+
+    for (auto _ : state) {
+        long long owing = 0;
+        for (const std::string &userKey : userKeys)
+            owing += PaymentUtils::getUserCost(&data, userKey) - PaymentUtils::getTotalPaymentReceived(&data, userKey);
+        benchmark::DoNotOptimize(owing);
+    }
+    state.SetItemsProcessed(state.iterations() * registrations);
+}
+BENCHMARK(BM_RegistrationTotals)->Arg(100)->Arg(500)->Arg(1000)->Arg(5000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,494 @@
+/**
+  @file    cgi_replay.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Replays recorded requests against the built CGI scripts and measures them, without needing a web server
+  Each request in the scenario file is run many times (optionally several at once), each run is a new process
+  with the recorded CGI environment variables and request body, just like Apache would start it
+  The results (latency percentiles, peak memory, CPU time and syscall counts) are written as JSON so they can be
+  compared between commits, use --baseline to print the change from a previous results file
+
+  Usage: cgi_replay <scenario.json> [-o results.json] [--baseline old_results.json]
+  See replay_sample.json for the scenario format
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <signal.h>
+#include <sstream>
+#include <string>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../ext/nlohmann/json.hpp"
+
+// Temporary files for the request bodies
+#define BODY_FILE_TEMPLATE "/tmp/jlwe_replay_body.XXXXXX"
+
+struct Endpoint {
+    std::string name;
+    std::string script;     // full path to the .cgi
+    std::string directory;  // working directory for the script (the directory it is in, like Apache)
+    std::string bodyFile;   // empty if there is no body
+    std::vector<std::string> environment;
+    int iterations;
+};
+
+struct RunResult {
+    double milliseconds;
+    long maxRssKb;
+    double userMilliseconds;
+    double systemMilliseconds;
+    size_t responseBytes;
+    int httpStatus;
+    bool failed;
+};
+
+static std::string readFile(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Unable to read " + filename);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+static std::string directoryOf(const std::string &filename) {
+    size_t slash = filename.find_last_of('/');
+    if (slash == std::string::npos)
+        return ".";
+    return filename.substr(0, slash);
+}
+
+static std::string resolvePath(const std::string &base, const std::string &path) {
+    if (path.empty() || path.at(0) == '/')
+        return path;
+    return base + "/" + path;
+}
+
+// Reads a file of KEY=VALUE lines, like the output of the env command
+static void readEnvironmentFile(const std::string &filename, std::map<std::string, std::string> *environment) {
+    std::istringstream lines(readFile(filename));
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t equals = line.find('=');
+        if (equals == std::string::npos || equals == 0)
+            continue;
+        (*environment)[line.substr(0, equals)] = line.substr(equals + 1);
+    }
+}
+
+static void addEnvironment(const nlohmann::json &object, std::map<std::string, std::string> *environment) {
+    for (auto it = object.begin(); it != object.end(); ++it)
+        (*environment)[it.key()] = it.value().is_string() ? it.value().get<std::string>() : it.value().dump();
+}
+
+// Gets the status code from the Status header of a CGI response, or 200 if there isn't one
+static int getHttpStatus(const std::string &output) {
+    size_t headerEnd = output.find("\r\n\r\n");
+    if (headerEnd == std::string::npos)
+        headerEnd = output.find("\n\n");
+    if (headerEnd == std::string::npos)
+        return 0; // no headers, the script didn't finish properly
+    size_t pos = 0;
+    while (pos < headerEnd) {
+        size_t lineEnd = output.find('\n', pos);
+        if (strncasecmp(output.c_str() + pos, "Status:", 7) == 0)
+            return atoi(output.c_str() + pos + 7);
+        if (lineEnd == std::string::npos)
+            break;
+        pos = lineEnd + 1;
+    }
+    return 200;
+}
+
+// Starts the script as a child process, only async-signal-safe calls are made after the fork
+static pid_t startScript(const Endpoint &endpoint, char *const *argv, char *const *envp, int stdoutFd, bool trace) {
+    pid_t pid = fork();
+    if (pid != 0)
+        return pid;
+
+    int stdinFd = open(endpoint.bodyFile.size() ? endpoint.bodyFile.c_str() : "/dev/null", O_RDONLY);
+    int nullFd = open("/dev/null", O_WRONLY);
+    if (stdinFd < 0 || nullFd < 0)
+        _exit(126);
+    dup2(stdinFd, STDIN_FILENO);
+    dup2(stdoutFd >= 0 ? stdoutFd : nullFd, STDOUT_FILENO);
+    dup2(nullFd, STDERR_FILENO);
+    if (stdinFd > STDERR_FILENO)
+        close(stdinFd);
+    if (nullFd > STDERR_FILENO)
+        close(nullFd);
+    if (chdir(endpoint.directory.c_str()) != 0)
+        _exit(126);
+
+    if (trace) {
+        ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+        raise(SIGSTOP);
+    }
+    execve(argv[0], argv, envp);
+    _exit(127);
+}
+
+// Runs the script once, reading everything it writes to stdout
+static RunResult runOnce(const Endpoint &endpoint, char *const *argv, char *const *envp) {
+    RunResult result = {};
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC) != 0)
+        throw std::runtime_error("Unable to create pipe");
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = startScript(endpoint, argv, envp, pipeFds[1], false);
+    close(pipeFds[1]);
+    if (pid < 0) {
+        close(pipeFds[0]);
+        throw std::runtime_error("Unable to fork");
+    }
+
+    std::string output;
+    char buffer[65536];
+    while (true) {
+        ssize_t size = read(pipeFds[0], buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size <= 0)
+            break;
+        output.append(buffer, static_cast<size_t>(size));
+    }
+    close(pipeFds[0]);
+
+    int status = 0;
+    struct rusage usage = {};
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {}
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    result.maxRssKb = usage.ru_maxrss;
+    result.userMilliseconds = usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0;
+    result.systemMilliseconds = usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+    result.responseBytes = output.size();
+    result.httpStatus = getHttpStatus(output);
+    result.failed = !WIFEXITED(status) || WEXITSTATUS(status) != 0 || result.httpStatus == 0 || result.httpStatus >= 500;
+    return result;
+}
+
+// Runs the script once under ptrace and counts the syscalls it makes (child processes it starts are not counted)
+// This is much slower than a normal run, so the time isn't used
+static long countSyscalls(const Endpoint &endpoint, char *const *argv, char *const *envp) {
+    pid_t pid = startScript(endpoint, argv, envp, -1, true);
+    if (pid < 0)
+        throw std::runtime_error("Unable to fork");
+
+    int status = 0;
+    // Wait for the SIGSTOP before exec
+    if (waitpid(pid, &status, 0) < 0 || !WIFSTOPPED(status))
+        return -1;
+    ptrace(PTRACE_SETOPTIONS, pid, nullptr, reinterpret_cast<void *>(PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL));
+
+    long stops = 0;
+    int signal = 0;
+    while (true) {
+        ptrace(PTRACE_SYSCALL, pid, nullptr, reinterpret_cast<void *>(static_cast<long>(signal)));
+        if (waitpid(pid, &status, 0) < 0)
+            return -1;
+        if (WIFEXITED(status) || WIFSIGNALED(status))
+            break;
+
+        signal = 0;
+        if (WIFSTOPPED(status)) {
+            if (WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+                stops++;
+            } else if (WSTOPSIG(status) != SIGTRAP) { // SIGTRAP is from exec, anything else goes to the script
+                signal = WSTOPSIG(status);
+            }
+        }
+    }
+    // One stop when entering and one when leaving each syscall (exit_group never returns)
+    return (stops + 1) / 2;
+}
+
+// Nearest rank percentile of a sorted list
+static double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted.at(std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1);
+}
+
+static double round2(double value) {
+    return std::round(value * 100.0) / 100.0;
+}
+
+static nlohmann::json summarise(const Endpoint &endpoint, const std::string &scriptName, const std::vector<RunResult> &runs, long syscalls) {
+    std::vector<double> latency;
+    std::vector<double> rss;
+    double userTotal = 0, systemTotal = 0, bytesTotal = 0;
+    unsigned int failures = 0;
+    std::map<std::string, unsigned int> statusCodes;
+    for (const RunResult &run : runs) {
+        latency.push_back(run.milliseconds);
+        rss.push_back(static_cast<double>(run.maxRssKb));
+        userTotal += run.userMilliseconds;
+        systemTotal += run.systemMilliseconds;
+        bytesTotal += static_cast<double>(run.responseBytes);
+        if (run.failed)
+            failures++;
+        statusCodes[std::to_string(run.httpStatus)]++;
+    }
+    std::sort(latency.begin(), latency.end());
+    std::sort(rss.begin(), rss.end());
+    double count = runs.size() ? static_cast<double>(runs.size()) : 1;
+
+    nlohmann::json result;
+    result["name"] = endpoint.name;
+    result["script"] = scriptName;
+    result["runs"] = runs.size();
+    result["failures"] = failures;
+    result["status_codes"] = statusCodes;
+    double latencyTotal = 0;
+    for (double value : latency)
+        latencyTotal += value;
+    result["latency_ms"] = {
+        {"min", round2(latency.size() ? latency.front() : 0)},
+        {"mean", round2(latencyTotal / count)},
+        {"p50", round2(percentile(latency, 50))},
+        {"p95", round2(percentile(latency, 95))},
+        {"p99", round2(percentile(latency, 99))},
+        {"max", round2(latency.size() ? latency.back() : 0)}
+    };
+    result["max_rss_kb"] = {
+        {"p50", percentile(rss, 50)},
+        {"max", rss.size() ? rss.back() : 0}
+    };
+    result["cpu_ms_mean"] = {
+        {"user", round2(userTotal / count)},
+        {"system", round2(systemTotal / count)}
+    };
+    result["response_bytes_mean"] = std::round(bytesTotal / count);
+    if (syscalls >= 0) {
+        result["syscalls"] = syscalls;
+    } else {
+        result["syscalls"] = nullptr;
+    }
+    return result;
+}
+
+// Prints the change in latency and memory from a previous results file
+static void printComparison(const nlohmann::json &baseline, const nlohmann::json &results) {
+    std::map<std::string, nlohmann::json> previous;
+    for (const auto &endpoint : baseline.at("endpoints"))
+        previous[endpoint.at("name").get<std::string>()] = endpoint;
+
+    auto change = [](double before, double after) {
+        char text[32];
+        if (before <= 0) {
+            snprintf(text, sizeof(text), "%10s", "n/a");
+        } else {
+            snprintf(text, sizeof(text), "%+9.1f%%", (after - before) * 100.0 / before);
+        }
+        return std::string(text);
+    };
+
+    std::string commit = baseline.value("commit", "");
+    fprintf(stderr, "\nChange from baseline%s:\n", commit.size() ? (" (" + commit + ")").c_str() : "");
+    fprintf(stderr, "%-30s %10s %10s %10s %10s\n", "endpoint", "p50", "p95", "p99", "rss");
+    for (const auto &endpoint : results.at("endpoints")) {
+        std::string name = endpoint.at("name");
+        auto it = previous.find(name);
+        if (it == previous.end()) {
+            fprintf(stderr, "%-30s (not in baseline)\n", name.c_str());
+            continue;
+        }
+        const nlohmann::json &before = it->second;
+        fprintf(stderr, "%-30s %s %s %s %s\n", name.c_str(),
+                change(before.at("latency_ms").at("p50"), endpoint.at("latency_ms").at("p50")).c_str(),
+                change(before.at("latency_ms").at("p95"), endpoint.at("latency_ms").at("p95")).c_str(),
+                change(before.at("latency_ms").at("p99"), endpoint.at("latency_ms").at("p99")).c_str(),
+                change(before.at("max_rss_kb").at("p50"), endpoint.at("max_rss_kb").at("p50")).c_str());
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::string scenarioFilename;
+    std::string outputFilename;
+    std::string baselineFilename;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            outputFilename = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselineFilename = argv[++i];
+        } else if (scenarioFilename.empty() && arg.size() && arg.at(0) != '-') {
+            scenarioFilename = arg;
+        } else {
+            scenarioFilename.clear();
+            break;
+        }
+    }
+    if (scenarioFilename.empty()) {
+        std::cerr << "Usage: cgi_replay <scenario.json> [-o results.json] [--baseline old_results.json]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> bodyFiles;
+    try {
+        // Comments are allowed in the scenario file, like the config file
+        nlohmann::json scenario = nlohmann::json::parse(readFile(scenarioFilename), nullptr, true, true);
+        std::string scenarioDir = directoryOf(scenarioFilename);
+        std::string cgiDir = resolvePath(scenarioDir, scenario.value("cgiDir", "../cgi-bin"));
+        int defaultIterations = scenario.value("iterations", 20);
+        int concurrency = std::max(1, scenario.value("concurrency", 1));
+        int warmup = std::max(0, scenario.value("warmup", 1));
+        bool countSyscallsEnabled = scenario.value("countSyscalls", true);
+
+        std::map<std::string, std::string> commonEnvironment = {
+            {"GATEWAY_INTERFACE", "CGI/1.1"},
+            {"SERVER_PROTOCOL", "HTTP/1.1"},
+            {"SERVER_SOFTWARE", "cgi_replay"},
+            {"SERVER_NAME", "localhost"},
+            {"SERVER_PORT", "80"},
+            {"REMOTE_ADDR", "127.0.0.1"},
+            {"PATH", "/usr/local/bin:/usr/bin:/bin"}
+        };
+        if (scenario.contains("env"))
+            addEnvironment(scenario.at("env"), &commonEnvironment);
+
+        std::vector<Endpoint> endpoints;
+        std::vector<std::string> scriptNames;
+        for (const auto &request : scenario.at("requests")) {
+            Endpoint endpoint;
+            std::string script = request.at("script");
+            endpoint.name = request.value("name", script);
+            // The script is run from its own directory, so the path has to be absolute
+            char *scriptPath = realpath(resolvePath(cgiDir, script).c_str(), nullptr);
+            if (!scriptPath || access(scriptPath, X_OK) != 0) {
+                free(scriptPath);
+                throw std::runtime_error(resolvePath(cgiDir, script) + " is not an executable file");
+            }
+            endpoint.script = scriptPath;
+            free(scriptPath);
+            endpoint.directory = directoryOf(endpoint.script);
+            endpoint.iterations = request.value("iterations", defaultIterations);
+
+            std::string body = request.value("body", "");
+            if (request.contains("bodyFile"))
+                body = readFile(resolvePath(scenarioDir, request.at("bodyFile")));
+            if (body.size()) {
+                char filename[] = BODY_FILE_TEMPLATE;
+                int fd = mkstemp(filename);
+                if (fd < 0 || write(fd, body.data(), body.size()) != static_cast<ssize_t>(body.size()))
+                    throw std::runtime_error("Unable to write the request body to a temporary file");
+                close(fd);
+                endpoint.bodyFile = filename;
+                bodyFiles.push_back(filename);
+            }
+
+            std::map<std::string, std::string> environment = commonEnvironment;
+            environment["SCRIPT_NAME"] = "/cgi-bin/" + script;
+            environment["SCRIPT_FILENAME"] = endpoint.script;
+            environment["REQUEST_METHOD"] = body.size() ? "POST" : "GET";
+            if (request.contains("envFile"))
+                readEnvironmentFile(resolvePath(scenarioDir, request.at("envFile")), &environment);
+            if (request.contains("env"))
+                addEnvironment(request.at("env"), &environment);
+            if (body.size()) {
+                environment["CONTENT_LENGTH"] = std::to_string(body.size());
+                if (!environment.count("CONTENT_TYPE"))
+                    environment["CONTENT_TYPE"] = "application/x-www-form-urlencoded";
+            } else {
+                environment.erase("CONTENT_LENGTH");
+            }
+            if (!environment.count("REQUEST_URI")) {
+                std::string query = environment.count("QUERY_STRING") ? environment.at("QUERY_STRING") : "";
+                environment["REQUEST_URI"] = environment.at("SCRIPT_NAME") + (query.size() ? "?" + query : "");
+            }
+            for (const auto &variable : environment)
+                endpoint.environment.push_back(variable.first + "=" + variable.second);
+
+            endpoints.push_back(endpoint);
+            scriptNames.push_back(script);
+        }
+
+        nlohmann::json results;
+        results["timestamp"] = static_cast<long long>(time(nullptr));
+        results["commit"] = scenario.value("commit", "");
+        if (getenv("JLWE_COMMIT"))
+            results["commit"] = getenv("JLWE_COMMIT");
+        results["concurrency"] = concurrency;
+        results["endpoints"] = nlohmann::json::array();
+
+        for (size_t e = 0; e < endpoints.size(); e++) {
+            const Endpoint &endpoint = endpoints.at(e);
+
+            // argv and envp are built before forking, the child can't allocate memory safely
+            std::vector<char *> childArgv = {const_cast<char *>(endpoint.script.c_str()), nullptr};
+            std::vector<char *> childEnvp;
+            for (const std::string &variable : endpoint.environment)
+                childEnvp.push_back(const_cast<char *>(variable.c_str()));
+            childEnvp.push_back(nullptr);
+
+            std::cerr << endpoint.name << ": " << endpoint.iterations << " runs" << std::flush;
+
+            // Warm up the page cache and MySQL buffers
+            for (int i = 0; i < warmup; i++)
+                runOnce(endpoint, childArgv.data(), childEnvp.data());
+
+            std::vector<RunResult> runs(static_cast<size_t>(std::max(0, endpoint.iterations)));
+            std::atomic<size_t> nextRun(0);
+            std::vector<std::thread> workers;
+            for (int t = 0; t < concurrency; t++) {
+                workers.emplace_back([&]() {
+                    for (size_t i = nextRun++; i < runs.size(); i = nextRun++)
+                        runs.at(i) = runOnce(endpoint, childArgv.data(), childEnvp.data());
+                });
+            }
+            for (std::thread &worker : workers)
+                worker.join();
+
+            long syscalls = countSyscallsEnabled ? countSyscalls(endpoint, childArgv.data(), childEnvp.data()) : -1;
+
+            nlohmann::json summary = summarise(endpoint, scriptNames.at(e), runs, syscalls);
+            std::cerr << ", p50 " << summary["latency_ms"]["p50"] << " ms, p95 " << summary["latency_ms"]["p95"]
+                      << " ms, p99 " << summary["latency_ms"]["p99"] << " ms, " << summary["failures"] << " failed" << std::endl;
+            results["endpoints"].push_back(summary);
+        }
+
+        std::string json = results.dump(2) + "\n";
+        if (outputFilename.size()) {
+            std::ofstream output(outputFilename);
+            output << json;
+        } else {
+            std::cout << json;
+        }
+
+        if (baselineFilename.size())
+            printComparison(nlohmann::json::parse(readFile(baselineFilename)), results);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        for (const std::string &filename : bodyFiles)
+            unlink(filename.c_str());
+        return EXIT_FAILURE;
+    }
+
+    for (const std::string &filename : bodyFiles)
+        unlink(filename.c_str());
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,354 @@
+/**
+  @file    encoder_bench.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Benchmark for the Encoder functions, compares the SIMD kernels against the old byte at a time versions
+  Each function is run at every SIMD level the CPU supports, and the output is checked against the old version
+  The inputs are a mix of spreadsheet cells, GPX descriptions, URL query values and an email attachment
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../core/Encoder.h"
+
+// Total amount of input data for each test
+#define TARGET_BYTES (64 * 1048576)
+
+/*
+ * The versions of the functions that were in Encoder.cpp before the SIMD kernels were added
+ */
+
+static int oldUtf8Length(const char ch) {
+    if ((ch & 0b10000000) == 0b00000000)
+        return 1;
+    if ((ch & 0b11100000) == 0b11000000)
+        return 2;
+    if ((ch & 0b11110000) == 0b11100000)
+        return 3;
+    if ((ch & 0b11111000) == 0b11110000)
+        return 4;
+    return -1;
+}
+
+static uint32_t oldUtf8CodePoint(int code_point_length, const char *ch) {
+    if (code_point_length == 2)
+        return static_cast<uint32_t>(ch[0] & 0b00011111) << 6 | static_cast<uint32_t>(ch[1] & 0b00111111);
+    if (code_point_length == 3)
+        return static_cast<uint32_t>(ch[0] & 0b00001111) << 12 | static_cast<uint32_t>(ch[1] & 0b00111111) << 6 | static_cast<uint32_t>(ch[2] & 0b00111111);
+    if (code_point_length == 4)
+        return static_cast<uint32_t>(ch[0] & 0b00000111) << 18 | static_cast<uint32_t>(ch[1] & 0b00111111) << 12 | static_cast<uint32_t>(ch[2] & 0b00111111) << 6 | static_cast<uint32_t>(ch[3] & 0b00111111);
+    return 0;
+}
+
+static std::string oldHtmlEntityEncode(const std::string &text) {
+    std::string result;
+    result.reserve(text.size());
+    for (unsigned int i = 0; i < text.length(); i++) {
+        char ch = text.at(i);
+        int utf8length = oldUtf8Length(ch);
+        if (utf8length == 1) {
+            if (ch == '\n' || ch == '\r') {
+                result.push_back(ch);
+                continue;
+            }
+            if (ch >= 0 && ch < ' ') continue;
+            switch (ch) {
+            case '&':  result.append("&amp;"); break;
+            case '<':  result.append("&lt;");  break;
+            case '>':  result.append("&gt;");  break;
+            case '\'': result.append("&#39;"); break;
+            case '\"': result.append("&#34;"); break;
+            case '/':  result.append("&#47;"); break;
+            default:
+                result.push_back(ch);
+            }
+            continue;
+        }
+        if (utf8length < 1) continue;
+        if (i + static_cast<unsigned int>(utf8length) > text.length()) break;
+        uint32_t code_point = oldUtf8CodePoint(utf8length, text.c_str() + i);
+        if (code_point) {
+            std::string charOut = text.substr(i, static_cast<size_t>(utf8length));
+            i = i + static_cast<size_t>(utf8length) - 1;
+            result.append(charOut);
+        }
+    }
+    return result;
+}
+
+static std::string oldHtmlAttributeEncode(const std::string &text) {
+    return Encoder::removeNewLines(oldHtmlEntityEncode(text));
+}
+
+static std::string oldCharToHex(char c) {
+    std::string result;
+    char first = (c & 0xF0) / 16;
+    first += first > 9 ? 'A' - 10 : '0';
+    char second = c & 0x0F;
+    second += second > 9 ? 'A' - 10 : '0';
+    result.append(1, first);
+    result.append(1, second);
+    return result;
+}
+
+static std::string oldUrlEncode(const std::string &text) {
+    std::string result;
+    for (std::string::const_iterator iter = text.begin(); iter != text.end(); ++iter) {
+        char ch = *iter;
+        if (ch == ' ') {
+            result.append(1, '+');
+        } else if ((ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') ||
+                   ch == '-' || ch == '_' || ch == '.' || ch == '!' || ch == '~' || ch == '*' || ch == '\'' || ch == '(' || ch == ')') {
+            result.append(1, ch);
+        } else {
+            result.append(1, '%');
+            result.append(oldCharToHex(ch));
+        }
+    }
+    return result;
+}
+
+static char oldHexToChar(char first, char second) {
+    int digit = (first >= 'A' ? ((first & 0xDF) - 'A') + 10 : (first - '0'));
+    digit *= 16;
+    digit += (second >= 'A' ? ((second & 0xDF) - 'A') + 10 : (second - '0'));
+    return static_cast<char>(digit);
+}
+
+static std::string oldUrlDecode(const std::string &urlValue) {
+    std::string result;
+    for (std::string::const_iterator iter = urlValue.begin(); iter != urlValue.end(); ++iter) {
+        switch (*iter) {
+        case '+':
+            result.append(1, ' ');
+            break;
+        case '%':
+            if (std::distance(iter, urlValue.end()) >= 2 && std::isxdigit(*(iter + 1)) && std::isxdigit(*(iter + 2))) {
+                char c = *++iter;
+                result.append(1, oldHexToChar(c, *++iter));
+            } else {
+                result.append(1, '%');
+            }
+            break;
+        default:
+            result.append(1, *iter);
+            break;
+        }
+    }
+    return result;
+}
+
+static std::string oldBase64encode(const std::string &input) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    static const unsigned int modTable[] = {0, 2, 1};
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(input.data());
+    size_t inputLength = input.size();
+    std::string encodedData = "";
+    if (inputLength == 0)
+        return encodedData;
+    for (unsigned int i = 0; i < inputLength;) {
+        uint32_t octet_a = i < inputLength ? data[i++] : 0;
+        uint32_t octet_b = i < inputLength ? data[i++] : 0;
+        uint32_t octet_c = i < inputLength ? data[i++] : 0;
+        uint32_t triple = (octet_a << 0x10) + (octet_b << 0x08) + octet_c;
+        encodedData += table[(triple >> 3 * 6) & 0x3F];
+        encodedData += table[(triple >> 2 * 6) & 0x3F];
+        encodedData += table[(triple >> 1 * 6) & 0x3F];
+        encodedData += table[(triple >> 0 * 6) & 0x3F];
+    }
+    for (unsigned int i = 0; i < modTable[inputLength % 3]; i++)
+        encodedData[encodedData.size() - 1 - i] = '=';
+    return encodedData;
+}
+
+// The old way of making MIME base64: encode, then Email::splitLines()
+static std::string oldBase64Lines(const std::string &input) {
+    std::string encoded = oldBase64encode(input);
+    std::string result;
+    for (size_t i = 0; i < encoded.size(); i += 76) {
+        if (i)
+            result += "\r\n";
+        result += encoded.substr(i, 76);
+    }
+    return result;
+}
+
+/*
+ * Test inputs
+ */
+
+static std::vector<std::string> makeSpreadsheetCells(std::mt19937 &rng) {
+    static const std::vector<std::string> samples = {
+        "Smith", "Team Awesome", "john.smith@example.com", "0412 345 678", "Adelaide Hills",
+        "Under the rock next to the big gum tree", "Yes", "No", "12.50", "2024-06-08 14:32:10",
+        "Tom & Jerry's <cache>", "Müller", "Café Crème", "35°S 138°E", "Log: \"Found it!\" TFTC",
+        "https://www.geocaching.com/geocache/GC12345", "Vegetarian / no nuts"
+    };
+    std::vector<std::string> result;
+    for (size_t total = 0; total < TARGET_BYTES;) {
+        result.push_back(samples.at(rng() % samples.size()));
+        total += result.back().size();
+    }
+    return result;
+}
+
+static std::vector<std::string> makeDescriptions(std::mt19937 &rng) {
+    std::string paragraph = "This cache is hidden near the old railway bridge. Park at the car park on Main Road and follow the walking trail "
+                            "for about 500m. Please be careful of snakes in summer! The container is a small lock-n-lock (about 1L) with a "
+                            "logbook and some swaps.\nHint: look under the fallen log.\n";
+    std::vector<std::string> result;
+    for (size_t total = 0; total < TARGET_BYTES;) {
+        std::string text;
+        size_t copies = 1 + rng() % 8;
+        for (size_t i = 0; i < copies; i++)
+            text += paragraph;
+        if (rng() % 4 == 0)
+            text += "<b>Bonus</b> & extras: \"see /images\"";
+        result.push_back(text);
+        total += text.size();
+    }
+    return result;
+}
+
+static std::vector<std::string> makeUrlValues(std::mt19937 &rng) {
+    static const std::vector<std::string> samples = {
+        "geocaching", "team_name", "GC12345", "files/maps/event map 2024.pdf", "Tom & Jerry",
+        "a-long-value-with-no-special-characters-at-all-1234567890", "email@example.com", "Café"
+    };
+    std::vector<std::string> result;
+    for (size_t total = 0; total < TARGET_BYTES;) {
+        result.push_back(samples.at(rng() % samples.size()));
+        total += result.back().size();
+    }
+    return result;
+}
+
+static std::vector<std::string> makeAttachment(std::mt19937 &rng) {
+    std::string data(TARGET_BYTES, '\0');
+    for (char &ch : data)
+        ch = static_cast<char>(rng());
+    return {data};
+}
+
+// Random bytes, biased towards the characters the encoders treat specially
+static std::vector<std::string> makeFuzzInputs(std::mt19937 &rng) {
+    static const std::string interesting = "&<>'\"/%+ \r\n\t-_.!~*()09AZaz\x7f\x80\xbf\xc3\xe2\xf0\xff";
+    std::vector<std::string> result;
+    for (int i = 0; i < 20000; i++) {
+        std::string text(rng() % 100, '\0');
+        for (char &ch : text)
+            ch = (rng() % 2) ? interesting.at(rng() % interesting.size()) : static_cast<char>(rng());
+        result.push_back(text);
+    }
+    return result;
+}
+
+/*
+ * Timing
+ */
+
+static const char *levelName(Encoder::SimdLevel level) {
+    switch (level) {
+    case Encoder::SIMD_AVX2: return "AVX2";
+    case Encoder::SIMD_SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
+
+template <typename Function>
+static double timeRun(const std::vector<std::string> &inputs, Function function) {
+    size_t outputSize = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::string &input : inputs)
+        outputSize += function(input).size();
+    auto end = std::chrono::steady_clock::now();
+    if (outputSize == 0)
+        std::cout << "(empty output)" << std::endl;
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static size_t totalSize(const std::vector<std::string> &inputs) {
+    size_t total = 0;
+    for (const std::string &input : inputs)
+        total += input.size();
+    return total;
+}
+
+template <typename OldFunction, typename NewFunction>
+static int runTest(const std::string &name, const std::vector<std::string> &inputs, const std::vector<std::string> &fuzzInputs,
+                   const std::vector<Encoder::SimdLevel> &levels, OldFunction oldFunction, NewFunction newFunction) {
+    int mismatches = 0;
+    double megabytes = totalSize(inputs) / 1048576.0;
+
+    double oldTime = timeRun(inputs, oldFunction);
+    std::cout << name << ": old " << (megabytes / oldTime) << " MB/s";
+
+    for (Encoder::SimdLevel level : levels) {
+        Encoder::setSimdLevel(level);
+        for (const std::vector<std::string> *check : {&inputs, &fuzzInputs}) {
+            for (const std::string &input : *check) {
+                if (oldFunction(input) != newFunction(input))
+                    mismatches++;
+            }
+        }
+        double newTime = timeRun(inputs, newFunction);
+        std::cout << ", " << levelName(level) << " " << (megabytes / newTime) << " MB/s (" << (oldTime / newTime) << "x)";
+    }
+    std::cout << std::endl;
+
+    if (mismatches)
+        std::cout << name << ": " << mismatches << " outputs are different to the old version" << std::endl;
+    return mismatches;
+}
+
+int main() {
+    std::mt19937 rng(12345);
+    std::vector<std::string> cells = makeSpreadsheetCells(rng);
+    std::vector<std::string> descriptions = makeDescriptions(rng);
+    std::vector<std::string> urlValues = makeUrlValues(rng);
+    std::vector<std::string> attachment = makeAttachment(rng);
+    std::vector<std::string> fuzzInputs = makeFuzzInputs(rng);
+
+    std::vector<std::string> encodedUrlValues;
+    for (const std::string &value : urlValues)
+        encodedUrlValues.push_back(oldUrlEncode(value));
+    std::vector<std::string> encodedFuzzInputs = fuzzInputs;
+    for (const std::string &value : fuzzInputs)
+        encodedFuzzInputs.push_back(oldUrlEncode(value));
+
+    // Every level up to the best one the CPU supports
+    Encoder::SimdLevel best = Encoder::getSimdLevel();
+    std::vector<Encoder::SimdLevel> levels;
+    for (int level = Encoder::SIMD_NONE; level <= best; level++)
+        levels.push_back(static_cast<Encoder::SimdLevel>(level));
+
+    auto htmlEntityEncode = [](const std::string &text) { return Encoder::htmlEntityEncode(text); };
+    auto htmlAttributeEncode = [](const std::string &text) { return Encoder::htmlAttributeEncode(text); };
+    auto urlEncode = [](const std::string &text) { return Encoder::urlEncode(text); };
+    auto urlDecode = [](const std::string &text) { return Encoder::urlDecode(text); };
+    auto base64encode = [](const std::string &text) { return Encoder::base64encode(text); };
+    auto base64Lines = [](const std::string &text) {
+        return Encoder::base64encode(reinterpret_cast<const unsigned char *>(text.data()), text.size(), 76);
+    };
+
+    int mismatches = 0;
+    mismatches += runTest("htmlEntityEncode (cells)", cells, fuzzInputs, levels, oldHtmlEntityEncode, htmlEntityEncode);
+    mismatches += runTest("htmlEntityEncode (descriptions)", descriptions, fuzzInputs, levels, oldHtmlEntityEncode, htmlEntityEncode);
+    mismatches += runTest("htmlAttributeEncode (cells)", cells, fuzzInputs, levels, oldHtmlAttributeEncode, htmlAttributeEncode);
+    mismatches += runTest("urlEncode", urlValues, fuzzInputs, levels, oldUrlEncode, urlEncode);
+    mismatches += runTest("urlDecode", encodedUrlValues, encodedFuzzInputs, levels, oldUrlDecode, urlDecode);
+    mismatches += runTest("base64encode (attachment)", attachment, fuzzInputs, levels, oldBase64encode, base64encode);
+    mismatches += runTest("base64encode 76 char lines", attachment, fuzzInputs, levels, oldBase64Lines, base64Lines);
+
+    return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+/**
+  @file    file_delivery_bench.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Benchmark for FileSender, measures the throughput of each way of delivering a file download
+  The output of each method goes into a pipe that is drained by another thread, like the pipe from a CGI script to Apache
+  Usage: file_delivery_bench [size in MB] [iterations]
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "../core/FileSender.h"
+
+#define TEST_FILE "/tmp/jlwe_file_delivery_bench.bin"
+
+static std::atomic<unsigned long long> bytesReceived(0);
+
+// Reads and throws away everything from the pipe
+static void drainPipe(int fd) {
+    char buffer[65536];
+    while (true) {
+        ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size <= 0)
+            break;
+        bytesReceived += static_cast<unsigned long long>(size);
+    }
+}
+
+// The loop that download_file.cgi used before FileSender was added
+static void sendWithFread() {
+    FILE *file = fopen(TEST_FILE, "rb");
+    if (file) {
+        std::cout << "Content-type:application/octet-stream\r\n\r\n";
+        char buffer[1024];
+        size_t size = 1024;
+        while (size == 1024) {
+            size = fread(buffer, 1, 1024, file);
+            std::cout.write(buffer, size);
+        }
+        fclose(file);
+    }
+    std::cout.flush();
+}
+
+static void sendWithFileSender(FileSender::DeliveryMode mode) {
+    FileSender file(TEST_FILE);
+    file.setContentType("application/octet-stream");
+    file.setDeliveryMode(mode, TEST_FILE);
+    file.send();
+    std::cout.flush();
+}
+
+template <typename Function>
+static void timeRun(const std::string &name, int iterations, Function function) {
+    bytesReceived = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        function();
+    fflush(stdout);
+    auto end = std::chrono::steady_clock::now();
+
+    // Writes block once the pipe is full, so at most one pipe buffer can still be unread here
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cerr << name << ": " << (seconds * 1000.0 / iterations) << " ms per request, "
+              << (bytesReceived / seconds / 1048576.0) << " MB/s written by this process" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    int sizeMB = (argc > 1) ? atoi(argv[1]) : 64;
+    int iterations = (argc > 2) ? atoi(argv[2]) : 10;
+    if (sizeMB < 1 || iterations < 1) {
+        std::cerr << "Usage: file_delivery_bench [size in MB] [iterations]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Make the test file
+    FILE *file = fopen(TEST_FILE, "wb");
+    if (!file) {
+        std::cerr << "Unable to create " << TEST_FILE << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string block(1048576, 'x');
+    for (int i = 0; i < sizeMB; i++)
+        fwrite(block.data(), 1, block.size(), file);
+    fclose(file);
+
+    // Send stdout into a pipe
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        std::cerr << "Unable to create pipe" << std::endl;
+        return EXIT_FAILURE;
+    }
+    dup2(pipeFds[1], STDOUT_FILENO);
+    close(pipeFds[1]);
+    std::thread reader(drainPipe, pipeFds[0]);
+
+    setenv("REQUEST_METHOD", "GET", 1);
+
+    std::cerr << sizeMB << " MB file, " << iterations << " iterations" << std::endl;
+    timeRun("fread 1KB + cout (old)", iterations, sendWithFread);
+    timeRun("FileSender direct (sendfile)", iterations, []() { sendWithFileSender(FileSender::DELIVERY_DIRECT); });
+    timeRun("FileSender X-Sendfile (headers only)", iterations, []() { sendWithFileSender(FileSender::DELIVERY_X_SENDFILE); });
+
+    close(STDOUT_FILENO);
+    reader.join();
+    unlink(TEST_FILE);
+    return EXIT_SUCCESS;
+}
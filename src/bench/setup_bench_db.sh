@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+# Creates a database for the CGI replay benchmark and fills it with made up data
+# The database is dropped first if it already exists, so DON'T use the name of a real database
+#
+# Usage: setup_bench_db.sh <database> [bench_data options]
+# Run this from the bench directory of the build directory (where bench_data is)
+# MySQL login options can be given in MYSQL_OPTIONS, eg. MYSQL_OPTIONS="-u root -p"
+#
+# This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+# https://github.com/laighside/SAGeocachingJuneLWE
+
+set -e
+
+if [ -z "$1" ]; then
+    echo "Usage: setup_bench_db.sh <database> [bench_data options]" >&2
+    exit 1
+fi
+DATABASE="$1"
+shift
+
+MYSQL_DIR="$(dirname "$0")/../../mysql"
+BENCH_DATA="${BENCH_DATA:-./bench_data}"
+
+mysql $MYSQL_OPTIONS -e "DROP DATABASE IF EXISTS \`$DATABASE\`; CREATE DATABASE \`$DATABASE\` CHARACTER SET utf8mb4 COLLATE utf8mb4_0900_ai_ci;"
+mysql $MYSQL_OPTIONS "$DATABASE" < "$MYSQL_DIR/tables.sql"
+mysql $MYSQL_OPTIONS "$DATABASE" < "$MYSQL_DIR/functions.sql"
+"$BENCH_DATA" "$@" | mysql $MYSQL_OPTIONS "$DATABASE"
+
+echo "Database $DATABASE is ready"
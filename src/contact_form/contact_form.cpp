@@ -18,6 +18,7 @@
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
+#include "../core/RequestLoop.h"
 
 std::string statusToString(char status) {
     if (status == 'O') return "Open";
@@ -27,7 +28,7 @@ std::string statusToString(char status) {
     return "Unknown";
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -139,3 +140,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -18,11 +18,12 @@
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 #include "../email/Email.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -85,3 +86,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
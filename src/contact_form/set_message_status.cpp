@@ -17,10 +17,11 @@
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -66,3 +67,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
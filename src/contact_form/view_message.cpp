@@ -23,8 +23,9 @@
 #include "../core/KeyValueParser.h"
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
+#include "../core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     try {
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
 
@@ -155,3 +156,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -28,6 +28,11 @@
 
 #include "CgiEnvironment.h"
 
+#include <cstdlib>
+#include <cstring>
+
+char **CgiEnvironment::requestEnvironment = nullptr;
+
 // ========== Constructor/Destructor
 
 CgiEnvironment::CgiEnvironment() {
@@ -155,6 +160,18 @@ std::string CgiEnvironment::getRedirectStatus() {
 }
 
 std::string CgiEnvironment::getenvAsString(const char *varName) {
+  if (requestEnvironment) {
+    size_t nameLength = std::strlen(varName);
+    for (char **env = requestEnvironment; *env; ++env) {
+      if (std::strncmp(*env, varName, nameLength) == 0 && (*env)[nameLength] == '=')
+        return std::string(*env + nameLength + 1);
+    }
+    return std::string("");
+  }
   char *var = std::getenv(varName);
   return (nullptr == var) ? std::string("") : std::string(var);
 }
+
+void CgiEnvironment::setEnvironment(char **envp) {
+  requestEnvironment = envp;
+}
@@ -357,6 +357,18 @@ class CgiEnvironment {
      */
     static std::string getenvAsString(const char *varName);
 
+    /*!
+     * \brief Set the environment of the current request.
+     *
+     * Used by FastCGI workers, where each request has its own environment
+     * instead of the process environment. Set to nullptr to use the process environment.
+     * \param envp The NULL terminated list of NAME=value strings for the request
+     */
+    static void setEnvironment(char **envp);
+
+  private:
+    static char **requestEnvironment;
+
 };
 
 #endif /* ! CGIENVIRONMENT_H */
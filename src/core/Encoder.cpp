@@ -7,14 +7,191 @@
   A collection of functions that are used to encode/decode strings and data
   Implements the encoding described at https://cheatsheetseries.owasp.org/cheatsheets/Cross_Site_Scripting_Prevention_Cheat_Sheet.html
   All functions are static so there is no need to create instances of the Encoder object
+  The SIMD kernels scan 16 (SSE2) or 32 (AVX2) bytes at a time for characters that need encoding,
+  the characters that do are handled by the same scalar code as before
 
   This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
   https://github.com/laighside/SAGeocachingJuneLWE
  */
 #include "Encoder.h"
 
+#include <cctype>
 #include <cstdint>
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define ENCODER_X86_SIMD
+#include <immintrin.h>
+#endif
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+// The best SIMD level the CPU supports
+static Encoder::SimdLevel detectSimdLevel() {
+#ifdef ENCODER_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Encoder::SIMD_AVX2;
+    return Encoder::SIMD_SSE2; // SSE2 is part of x86-64
+#else
+    return Encoder::SIMD_NONE;
+#endif
+}
+
+static Encoder::SimdLevel &activeSimdLevel() {
+    static Encoder::SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+Encoder::SimdLevel Encoder::getSimdLevel() {
+    return activeSimdLevel();
+}
+
+void Encoder::setSimdLevel(SimdLevel level) {
+    SimdLevel supported = detectSimdLevel();
+    activeSimdLevel() = (level < supported) ? level : supported;
+}
+
+// Character classes for the scanning kernels
+// isSpecial() is true for characters that can't be copied straight to the output
+// special128() and special256() do the same for a block of bytes, setting each byte that is special to 0xFF
+
+// HTML: control characters, non-ASCII bytes and & < > ' " /
+struct HtmlCharClass {
+    static inline bool isSpecial(unsigned char ch) {
+        return (ch < 0x20 || ch >= 0x80 || ch == '&' || ch == '<' || ch == '>' || ch == '\'' || ch == '\"' || ch == '/');
+    }
+#ifdef ENCODER_X86_SIMD
+    static inline __m128i special128(__m128i b) {
+        // As signed bytes, everything below 0x20 or above 0x7F is less than 0x20
+        __m128i result = _mm_cmplt_epi8(b, _mm_set1_epi8(0x20));
+        result = _mm_or_si128(result, _mm_cmpeq_epi8(b, _mm_set1_epi8('&')));
+        result = _mm_or_si128(result, _mm_cmpeq_epi8(b, _mm_set1_epi8('<')));
+        result = _mm_or_si128(result, _mm_cmpeq_epi8(b, _mm_set1_epi8('>')));
+        result = _mm_or_si128(result, _mm_cmpeq_epi8(b, _mm_set1_epi8('\'')));
+        result = _mm_or_si128(result, _mm_cmpeq_epi8(b, _mm_set1_epi8('\"')));
+        return _mm_or_si128(result, _mm_cmpeq_epi8(b, _mm_set1_epi8('/')));
+    }
+    __attribute__((target("avx2"))) static inline __m256i special256(__m256i b) {
+        __m256i result = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), b);
+        result = _mm256_or_si256(result, _mm256_cmpeq_epi8(b, _mm256_set1_epi8('&')));
+        result = _mm256_or_si256(result, _mm256_cmpeq_epi8(b, _mm256_set1_epi8('<')));
+        result = _mm256_or_si256(result, _mm256_cmpeq_epi8(b, _mm256_set1_epi8('>')));
+        result = _mm256_or_si256(result, _mm256_cmpeq_epi8(b, _mm256_set1_epi8('\'')));
+        result = _mm256_or_si256(result, _mm256_cmpeq_epi8(b, _mm256_set1_epi8('\"')));
+        return _mm256_or_si256(result, _mm256_cmpeq_epi8(b, _mm256_set1_epi8('/')));
+    }
+#endif
+};
+
+// URL encoding: everything except 0-9 A-Z a-z - _ . ! ~ * ' ( )
+struct UrlEncodeCharClass {
+    static inline bool isSpecial(unsigned char ch) {
+        if ((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z'))
+            return false;
+        return !(ch == '-' || ch == '_' || ch == '.' || ch == '!' || ch == '~' || ch == '*' || ch == '\'' || ch == '(' || ch == ')');
+    }
+#ifdef ENCODER_X86_SIMD
+    // lo <= b <= hi, all the bounds are ASCII so bytes above 0x7F (negative) are never in range
+    static inline __m128i inRange128(__m128i b, char lo, char hi) {
+        return _mm_and_si128(_mm_cmpgt_epi8(b, _mm_set1_epi8(static_cast<char>(lo - 1))), _mm_cmplt_epi8(b, _mm_set1_epi8(static_cast<char>(hi + 1))));
+    }
+    static inline __m128i special128(__m128i b) {
+        __m128i safe = inRange128(b, '0', '9');
+        safe = _mm_or_si128(safe, inRange128(_mm_or_si128(b, _mm_set1_epi8(0x20)), 'a', 'z')); // upper and lower case
+        safe = _mm_or_si128(safe, inRange128(b, '\'', '*')); // ' ( ) *
+        safe = _mm_or_si128(safe, inRange128(b, '-', '.'));
+        safe = _mm_or_si128(safe, _mm_cmpeq_epi8(b, _mm_set1_epi8('!')));
+        safe = _mm_or_si128(safe, _mm_cmpeq_epi8(b, _mm_set1_epi8('_')));
+        safe = _mm_or_si128(safe, _mm_cmpeq_epi8(b, _mm_set1_epi8('~')));
+        return _mm_andnot_si128(safe, _mm_set1_epi8(-1));
+    }
+    __attribute__((target("avx2"))) static inline __m256i inRange256(__m256i b, char lo, char hi) {
+        return _mm256_and_si256(_mm256_cmpgt_epi8(b, _mm256_set1_epi8(static_cast<char>(lo - 1))), _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), b));
+    }
+    __attribute__((target("avx2"))) static inline __m256i special256(__m256i b) {
+        __m256i safe = inRange256(b, '0', '9');
+        safe = _mm256_or_si256(safe, inRange256(_mm256_or_si256(b, _mm256_set1_epi8(0x20)), 'a', 'z'));
+        safe = _mm256_or_si256(safe, inRange256(b, '\'', '*'));
+        safe = _mm256_or_si256(safe, inRange256(b, '-', '.'));
+        safe = _mm256_or_si256(safe, _mm256_cmpeq_epi8(b, _mm256_set1_epi8('!')));
+        safe = _mm256_or_si256(safe, _mm256_cmpeq_epi8(b, _mm256_set1_epi8('_')));
+        safe = _mm256_or_si256(safe, _mm256_cmpeq_epi8(b, _mm256_set1_epi8('~')));
+        return _mm256_andnot_si256(safe, _mm256_set1_epi8(-1));
+    }
+#endif
+};
+
+// URL decoding: % and +
+struct UrlDecodeCharClass {
+    static inline bool isSpecial(unsigned char ch) {
+        return (ch == '%' || ch == '+');
+    }
+#ifdef ENCODER_X86_SIMD
+    static inline __m128i special128(__m128i b) {
+        return _mm_or_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8('%')), _mm_cmpeq_epi8(b, _mm_set1_epi8('+')));
+    }
+    __attribute__((target("avx2"))) static inline __m256i special256(__m256i b) {
+        return _mm256_or_si256(_mm256_cmpeq_epi8(b, _mm256_set1_epi8('%')), _mm256_cmpeq_epi8(b, _mm256_set1_epi8('+')));
+    }
+#endif
+};
+
+template <class CharClass>
+static size_t plainLengthScalar(const char *data, size_t length) {
+    size_t i = 0;
+    while (i < length && !CharClass::isSpecial(static_cast<unsigned char>(data[i])))
+        i++;
+    return i;
+}
+
+#ifdef ENCODER_X86_SIMD
+template <class CharClass>
+static size_t plainLengthSSE2(const char *data, size_t length) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(CharClass::special128(block)));
+        if (mask)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return i + plainLengthScalar<CharClass>(data + i, length - i);
+}
+
+template <class CharClass>
+__attribute__((target("avx2"))) static size_t plainLengthAVX2(const char *data, size_t length) {
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(CharClass::special256(block)));
+        if (mask)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    // The 16 byte step is repeated here rather than calling plainLengthSSE2(), so it gets the VEX encoding
+    // and doesn't pay for switching between AVX and SSE instructions
+    if (i + 16 <= length) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(CharClass::special128(block)));
+        if (mask)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        i += 16;
+    }
+    return i + plainLengthScalar<CharClass>(data + i, length - i);
+}
+#endif
+
+// Returns the number of characters at the start of data that don't need encoding
+template <class CharClass>
+static size_t plainLength(const char *data, size_t length) {
+#ifdef ENCODER_X86_SIMD
+    switch (activeSimdLevel()) {
+    case Encoder::SIMD_AVX2: return plainLengthAVX2<CharClass>(data, length);
+    case Encoder::SIMD_SSE2: return plainLengthSSE2<CharClass>(data, length);
+    default: break;
+    }
+#endif
+    return plainLengthScalar<CharClass>(data, length);
+}
+
 // tables used in base64 encoding
 char Encoder::base64_encoding_table[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
                                          'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
@@ -24,31 +201,102 @@ char Encoder::base64_encoding_table[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
                                          'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
                                          'w', 'x', 'y', 'z', '0', '1', '2', '3',
                                          '4', '5', '6', '7', '8', '9', '+', '/'};
-unsigned int Encoder::base64_mod_table[] = {0, 2, 1};
 
-// Base 64 encoder
-std::string Encoder::base64encode(const unsigned char *data, size_t inputLength) {
-    std::string encodedData = "";
-
-    if (inputLength == 0)
-        return encodedData;
+#ifdef ENCODER_X86_SIMD
+// Encodes 24 bytes into 32 base64 characters, reads 28 bytes from data
+// Method from "Faster Base64 Encoding and Decoding using AVX2 Instructions", Wojciech Mula and Daniel Lemire
+__attribute__((target("avx2"))) static inline void base64encodeAVX2(const unsigned char *data, char *output) {
+    // 12 bytes in each 128 bit lane
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 12));
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+    // Each group of 3 bytes [a b c] goes into a 32 bit word as [b a c b]
+    in = _mm256_shuffle_epi8(in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                                 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    // Move each 6 bit field into its own byte
+    __m256i t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    __m256i t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    __m256i indices = _mm256_or_si256(t1, t3);
+
+    // Turn the 6 bit values into characters by adding an offset that depends on which range they are in
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    range = _mm256_or_si256(range, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    __m256i result = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(output), result);
+}
+#endif
 
-    for (unsigned int i = 0; i < inputLength;) {
-        uint32_t octet_a = i < inputLength ? data[i++] : 0;
-        uint32_t octet_b = i < inputLength ? data[i++] : 0;
-        uint32_t octet_c = i < inputLength ? data[i++] : 0;
+void Encoder::base64encodeBlock(const unsigned char *data, size_t inputLength, char *output) {
+    size_t i = 0;
 
-        uint32_t triple = (octet_a << 0x10) + (octet_b << 0x08) + octet_c;
+#ifdef ENCODER_X86_SIMD
+    if (activeSimdLevel() == SIMD_AVX2) {
+        for (; i + 28 <= inputLength; i += 24) {
+            base64encodeAVX2(data + i, output);
+            output += 32;
+        }
+    }
+#endif
+
+    for (; i + 3 <= inputLength; i += 3) {
+        uint32_t triple = (static_cast<uint32_t>(data[i]) << 0x10) + (static_cast<uint32_t>(data[i + 1]) << 0x08) + data[i + 2];
+        output[0] = base64_encoding_table[(triple >> 3 * 6) & 0x3F];
+        output[1] = base64_encoding_table[(triple >> 2 * 6) & 0x3F];
+        output[2] = base64_encoding_table[(triple >> 1 * 6) & 0x3F];
+        output[3] = base64_encoding_table[(triple >> 0 * 6) & 0x3F];
+        output += 4;
+    }
 
-        encodedData += base64_encoding_table[(triple >> 3 * 6) & 0x3F];
-        encodedData += base64_encoding_table[(triple >> 2 * 6) & 0x3F];
-        encodedData += base64_encoding_table[(triple >> 1 * 6) & 0x3F];
-        encodedData += base64_encoding_table[(triple >> 0 * 6) & 0x3F];
+    // The last 1 or 2 bytes are padded with =
+    if (i < inputLength) {
+        uint32_t octet_a = data[i];
+        uint32_t octet_b = (i + 1 < inputLength) ? data[i + 1] : 0;
+        uint32_t triple = (octet_a << 0x10) + (octet_b << 0x08);
+        output[0] = base64_encoding_table[(triple >> 3 * 6) & 0x3F];
+        output[1] = base64_encoding_table[(triple >> 2 * 6) & 0x3F];
+        output[2] = (i + 1 < inputLength) ? base64_encoding_table[(triple >> 1 * 6) & 0x3F] : '=';
+        output[3] = '=';
     }
+}
 
-    for (unsigned int i = 0; i < base64_mod_table[inputLength % 3]; i++)
-        encodedData[encodedData.size() - 1 - i] = '=';
+// Base 64 encoder
+std::string Encoder::base64encode(const unsigned char *data, size_t inputLength) {
+    std::string encodedData((inputLength + 2) / 3 * 4, '\0');
+    if (inputLength)
+        base64encodeBlock(data, inputLength, &encodedData[0]);
+    return encodedData;
+}
 
+// Base 64 encoder with line breaks, each line is encoded straight into place
+std::string Encoder::base64encode(const unsigned char *data, size_t inputLength, size_t lineLength) {
+    lineLength -= lineLength % 4;
+    if (lineLength == 0 || inputLength == 0)
+        return base64encode(data, inputLength);
+
+    size_t bytesPerLine = lineLength / 4 * 3;
+    size_t lineCount = (inputLength + bytesPerLine - 1) / bytesPerLine;
+    std::string encodedData((inputLength + 2) / 3 * 4 + (lineCount - 1) * 2, '\0');
+
+    char *output = &encodedData[0];
+    for (size_t i = 0; i < inputLength; i += bytesPerLine) {
+        size_t length = (inputLength - i < bytesPerLine) ? inputLength - i : bytesPerLine;
+        base64encodeBlock(data + i, length, output);
+        output += (length + 2) / 3 * 4;
+        if (i + length < inputLength) {
+            output[0] = '\r';
+            output[1] = '\n';
+            output += 2;
+        }
+    }
     return encodedData;
 }
 
@@ -76,19 +324,41 @@ std::string Encoder::removeNewLines(const std::string &text) {
 // https://cheatsheetseries.owasp.org/cheatsheets/Cross_Site_Scripting_Prevention_Cheat_Sheet.html#rule-1-html-encode-before-inserting-untrusted-data-into-html-element-content
 // Encode &, <, >, ", ', /
 std::string Encoder::htmlEntityEncode(const std::string &text) {
+    return htmlEncode(text, true);
+}
+
+// https://cheatsheetseries.owasp.org/cheatsheets/Cross_Site_Scripting_Prevention_Cheat_Sheet.html#rule-2-attribute-encode-before-inserting-untrusted-data-into-html-common-attributes
+// Basically the same as HTML Entity Encode but there are some special cases where this can't be used - see OWASP website
+// New lines within attributes don't make much sense either so remove them
+std::string Encoder::htmlAttributeEncode(const std::string &text) {
+    return htmlEncode(text, false);
+}
+
+std::string Encoder::htmlEncode(const std::string &text, bool keepNewLines) {
 
     std::string result;
     result.reserve(text.size());
 
-    for (unsigned int i = 0; i < text.length(); i++) {
-        char ch = text.at(i);
+    const char *data = text.data();
+    size_t length = text.length();
+    size_t i = 0;
+    while (i < length) {
+        // Copy everything up to the next character that needs encoding
+        size_t plain = plainLength<HtmlCharClass>(data + i, length - i);
+        result.append(data + i, plain);
+        i += plain;
+        if (i >= length)
+            break;
+
+        char ch = data[i];
         int utf8length = utf8Length(ch);
         if (utf8length == 1) { // basic ascii characters
+            i++;
             if (ch == '\n' || ch == '\r') { // new lines are allowed
-                result.push_back(ch);
+                if (keepNewLines)
+                    result.push_back(ch);
                 continue;
             }
-            if (ch >= 0 && ch < ' ') continue; // skip all other non-printable characters
 
             switch (ch) {
             case '&':  result.append("&amp;"); break;
@@ -98,33 +368,34 @@ std::string Encoder::htmlEntityEncode(const std::string &text) {
             case '\"': result.append("&#34;"); break;
             case '/':  result.append("&#47;"); break;
             default:
-                result.push_back(ch); // No encoding needed for other ASCII characters
+                break; // skip all other non-printable characters
             }
             continue;
         }
-        if (utf8length < 1) continue; // skip invalid bytes
+        if (utf8length < 1) { // skip invalid bytes
+            i++;
+            continue;
+        }
 
-        if (i + static_cast<unsigned int>(utf8length) > text.length()) break; // check there are enough bytes
+        if (i + static_cast<size_t>(utf8length) > length) break; // check there are enough bytes
 
-        uint32_t code_point = utf8CodePoint(utf8length, text.c_str() + i);
+        uint32_t code_point = utf8CodePoint(utf8length, data + i);
 
         if (code_point) {
-            std::string charOut = text.substr(i, static_cast<size_t>(utf8length));
-            i = i + static_cast<size_t>(utf8length) - 1; // Skip over the extra bytes
-            result.append(charOut); // Leave all non-ASCII characters intact if the encoding is valid
+            // Leave all non-ASCII characters intact if the encoding is valid
+            for (int j = 0; j < utf8length; j++) {
+                if (keepNewLines || (data[i + j] != '\n' && data[i + j] != '\r'))
+                    result.push_back(data[i + j]);
+            }
+            i += static_cast<size_t>(utf8length);
+        } else {
+            i++;
         }
     }
 
     return result;
 }
 
-// https://cheatsheetseries.owasp.org/cheatsheets/Cross_Site_Scripting_Prevention_Cheat_Sheet.html#rule-2-attribute-encode-before-inserting-untrusted-data-into-html-common-attributes
-// Basically the same as HTML Entity Encode but there are some special cases where this can't be used - see OWASP website
-// New lines within attributes don't make much sense either so remove them
-std::string Encoder::htmlAttributeEncode(const std::string &text) {
-    return removeNewLines(htmlEntityEncode(text));
-}
-
 // https://cheatsheetseries.owasp.org/cheatsheets/Cross_Site_Scripting_Prevention_Cheat_Sheet.html#rule-3-javascript-encode-before-inserting-untrusted-data-into-javascript-data-values
 // Encoding for placing strings in javascript attribute values
 // eg. <div onclick="myFunction('Encode the data that goes here')"></div>
@@ -183,74 +454,66 @@ std::string Encoder::javascriptAttributeEncode(const std::string &text) {
     return result;
 }
 
-// From cgicc
+// Based on cgicc
+// Alphanumeric characters and the marks - _ . ! ~ * ' ( ) are left as they are
 std::string Encoder::urlEncode(const std::string &text) {
     std::string result;
-    std::string::const_iterator iter;
-
-    for(iter = text.begin(); iter != text.end(); ++iter) {
-      switch(*iter) {
-      case ' ':
-        result.append(1, '+');
-        break;
-        // alnum
-      case 'A': case 'B': case 'C': case 'D': case 'E': case 'F': case 'G':
-      case 'H': case 'I': case 'J': case 'K': case 'L': case 'M': case 'N':
-      case 'O': case 'P': case 'Q': case 'R': case 'S': case 'T': case 'U':
-      case 'V': case 'W': case 'X': case 'Y': case 'Z':
-      case 'a': case 'b': case 'c': case 'd': case 'e': case 'f': case 'g':
-      case 'h': case 'i': case 'j': case 'k': case 'l': case 'm': case 'n':
-      case 'o': case 'p': case 'q': case 'r': case 's': case 't': case 'u':
-      case 'v': case 'w': case 'x': case 'y': case 'z':
-      case '0': case '1': case '2': case '3': case '4': case '5': case '6':
-      case '7': case '8': case '9':
-        // mark
-      case '-': case '_': case '.': case '!': case '~': case '*': case '\'':
-      case '(': case ')':
-        result.append(1, *iter);
-        break;
-        // escape
-      default:
-        result.append(1, '%');
-        result.append(charToHex(*iter));
-        break;
-      }
+    result.reserve(text.size() + text.size() / 4);
+
+    const char *data = text.data();
+    size_t length = text.length();
+    size_t i = 0;
+    while (i < length) {
+        size_t plain = plainLength<UrlEncodeCharClass>(data + i, length - i);
+        result.append(data + i, plain);
+        i += plain;
+        if (i >= length)
+            break;
+
+        unsigned char ch = static_cast<unsigned char>(data[i++]);
+        if (ch == ' ') {
+            result.push_back('+');
+        } else {
+            // escape
+            result.push_back('%');
+            result.push_back(hex_digits[ch >> 4]);
+            result.push_back(hex_digits[ch & 0x0F]);
+        }
     }
 
     return result;
 }
 
-// From cgicc
+// Based on cgicc
 std::string Encoder::urlDecode(const std::string& urlValue) {
-  std::string result;
-  std::string::const_iterator iter;
-  char c;
-
-  for(iter = urlValue.begin(); iter != urlValue.end(); ++iter) {
-    switch(*iter) {
-    case '+':
-      result.append(1, ' ');
-      break;
-    case '%':
-      // Don't assume well-formed input
-      if(std::distance(iter, urlValue.end()) >= 2
-         && std::isxdigit(*(iter + 1)) && std::isxdigit(*(iter + 2))) {
-        c = *++iter;
-        result.append(1, hexToChar(c, *++iter));
-      }
-      // Just pass the % through untouched
-      else {
-        result.append(1, '%');
-      }
-      break;
-
-    default:
-      result.append(1, *iter);
-      break;
+    std::string result;
+    result.reserve(urlValue.size());
+
+    const char *data = urlValue.data();
+    size_t length = urlValue.length();
+    size_t i = 0;
+    while (i < length) {
+        size_t plain = plainLength<UrlDecodeCharClass>(data + i, length - i);
+        result.append(data + i, plain);
+        i += plain;
+        if (i >= length)
+            break;
+
+        if (data[i] == '+') {
+            result.push_back(' ');
+            i++;
+        } else if (i + 2 < length && std::isxdigit(static_cast<unsigned char>(data[i + 1])) && std::isxdigit(static_cast<unsigned char>(data[i + 2]))) {
+            // Don't assume well-formed input
+            result.push_back(hexToChar(data[i + 1], data[i + 2]));
+            i += 3;
+        } else {
+            // Just pass the % through untouched
+            result.push_back('%');
+            i++;
+        }
     }
-  }
 
-  return result;
+    return result;
 }
 
 // remove all characters except 0-9, A-Z, a-z, -, _, .
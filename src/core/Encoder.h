@@ -7,6 +7,8 @@
   A collection of functions that are used to encode/decode strings and data
   Implements the encoding described at https://cheatsheetseries.owasp.org/cheatsheets/Cross_Site_Scripting_Prevention_Cheat_Sheet.html
   All functions are static so there is no need to create instances of the Encoder object
+  On x86-64 the HTML, URL and base64 functions use SSE2/AVX2 to find the characters that need encoding,
+  and copy the runs of characters that don't in bulk. The instruction set is picked at runtime.
 
   This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
   https://github.com/laighside/SAGeocachingJuneLWE
@@ -21,6 +23,27 @@ class Encoder {
 
 public:
 
+    // The vector instruction sets the encoding functions can use
+    enum SimdLevel {
+        SIMD_NONE,
+        SIMD_SSE2,
+        SIMD_AVX2
+    };
+
+    /*!
+     * \brief Gets the vector instruction set that is being used.
+     *
+     * \return The SIMD level, this is the best one the CPU supports unless setSimdLevel() was called
+     */
+    static SimdLevel getSimdLevel();
+
+    /*!
+     * \brief Limits the vector instruction set that is used, for benchmarks and testing.
+     *
+     * \param level The SIMD level to use, if the CPU doesn't support it the best supported level is used instead
+     */
+    static void setSimdLevel(SimdLevel level);
+
     /*!
      * \brief Encodes some data as base64.
      *
@@ -30,6 +53,18 @@ public:
      */
     static std::string base64encode(const unsigned char *data, size_t inputLength);
 
+    /*!
+     * \brief Encodes some data as base64, split into lines.
+     *
+     * Used for MIME, where lines can be at most 76 characters long (RFC 2045)
+     *
+     * \param data The array of data to encode
+     * \param inputLength The length of the data array
+     * \param lineLength The number of characters on each line, rounded down to a multiple of 4. Zero means no line breaks.
+     * \return The base64 encoded data with lines separated by \\r\\n (there is no line break after the last line)
+     */
+    static std::string base64encode(const unsigned char *data, size_t inputLength, size_t lineLength);
+
     /*!
      * \brief Encodes some data as base64.
      *
@@ -120,7 +155,12 @@ public:
 private:
     // tables used in base64 encoding
     static char base64_encoding_table[];
-    static unsigned int base64_mod_table[];
+
+    // Encodes inputLength bytes as base64, writing 4 * ceil(inputLength / 3) characters to output
+    static void base64encodeBlock(const unsigned char *data, size_t inputLength, char *output);
+
+    // Shared by htmlEntityEncode and htmlAttributeEncode
+    static std::string htmlEncode(const std::string &text, bool keepNewLines);
 
     // functions for representing characters in hexadecimal format
     static std::string charToHex(char c);
@@ -0,0 +1,364 @@
+/**
+  @file    FileSender.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Sends a file from the server's filesystem as the HTTP response
+  The ETag is made from the file's metadata, so checking it only costs a stat, not a read of the file
+  File data is copied with sendfile (or pread in a FastCGI worker) instead of going through a read buffer and cout
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "FileSender.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+#include "CgiEnvironment.h"
+#include "JlweUtils.h"
+#include "RequestLoop.h"
+
+#define BUFFER_SIZE 65536
+
+// Requests with more ranges than this get the whole file instead
+#define MAX_RANGES 16
+
+FileSender::FileSender(const std::string &filename) {
+    this->filename = filename;
+    this->deliveryMode = DELIVERY_DIRECT;
+    this->fd = open(filename.c_str(), O_RDONLY);
+    if (this->fd >= 0) {
+        if (fstat(this->fd, &this->fileInfo) != 0 || !S_ISREG(this->fileInfo.st_mode)) {
+            close(this->fd);
+            this->fd = -1;
+        }
+    }
+}
+
+FileSender::~FileSender() {
+    if (this->fd >= 0)
+        close(this->fd);
+}
+
+bool FileSender::isOpen() const {
+    return (this->fd >= 0);
+}
+
+void FileSender::setContentType(const std::string &contentType) {
+    this->contentType = contentType;
+}
+
+void FileSender::setCacheControl(const std::string &cacheControl) {
+    this->cacheControl = cacheControl;
+}
+
+void FileSender::setHeader(const std::string &name, const std::string &value) {
+    this->headers.push_back({name, value});
+}
+
+void FileSender::setDeliveryMode(DeliveryMode mode, const std::string &serverPath) {
+    this->deliveryMode = mode;
+    this->serverPath = serverPath;
+}
+
+// Percent encodes a path for use in a URI, leaving the slashes as they are
+static std::string encodeUriPath(const std::string &path) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string result;
+    for (char c : path) {
+        if (isalnum(static_cast<unsigned char>(c)) || c == '/' || c == '-' || c == '_' || c == '.' || c == '~') {
+            result.push_back(c);
+        } else {
+            result.push_back('%');
+            result.push_back(hex[static_cast<unsigned char>(c) >> 4]);
+            result.push_back(hex[static_cast<unsigned char>(c) & 0x0F]);
+        }
+    }
+    return result;
+}
+
+// Checks the path is inside the directory, not just starting with the same text (/files2/a.txt is not in /files)
+static bool isInDirectory(const std::string &path, const std::string &directory) {
+    if (directory.empty() || path.size() <= directory.size() || path.compare(0, directory.size(), directory) != 0)
+        return false;
+    return directory.back() == '/' || path.at(directory.size()) == '/';
+}
+
+void FileSender::setDeliveryFromConfig(const nlohmann::json &config) {
+    const nlohmann::json &filesConfig = config.at("files");
+    std::string mode = filesConfig.value("deliveryMode", "direct");
+    std::string baseDir = filesConfig.at("directory");
+
+    // Only files in the file manager directory can be handed to the web server
+    if (mode == "direct" || !isInDirectory(this->filename, baseDir) || this->filename.find("/../") != std::string::npos) {
+        this->setDeliveryMode(DELIVERY_DIRECT, "");
+    } else if (mode == "x-sendfile") {
+        this->setDeliveryMode(DELIVERY_X_SENDFILE, this->filename);
+    } else if (mode == "x-accel-redirect") {
+        std::string prefix = filesConfig.value("accelRedirectPrefix", "");
+        this->setDeliveryMode(DELIVERY_X_ACCEL_REDIRECT, prefix + encodeUriPath(this->filename.substr(baseDir.size())));
+    } else {
+        throw std::invalid_argument("Invalid files.deliveryMode in config file: " + mode);
+    }
+}
+
+std::string FileSender::getETag() const {
+    char etag[100];
+    snprintf(etag, sizeof(etag), "\"%llx-%llx-%llx.%lx\"",
+             static_cast<unsigned long long>(this->fileInfo.st_ino),
+             static_cast<unsigned long long>(this->fileInfo.st_size),
+             static_cast<unsigned long long>(this->fileInfo.st_mtim.tv_sec),
+             static_cast<unsigned long>(this->fileInfo.st_mtim.tv_nsec));
+    return std::string(etag);
+}
+
+bool FileSender::isNotModified() const {
+    std::string method = CgiEnvironment::getRequestMethod();
+    if (method != "GET" && method != "HEAD")
+        return false;
+
+    // If-None-Match takes priority, If-Modified-Since is only used if there is no If-None-Match
+    std::string ifNoneMatch = CgiEnvironment::getenvAsString("HTTP_IF_NONE_MATCH");
+    if (ifNoneMatch.size()) {
+        std::string etag = this->getETag();
+        std::vector<std::string> tags = JlweUtils::splitString(ifNoneMatch, ',');
+        for (std::string &tag : tags) {
+            JlweUtils::trimString(tag);
+            // If-None-Match uses the weak comparison, so ignore the W/ prefix
+            if (tag.compare(0, 2, "W/") == 0)
+                tag = tag.substr(2);
+            if (tag == etag || tag == "*")
+                return true;
+        }
+        return false;
+    }
+
+    std::string ifModifiedSince = CgiEnvironment::getenvAsString("HTTP_IF_MODIFIED_SINCE");
+    if (ifModifiedSince.size()) {
+        time_t since = JlweUtils::httpDateToTime(ifModifiedSince);
+        if (since >= 0 && this->fileInfo.st_mtime <= since)
+            return true;
+    }
+    return false;
+}
+
+// Parses a number from a Range header, returns false if it isn't a valid (non-negative) number
+static bool parseRangeNumber(const std::string &str, off_t *value) {
+    if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    errno = 0;
+    unsigned long long number = strtoull(str.c_str(), nullptr, 10);
+    if (errno == ERANGE)
+        return false;
+    *value = static_cast<off_t>(number);
+    return true;
+}
+
+bool FileSender::getRequestedRanges(std::vector<ByteRange> *ranges) const {
+    ranges->clear();
+    if (CgiEnvironment::getRequestMethod() != "GET")
+        return false;
+
+    std::string range = CgiEnvironment::getenvAsString("HTTP_RANGE");
+    if (range.size() < 6 || !JlweUtils::compareStringsNoCase(range.substr(0, 6), "bytes="))
+        return false;
+
+    // If-Range means only send part of the file if it hasn't changed, otherwise send the whole thing
+    std::string ifRange = CgiEnvironment::getenvAsString("HTTP_IF_RANGE");
+    JlweUtils::trimString(ifRange);
+    if (ifRange.size()) {
+        if (ifRange.at(0) == '"' || ifRange.compare(0, 2, "W/") == 0) {
+            // If-Range uses the strong comparison, so a weak ETag never matches
+            if (ifRange != this->getETag())
+                return false;
+        } else if (JlweUtils::httpDateToTime(ifRange) != this->fileInfo.st_mtime) {
+            return false;
+        }
+    }
+
+    const off_t fileSize = this->fileInfo.st_size;
+    std::vector<std::string> specs = JlweUtils::splitString(range.substr(6), ',');
+    if (specs.size() > MAX_RANGES)
+        return false;
+
+    for (std::string &spec : specs) {
+        JlweUtils::trimString(spec);
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos)
+            return false;
+        std::string first = spec.substr(0, dash);
+        std::string last = spec.substr(dash + 1);
+
+        ByteRange byteRange;
+        if (first.empty()) {
+            // "-500" means the last 500 bytes
+            off_t suffixLength;
+            if (!parseRangeNumber(last, &suffixLength))
+                return false;
+            if (suffixLength == 0 || fileSize == 0)
+                continue;
+            byteRange.start = (suffixLength < fileSize) ? fileSize - suffixLength : 0;
+            byteRange.end = fileSize - 1;
+        } else {
+            if (!parseRangeNumber(first, &byteRange.start))
+                return false;
+            if (last.empty()) {
+                byteRange.end = fileSize - 1;
+            } else {
+                if (!parseRangeNumber(last, &byteRange.end) || byteRange.end < byteRange.start)
+                    return false;
+                byteRange.end = std::min(byteRange.end, fileSize - 1);
+            }
+            if (byteRange.start >= fileSize)
+                continue;
+        }
+        ranges->push_back(byteRange);
+    }
+
+    // Sort and merge overlapping or adjacent ranges, so no part of the file is sent twice
+    std::sort(ranges->begin(), ranges->end(), [](const ByteRange &a, const ByteRange &b) {
+        return a.start < b.start;
+    });
+    std::vector<ByteRange> merged;
+    for (const ByteRange &byteRange : *ranges) {
+        if (merged.size() && byteRange.start <= merged.back().end + 1) {
+            merged.back().end = std::max(merged.back().end, byteRange.end);
+        } else {
+            merged.push_back(byteRange);
+        }
+    }
+    *ranges = merged;
+    return true;
+}
+
+void FileSender::writeFileHeaders() {
+    std::cout << "ETag: " << this->getETag() << "\r\n";
+    std::cout << "Last-Modified: " << JlweUtils::timeToHttpDate(this->fileInfo.st_mtime) << "\r\n";
+    if (this->cacheControl.size())
+        std::cout << "Cache-Control: " << this->cacheControl << "\r\n";
+    for (const auto &header : this->headers)
+        std::cout << header.first << ": " << header.second << "\r\n";
+}
+
+int FileSender::send() {
+    if (this->isNotModified()) {
+        std::cout << "Status: 304 Not Modified\r\n";
+        this->writeFileHeaders();
+        std::cout << "\r\n";
+        return 304;
+    }
+
+    if (this->deliveryMode != DELIVERY_DIRECT) {
+        // The web server sends the file (and deals with any Range header), so only the headers are needed here
+        if (this->contentType.size())
+            std::cout << "Content-Type: " << this->contentType << "\r\n";
+        this->writeFileHeaders();
+        std::cout << (this->deliveryMode == DELIVERY_X_SENDFILE ? "X-Sendfile: " : "X-Accel-Redirect: ") << this->serverPath << "\r\n";
+        std::cout << "\r\n";
+        return 200;
+    }
+
+    const off_t fileSize = this->fileInfo.st_size;
+    std::vector<ByteRange> ranges;
+    if (!this->getRequestedRanges(&ranges)) {
+        // Send the whole file
+        if (this->contentType.size())
+            std::cout << "Content-Type: " << this->contentType << "\r\n";
+        std::cout << "Content-Length: " << fileSize << "\r\n";
+        std::cout << "Accept-Ranges: bytes\r\n";
+        this->writeFileHeaders();
+        std::cout << "\r\n";
+        this->writeFileData(0, fileSize);
+        return 200;
+    }
+
+    if (ranges.empty()) {
+        std::cout << "Status: 416 Range Not Satisfiable\r\n";
+        std::cout << "Content-Range: bytes */" << fileSize << "\r\n";
+        std::cout << "Content-Length: 0\r\n";
+        this->writeFileHeaders();
+        std::cout << "\r\n";
+        return 416;
+    }
+
+    if (ranges.size() == 1) {
+        const ByteRange &byteRange = ranges.at(0);
+        std::cout << "Status: 206 Partial Content\r\n";
+        if (this->contentType.size())
+            std::cout << "Content-Type: " << this->contentType << "\r\n";
+        std::cout << "Content-Range: bytes " << byteRange.start << "-" << byteRange.end << "/" << fileSize << "\r\n";
+        std::cout << "Content-Length: " << (byteRange.end - byteRange.start + 1) << "\r\n";
+        std::cout << "Accept-Ranges: bytes\r\n";
+        this->writeFileHeaders();
+        std::cout << "\r\n";
+        this->writeFileData(byteRange.start, byteRange.end - byteRange.start + 1);
+        return 206;
+    }
+
+    // More than one range, each one is sent as a part of a multipart/byteranges body
+    std::string boundary = JlweUtils::makeRandomToken(24);
+    std::vector<std::string> partHeaders;
+    off_t contentLength = 0;
+    for (const ByteRange &byteRange : ranges) {
+        std::string partHeader = "\r\n--" + boundary + "\r\n";
+        if (this->contentType.size())
+            partHeader += "Content-Type: " + this->contentType + "\r\n";
+        partHeader += "Content-Range: bytes " + std::to_string(byteRange.start) + "-" + std::to_string(byteRange.end) + "/" + std::to_string(fileSize) + "\r\n\r\n";
+        contentLength += static_cast<off_t>(partHeader.size()) + (byteRange.end - byteRange.start + 1);
+        partHeaders.push_back(partHeader);
+    }
+    std::string closing = "\r\n--" + boundary + "--\r\n";
+    contentLength += static_cast<off_t>(closing.size());
+
+    std::cout << "Status: 206 Partial Content\r\n";
+    std::cout << "Content-Type: multipart/byteranges; boundary=" << boundary << "\r\n";
+    std::cout << "Content-Length: " << contentLength << "\r\n";
+    std::cout << "Accept-Ranges: bytes\r\n";
+    this->writeFileHeaders();
+    std::cout << "\r\n";
+    for (size_t i = 0; i < ranges.size(); i++) {
+        std::cout << partHeaders.at(i);
+        this->writeFileData(ranges.at(i).start, ranges.at(i).end - ranges.at(i).start + 1);
+    }
+    std::cout << closing;
+    return 206;
+}
+
+void FileSender::writeFileData(off_t start, off_t length) {
+    if (!RequestLoop::isPersistent()) {
+        // Anything written to cout has to go out before the file data
+        std::cout.flush();
+        fflush(stdout);
+
+        while (length > 0) {
+            ssize_t sent = sendfile(STDOUT_FILENO, this->fd, &start, static_cast<size_t>(length));
+            if (sent < 0 && errno == EINTR)
+                continue;
+            if (sent <= 0)
+                break; // sendfile isn't supported for this output, use pread for the rest
+            length -= sent;
+        }
+    }
+
+    char buffer[BUFFER_SIZE];
+    while (length > 0) {
+        ssize_t size = pread(this->fd, buffer, static_cast<size_t>(std::min<off_t>(length, BUFFER_SIZE)), start);
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size <= 0)
+            break;
+        std::cout.write(buffer, size);
+        start += size;
+        length -= size;
+    }
+}
@@ -0,0 +1,166 @@
+/**
+  @file    FileSender.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Sends a file from the server's filesystem as the HTTP response
+  Adds ETag and Last-Modified headers, and answers conditional requests (If-None-Match/If-Modified-Since)
+  with 304 Not Modified so browsers that already have the file don't download it again
+  Range requests are answered with 206 Partial Content, so interrupted downloads can be resumed
+  The file can either be sent by this process, or handed over to the web server with an X-Sendfile or X-Accel-Redirect header
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef FILESENDER_H
+#define FILESENDER_H
+
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+#include "../ext/nlohmann/json.hpp"
+
+class FileSender {
+public:
+
+    // How the file data gets to the browser
+    enum DeliveryMode {
+        DELIVERY_DIRECT,          // This process sends the file (with sendfile where possible)
+        DELIVERY_X_SENDFILE,      // The web server sends the file named in the X-Sendfile header (Apache mod_xsendfile, lighttpd)
+        DELIVERY_X_ACCEL_REDIRECT // The web server sends the internal URI in the X-Accel-Redirect header (nginx)
+    };
+
+    /*!
+     * \brief Constructor for FileSender. Opens the file.
+     *
+     * \param filename The full path of the file to send
+     */
+    FileSender(const std::string &filename);
+
+    /*!
+     * \brief Destructor for FileSender. Closes the file.
+     */
+    ~FileSender();
+
+    /*!
+     * \brief Checks if the file was opened.
+     *
+     * \return True if the file exists and is a regular file
+     */
+    bool isOpen() const;
+
+    /*!
+     * \brief Sets the Content-Type header.
+     *
+     * \param contentType The MIME type of the file
+     */
+    void setContentType(const std::string &contentType);
+
+    /*!
+     * \brief Sets the Cache-Control header.
+     *
+     * \param cacheControl The Cache-Control value, eg. "public, no-cache"
+     */
+    void setCacheControl(const std::string &cacheControl);
+
+    /*!
+     * \brief Adds a HTTP header to the response.
+     *
+     * \param name The header name, eg. "Content-Disposition"
+     * \param value The header value
+     */
+    void setHeader(const std::string &name, const std::string &value);
+
+    /*!
+     * \brief Sets how the file is delivered. The default is DELIVERY_DIRECT.
+     *
+     * \param mode The delivery mode
+     * \param serverPath The path or URI given to the web server, for X-Sendfile this is the full path of the file,
+     *                   for X-Accel-Redirect it is the internal URI that the web server maps to the file
+     */
+    void setDeliveryMode(DeliveryMode mode, const std::string &serverPath);
+
+    /*!
+     * \brief Sets the delivery mode from the "files" section of the config file (deliveryMode and accelRedirectPrefix).
+     *
+     * Files outside the file manager directory are always delivered directly.
+     *
+     * \param config The JSON config object from JlweCore
+     */
+    void setDeliveryFromConfig(const nlohmann::json &config);
+
+    /*!
+     * \brief Makes a strong ETag for the file from its inode, size and modified time.
+     *
+     * \return The ETag, including the quotes
+     */
+    std::string getETag() const;
+
+    /*!
+     * \brief Sends the headers and file to cout.
+     *
+     * If the request has an If-None-Match or If-Modified-Since header that matches the file,
+     * only the headers are sent with a 304 status.
+     * If the request has a Range header (and If-Range, if given, matches the file) only the requested
+     * parts of the file are sent with a 206 status. More than one range is sent as multipart/byteranges.
+     * If the file is delegated to the web server only the headers are sent, the web server handles any ranges.
+     *
+     * \return The HTTP status code that was sent (200, 206, 304 or 416)
+     */
+    int send();
+
+private:
+
+    // A range of bytes in the file, end is inclusive like in the Range header
+    struct ByteRange {
+        off_t start;
+        off_t end;
+    };
+
+    /*!
+     * \brief Checks the conditional request headers against the file.
+     *
+     * \return True if the browser's copy of the file is up to date
+     */
+    bool isNotModified() const;
+
+    /*!
+     * \brief Reads the Range and If-Range headers of the request.
+     *
+     * \param ranges Set to the list of satisfiable ranges, sorted and with overlapping ranges merged
+     * \return False if the whole file should be sent (no Range header, or it should be ignored)
+     */
+    bool getRequestedRanges(std::vector<ByteRange> *ranges) const;
+
+    /*!
+     * \brief Writes the headers that describe the file (ETag, Last-Modified, Cache-Control and the extra headers)
+     */
+    void writeFileHeaders();
+
+    /*!
+     * \brief Writes part of the file to the output.
+     *
+     * Uses sendfile to copy straight from the file to stdout when running as a normal CGI script,
+     * otherwise the data is read with pread and written to cout.
+     *
+     * \param start The offset of the first byte to send
+     * \param length The number of bytes to send
+     */
+    void writeFileData(off_t start, off_t length);
+
+    int fd;
+    struct stat fileInfo;
+    std::string filename;
+    DeliveryMode deliveryMode;
+    std::string serverPath;
+    std::string contentType;
+    std::string cacheControl;
+    std::vector<std::pair<std::string, std::string>> headers;
+
+};
+
+#endif // FILESENDER_H
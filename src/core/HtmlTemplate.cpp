@@ -5,19 +5,24 @@
 
   @section DESCRIPTION
   This class creates the HTML header and footer on every page of the website
-  The template is read from a file
+  The template is read from a file, and the location of the placeholders in it is found once and cached
+  The menu is also cached until the webpage_menu table changes, and shared with other processes through SharedCache
 
   This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
   https://github.com/laighside/SAGeocachingJuneLWE
  */
 #include "HtmlTemplate.h"
 
+#include <algorithm>
 #include <iostream>  // cout
-#include <regex>     // regex for detecting mobile browsers
+#include <sstream>
+#include <sys/stat.h>
 
 #include "CgiEnvironment.h"
 #include "Encoder.h"
 #include "JlweUtils.h"
+#include "MobileDetect.h"
+#include "SharedCache.h"
 
 
 // html template file for making the header and footer of every page
@@ -26,46 +31,100 @@
 // html template file for mobile browsers
 #define TEMPLATE_MOBLIE "/mobile_template.html"
 
-// Regex for detecting moblie browers. A match on either 1 OR 2 means it is a mobile browser.
-#define MOBILE_REGEX_1  "(android|bb\\d+|meego).+mobile|avantgo|bada\\/|blackberry|blazer|compal|elaine|fennec|hiptop|iemobile|ip(hone|od)|iris|kindle|lge\\ |maemo|midp|mmp|mobile.+firefox|netfront|opera\\ m(ob|in)i|palm(\\ os)?|phone|p(ixi|re)\\/|plucker|pocket|psp|series(4|6)0|symbian|treo|up\\.(browser|link)|vodafone|wap|windows\\ ce|xda|xiino"
-#define MOBILE_REGEX_2  "^(1207|6310|6590|3gso|4thp|50[1-6]i|770s|802s|a\\ wa|abac|ac(er|oo|s\\-)|ai(ko|rn)|al(av|ca|co)|amoi|an(ex|ny|yw)|aptu|ar(ch|go)|as(te|us)|attw|au(di|\\-m|r\\ |s\\ )|avan|be(ck|ll|nq)|bi(lb|rd)|bl(ac|az)|br(e|v)w|bumb|bw\\-(n|u)|c55\\/|capi|ccwa|cdm\\-|cell|chtm|cldc|cmd\\-|co(mp|nd)|craw|da(it|ll|ng)|dbte|dc\\-s|devi|dica|dmob|do(c|p)o|ds(12|\\-d)|el(49|ai)|em(l2|ul)|er(ic|k0)|esl8|ez([4-7]0|os|wa|ze)|fetc|fly(\\-|_)|g1\\ u|g560|gene|gf\\-5|g\\-mo|go(\\.w|od)|gr(ad|un)|haie|hcit|hd\\-(m|p|t)|hei\\-|hi(pt|ta)|hp(\\ i|ip)|hs\\-c|ht(c(\\-|\\ |_|a|g|p|s|t)|tp)|hu(aw|tc)|i\\-(20|go|ma)|i230|iac(\\ |\\-|\\/)|ibro|idea|ig01|ikom|im1k|inno|ipaq|iris|ja(t|v)a|jbro|jemu|jigs|kddi|keji|kgt(\\ |\\/)|klon|kpt\\ |kwc\\-|kyo(c|k)|le(no|xi)|lg(\\ g|\\/(k|l|u)|50|54|\\-[a-w])|libw|lynx|m1\\-w|m3ga|m50\\/|ma(te|ui|xo)|mc(01|21|ca)|m\\-cr|me(rc|ri)|mi(o8|oa|ts)|mmef|mo(01|02|bi|de|do|t(\\-|\\ |o|v)|zz)|mt(50|p1|v\\ )|mwbp|mywa|n10[0-2]|n20[2-3]|n30(0|2)|n50(0|2|5)|n7(0(0|1)|10)|ne((c|m)\\-|on|tf|wf|wg|wt)|nok(6|i)|nzph|o2im|op(ti|wv)|oran|owg1|p800|pan(a|d|t)|pdxg|pg(13|\\-([1-8]|c))|phil|pire|pl(ay|uc)|pn\\-2|po(ck|rt|se)|prox|psio|pt\\-g|qa\\-a|qc(07|12|21|32|60|\\-[2-7]|i\\-)|qtek|r380|r600|raks|rim9|ro(ve|zo)|s55\\/|sa(ge|ma|mm|ms|ny|va)|sc(01|h\\-|oo|p\\-)|sdk\\/|se(c(\\-|0|1)|47|mc|nd|ri)|sgh\\-|shar|sie(\\-|m)|sk\\-0|sl(45|id)|sm(al|ar|b3|it|t5)|so(ft|ny)|sp(01|h\\-|v\\-|v\\ )|sy(01|mb)|t2(18|50)|t6(00|10|18)|ta(gt|lk)|tcl\\-|tdg\\-|tel(i|m)|tim\\-|t\\-mo|to(pl|sh)|ts(70|m\\-|m3|m5)|tx\\-9|up(\\.b|g1|si)|utst|v400|v750|veri|vi(rg|te)|vk(40|5[0-3]|\\-v)|vm40|voda|vulc|vx(52|53|60|61|70|80|81|83|85|98)|w3c(\\-|\\ )|webc|whit|wi(g\\ |nc|nw)|wmlb|wonu|x700|yas\\-|your|zeto|zte\\-)"
+// The div that the page content goes in
+#define CONTENT_DIV  "<div id=\"content\">"
 
 struct menuItem {
     std::string text;
     std::string url;
+    std::vector<menuItem> children;
 };
 
+std::unordered_map<std::string, HtmlTemplate::CompiledTemplate> HtmlTemplate::templateCache;
+HtmlTemplate::MenuCache HtmlTemplate::desktopMenuCache = {false, 0, ""};
+HtmlTemplate::MenuCache HtmlTemplate::mobileMenuCache = {false, 0, ""};
+
 HtmlTemplate::HtmlTemplate(bool allowMobile) {
     this->useMobile = (isMobileBrowser() && allowMobile);
-    this->templatePath = CgiEnvironment::getDocumentRoot() + (this->useMobile ? TEMPLATE_MOBLIE : TEMPLATE_PATH);
+    this->templatePath = getTemplatePath(this->useMobile);
+    this->compiledTemplate = nullptr;
+    this->out = &std::cout;
+    this->useMenuCache = true;
 }
 
 HtmlTemplate::~HtmlTemplate() {
     // do nothing
 }
 
-std::string HtmlTemplate::makeMenuHTML(JlweCore *jlwe, bool mobile) {
+std::string HtmlTemplate::getTemplatePath(bool mobile) {
+    return CgiEnvironment::getDocumentRoot() + (mobile ? TEMPLATE_MOBLIE : TEMPLATE_PATH);
+}
+
+std::string HtmlTemplate::makeMenuHTML(JlweCore *jlwe, bool mobile, bool loggedIn, bool useCache) {
+    std::string result;
+    if (useCache) {
+        // The menu only changes when the webpage_menu table does, so a persistent worker can reuse it
+        MenuCache &cache = mobile ? mobileMenuCache : desktopMenuCache;
+        unsigned long long version = jlwe->getDataVersion("webpage_menu");
+        if (!cache.valid || cache.version != version) {
+            std::string sharedName = mobile ? "menu_mobile" : "menu_desktop";
+            if (!SharedCache::get(sharedName, version, &cache.html)) {
+                cache.html = renderMenuHTML(jlwe, mobile);
+                SharedCache::put(sharedName, version, cache.html);
+            }
+            cache.version = version;
+            cache.valid = true;
+        }
+        result = cache.html;
+    } else {
+        result = renderMenuHTML(jlwe, mobile);
+    }
+
+    if (!mobile)
+        return result;
+
+    // The end of the mobile menu depends on the user so it can't be cached
+    if (loggedIn) {
+        result += "<a href=\"/cgi-bin/admin_index.cgi\">Admin Area</a>\n";
+    } else {
+        result += "<a href=\"/login.html\">Admin Login</a>\n";
+    }
+    result += "</div>\n";
+    return result;
+}
+
+std::string HtmlTemplate::renderMenuHTML(JlweCore *jlwe, bool mobile) {
     std::vector<menuItem> rootList;
+    std::vector<std::pair<std::string, menuItem>> childList;
 
-    sql::PreparedStatement *prep_stmt;
+    // Get the whole menu in one query, then sort the items into their parents
+    sql::Statement *stmt;
     sql::ResultSet *res;
-    prep_stmt = jlwe->getMysqlCon()->prepareStatement("SELECT link_text, link_url FROM webpage_menu WHERE parent = ? ORDER BY menu_order;");
-    prep_stmt->setString(1, "*root*");
-    res = prep_stmt->executeQuery();
+    stmt = jlwe->getMysqlCon()->createStatement();
+    res = stmt->executeQuery("SELECT link_text, link_url, parent FROM webpage_menu ORDER BY menu_order;");
     while (res->next()){
-        rootList.push_back({res->getString(1), res->getString(2)});
+        std::string parent = res->getString(3);
+        if (parent == "*root*") {
+            rootList.push_back({res->getString(1), res->getString(2), {}});
+        } else {
+            childList.push_back({parent, {res->getString(1), res->getString(2), {}}});
+        }
     }
     delete res;
+    delete stmt;
+
+    for (unsigned int i = 0; i < childList.size(); i++) {
+        for (unsigned int j = 0; j < rootList.size(); j++) {
+            if (rootList.at(j).text == childList.at(i).first) {
+                rootList.at(j).children.push_back(childList.at(i).second);
+                break;
+            }
+        }
+    }
 
     std::string result = mobile ? "<div id=\"page_menu\">\n" : "<ul>";
     for (unsigned int i = 0; i < rootList.size(); i++) {
-        std::vector<menuItem> innerList;
-        prep_stmt->setString(1, rootList.at(i).text);
-        res = prep_stmt->executeQuery();
-        while (res->next()){
-            innerList.push_back({res->getString(1), res->getString(2)});
-        }
-        delete res;
+        const std::vector<menuItem> &innerList = rootList.at(i).children;
 
         result += mobile ? "" : "<li>";
         if (innerList.size()) {
@@ -97,16 +156,10 @@ std::string HtmlTemplate::makeMenuHTML(JlweCore *jlwe, bool mobile) {
         result += mobile ? "" : "</li>";
 
     }
-    if (mobile) {
-        if (jlwe->isLoggedIn()) {
-            result += "<a href=\"/cgi-bin/admin_index.cgi\">Admin Area</a>\n";
-        } else {
-            result += "<a href=\"/login.html\">Admin Login</a>\n";
-        }
-    }
-    result += mobile ? "</div>\n" : "</ul>";
+    // The mobile menu is finished by makeMenuHTML()
+    if (!mobile)
+        result += "</ul>";
 
-    delete prep_stmt;
     return result;
 }
 
@@ -117,46 +170,117 @@ std::string HtmlTemplate::getLoginHtml(const std::string &username) {
 }
 
 bool HtmlTemplate::isMobileBrowser() {
-    std::string user_agent = CgiEnvironment::getUserAgent();
-    std::regex regex1(MOBILE_REGEX_1, std::regex_constants::icase);
-    std::regex regex2(MOBILE_REGEX_2, std::regex_constants::icase);
-    if (std::regex_search(user_agent, regex1) || std::regex_search(user_agent, regex2)) {
-        return true;
-    }
-    return false;
+    return MobileDetect::isMobileUserAgent(CgiEnvironment::getUserAgent());
 }
 
 void HtmlTemplate::outputHttpHtmlHeader() {
     std::cout << "Content-type:text/html\r\n\r\n";
 }
 
+const HtmlTemplate::CompiledTemplate * HtmlTemplate::loadTemplate(const std::string &path) {
+    struct stat file_info;
+    time_t modified = 0;
+    if (stat(path.c_str(), &file_info) == 0)
+        modified = file_info.st_mtime;
+
+    // Use the cached copy if the file hasn't changed
+    auto it = templateCache.find(path);
+    if (it != templateCache.end() && it->second.modifiedTime == modified)
+        return &it->second;
+
+    CompiledTemplate compiled;
+    compiled.modifiedTime = modified;
+    compiled.html = JlweUtils::readFileToString(path.c_str());
+    if (compiled.html.size() == 0)
+        return nullptr;
+
+    const std::pair<std::string, SlotType> placeholders[] = {{"**TITLE**", SLOT_TITLE}, {"**LOGIN**", SLOT_LOGIN}, {"**MENU**", SLOT_MENU}};
+    for (const auto &placeholder : placeholders) {
+        size_t pos = 0;
+        while ((pos = compiled.html.find(placeholder.first, pos)) != std::string::npos) {
+            compiled.slots.push_back({pos, placeholder.first.size(), placeholder.second});
+            pos += placeholder.first.size();
+        }
+    }
+    std::sort(compiled.slots.begin(), compiled.slots.end(), [](const Slot &a, const Slot &b) -> bool {
+        return a.offset < b.offset;
+    });
+
+    compiled.contentIndex = compiled.html.find(CONTENT_DIV);
+    if (compiled.contentIndex == std::string::npos) {
+        compiled.contentIndex = compiled.html.size();
+    } else {
+        compiled.contentIndex += std::string(CONTENT_DIV).size();
+    }
+
+    compiled.noteStart = std::string::npos;
+    compiled.noteEnd = std::string::npos;
+    size_t note_id_index = compiled.html.find("id=\"header-note\"");
+    if (note_id_index != std::string::npos) {
+        size_t note_index = compiled.html.rfind("<ul", note_id_index);
+        size_t note_index_end = compiled.html.find("</ul>", note_id_index);
+        if (note_index != std::string::npos && note_index_end != std::string::npos) {
+            compiled.noteStart = note_index;
+            compiled.noteEnd = note_index_end + 5;
+        }
+    }
+
+    templateCache[path] = compiled;
+    return &templateCache[path];
+}
+
+void HtmlTemplate::writeTemplateRange(size_t start, size_t end) {
+    const std::string &html = this->compiledTemplate->html;
+    size_t pos = start;
+    for (const Slot &slot : this->compiledTemplate->slots) {
+        if (slot.offset < pos)
+            continue;
+        if (slot.offset + slot.length > end)
+            break;
+
+        this->out->write(html.data() + pos, static_cast<std::streamsize>(slot.offset - pos));
+        switch (slot.type) {
+        case SLOT_TITLE: *this->out << this->titleHtml; break;
+        case SLOT_LOGIN: *this->out << this->loginHtml; break;
+        case SLOT_MENU:  *this->out << this->menuHtml;  break;
+        }
+        pos = slot.offset + slot.length;
+    }
+    this->out->write(html.data() + pos, static_cast<std::streamsize>(end - pos));
+}
+
 bool HtmlTemplate::outputHeader(JlweCore *jlwe, const std::string &title, bool note) {
-    this->html = JlweUtils::readFileToString(this->templatePath.c_str());
-    if (this->html.size() == 0) {
-        std::cout << "<html>\nFile not found on server: " << this->templatePath << "\n</html>";
+    return this->writeHeader(jlwe, title, note, jlwe->getCurrentUsername(), jlwe->isLoggedIn());
+}
+
+bool HtmlTemplate::writeHeader(JlweCore *jlwe, const std::string &title, bool note, const std::string &username, bool loggedIn) {
+    this->compiledTemplate = loadTemplate(this->templatePath);
+    if (this->compiledTemplate == nullptr) {
+        *this->out << "<html>\nFile not found on server: " << this->templatePath << "\n</html>";
         return false;
     }
 
-    this->html = JlweUtils::replaceString(this->html, "**TITLE**", Encoder::htmlEntityEncode(title));
-    this->html = JlweUtils::replaceString(this->html, "**LOGIN**", this->getLoginHtml(jlwe->getCurrentUsername()));
-    this->html = JlweUtils::replaceString(this->html, "**MENU**", this->makeMenuHTML(jlwe, this->useMobile));
+    this->titleHtml = Encoder::htmlEntityEncode(title);
+    this->loginHtml = this->getLoginHtml(username);
+    this->menuHtml = this->makeMenuHTML(jlwe, this->useMobile, loggedIn, this->useMenuCache);
 
-    size_t content_index = this->html.find("<div id=\"content\">") + 18;
-    size_t note_id_index = this->html.find("id=\"header-note\"");
-    if (note || note_id_index == std::string::npos) {
-        std::cout << this->html.substr(0, content_index) << "\n";
+    size_t content_index = this->compiledTemplate->contentIndex;
+    if (note || this->compiledTemplate->noteStart == std::string::npos) {
+        this->writeTemplateRange(0, content_index);
+        *this->out << "\n";
     } else {
-        size_t note_index = this->html.rfind("<ul", note_id_index);
-        size_t note_index_end = this->html.find("</ul>", note_id_index) + 5;
-        std::cout << this->html.substr(0, note_index) << "\n";
-        std::cout << this->html.substr(note_index_end, content_index - note_index_end) << "\n";
+        this->writeTemplateRange(0, this->compiledTemplate->noteStart);
+        *this->out << "\n";
+        this->writeTemplateRange(this->compiledTemplate->noteEnd, content_index);
+        *this->out << "\n";
     }
     return true;
 }
 
 void HtmlTemplate::outputFooter() {
-    size_t content_index = this->html.find("<div id=\"content\">") + 18;
-    std::cout << this->html.substr(content_index);
+    if (this->compiledTemplate == nullptr)
+        return;
+    this->writeTemplateRange(this->compiledTemplate->contentIndex, this->compiledTemplate->html.size());
 }
 
 void HtmlTemplate::outputPageWithMessage(JlweCore *jlwe, const std::string &message, const std::string &title) {
@@ -170,6 +294,23 @@ void HtmlTemplate::outputPageWithMessage(JlweCore *jlwe, const std::string &mess
     instance.outputFooter();
 }
 
+std::string HtmlTemplate::renderPage(JlweCore *jlwe, const std::string &title, bool note, const std::string &content, bool mobile) {
+    std::ostringstream page;
+    HtmlTemplate instance(false);
+    instance.useMobile = mobile;
+    instance.templatePath = getTemplatePath(mobile);
+    instance.out = &page;
+    // The static pages record the menu version they were published with, so they need the menu as it is now
+    instance.useMenuCache = false;
+
+    // Pages are the same for everyone who isn't logged in
+    if (!instance.writeHeader(jlwe, title, note, "", false))
+        return "";
+    page << content;
+    instance.outputFooter();
+    return page.str();
+}
+
 void HtmlTemplate::outputAdminMenu() {
     std::cout << "<h1 style=\"text-align:center;\">JLWE Admin area</h1>\n";
     std::cout << "<div id=\"admin_menu\">\n<ul>\n";
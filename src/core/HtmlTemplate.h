@@ -5,7 +5,8 @@
 
   @section DESCRIPTION
   This class creates the HTML header and footer on every page of the website
-  The template is read from a file
+  The template is read from a file, and the location of the placeholders in it is found once and cached
+  The menu is also cached until the webpage_menu table changes
 
   This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
   https://github.com/laighside/SAGeocachingJuneLWE
@@ -13,7 +14,11 @@
 #ifndef HTMLTEMPLATE_H
 #define HTMLTEMPLATE_H
 
+#include <ctime>
+#include <ostream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "JlweCore.h"
 
@@ -64,6 +69,28 @@ public:
      */
     static void outputPageWithMessage(JlweCore *jlwe, const std::string &message, const std::string &title);
 
+    /*!
+     * \brief Makes a complete page as it is seen by someone who isn't logged in, as a string.
+     *
+     * Used to make the pre-rendered copies of the public pages (see StaticPages).
+     *
+     * \param jlwe JlweCore object (for the menu)
+     * \param title The title of the page
+     * \param note Set to true to include the "header-note" div on the page
+     * \param content The HTML that goes in the content div
+     * \param mobile Set to true to use the mobile template, false for the desktop one
+     * \return The page HTML, or an empty string if the template file couldn't be read
+     */
+    static std::string renderPage(JlweCore *jlwe, const std::string &title, bool note, const std::string &content, bool mobile);
+
+    /*!
+     * \brief Gets the path of the template file.
+     *
+     * \param mobile Set to true for the mobile template, false for the desktop one
+     * \return The full path of the template file
+     */
+    static std::string getTemplatePath(bool mobile);
+
     /*!
      * \brief Writes the HTML to create the admin menu to cout.
      */
@@ -71,19 +98,63 @@ public:
 
 private:
 
+    // The placeholders that can be in the template file
+    enum SlotType {
+        SLOT_TITLE,
+        SLOT_LOGIN,
+        SLOT_MENU
+    };
+
+    struct Slot {
+        size_t offset;
+        size_t length;
+        SlotType type;
+    };
+
+    // A template file with the location of everything that is replaced or removed
+    struct CompiledTemplate {
+        time_t modifiedTime;
+        std::string html;
+        std::vector<Slot> slots; // in order of offset
+        size_t contentIndex;     // the end of <div id="content">, where the page content goes
+        size_t noteStart;        // the <ul> containing the header-note, npos if there isn't one
+        size_t noteEnd;
+    };
+
+    // The menu HTML, as rendered from the webpage_menu table
+    struct MenuCache {
+        bool valid;
+        unsigned long long version;
+        std::string html;
+    };
+
     static inline std::string checkBlankLink(const std::string &url) {
         if (url.size())
             return url;
         return "javascript:void(0);";
     }
 
-    std::string makeMenuHTML(JlweCore *jlwe, bool mobile);
+    bool writeHeader(JlweCore *jlwe, const std::string &title, bool note, const std::string &username, bool loggedIn);
+    std::string makeMenuHTML(JlweCore *jlwe, bool mobile, bool loggedIn, bool useCache);
+    static std::string renderMenuHTML(JlweCore *jlwe, bool mobile);
     static bool isMobileBrowser();
     static std::string getLoginHtml(const std::string &username);
+    static const CompiledTemplate * loadTemplate(const std::string &path);
+    void writeTemplateRange(size_t start, size_t end);
+
+    // Shared by every HtmlTemplate object in this process, keyed by file path
+    static std::unordered_map<std::string, CompiledTemplate> templateCache;
+    static MenuCache desktopMenuCache;
+    static MenuCache mobileMenuCache;
 
     bool useMobile;
     std::string templatePath;
-    std::string html;
+    std::ostream *out; // where the page is written, std::cout unless making a page with renderPage()
+    bool useMenuCache; // false to read the menu from the database, even if it is cached
+    const CompiledTemplate *compiledTemplate;
+    std::string titleHtml;
+    std::string loginHtml;
+    std::string menuHtml;
 
 };
 
@@ -10,6 +10,9 @@
    - Reads the cookies and finds if the user is logged in
    - Gets the permissions for the current user
 
+  The config and MySQL connection are kept for the life of the process, so when running
+  as a persistent worker (see RequestLoop) they are only loaded once, not on every request
+
   This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
   https://github.com/laighside/SAGeocachingJuneLWE
  */
@@ -20,12 +23,24 @@
 #include "CgiEnvironment.h"
 #include "KeyValueParser.h"
 #include "JlweUtils.h"
+#include "QueryProfiler.h"
+#include "RequestLoop.h"
+#include "SharedCache.h"
 
 // This is where the configuration file is stored
 #ifndef CONFIG_FILE
 #define CONFIG_FILE  "/etc/jlwe/jlwe.json"
 #endif
 
+// Limit on the size of the session cache, expired sessions are removed when this is reached
+#define SESSION_CACHE_MAX_SIZE  1000
+
+nlohmann::json * JlweCore::sharedConfig = nullptr;
+MysqlConnectionPool * JlweCore::connectionPool = nullptr;
+std::unordered_map<std::string, size_t> * JlweCore::permissionIndex = nullptr;
+std::unordered_map<std::string, JlweCore::Session> * JlweCore::sessionCache = nullptr;
+JlweCore::VarsSnapshot * JlweCore::varsSnapshot = nullptr;
+
 JlweCore::JlweCore() {
     this->mysqlCon = nullptr;
     this->m_isLoggedIn = false;
@@ -33,9 +48,13 @@ JlweCore::JlweCore() {
     this->m_currentUserIP = CgiEnvironment::getRemoteAddr();
     this->m_currentUsername = "";
     this->m_currentUserEmail = "";
+    this->m_varsChecked = false;
+    this->m_dataVersionsLoaded = false;
 
-    // Load configuration file, ignoring comments in it
-    this->config = nlohmann::json::parse(JlweUtils::readFileToString(CONFIG_FILE), nullptr, true, true);
+    // Load configuration file
+    this->loadConfig();
+    QueryProfiler::beginRequest(this->config);
+    SharedCache::configure(this->config);
 
     // Connect to MySQL database
     this->connectToMysql();
@@ -45,14 +64,33 @@ JlweCore::JlweCore() {
 }
 
 JlweCore::~JlweCore() {
-    if (this->mysqlCon)
-        delete this->mysqlCon;
+    if (this->mysqlCon && connectionPool)
+        connectionPool->release(this->mysqlCon);
+
+    // A persistent worker keeps the connections open for the next request
+    if (connectionPool && !RequestLoop::isPersistent())
+        connectionPool->closeIdleConnections();
+
+    QueryProfiler::endRequest();
+}
+
+void JlweCore::loadConfig() {
+    if (sharedConfig == nullptr) {
+        // Ignore comments in the config file
+        sharedConfig = new nlohmann::json(nlohmann::json::parse(JlweUtils::readFileToString(CONFIG_FILE), nullptr, true, true));
+    }
+    this->config = *sharedConfig;
 }
 
 void JlweCore::connectToMysql() {
-    sql::Driver *driver = get_driver_instance();
-    this->mysqlCon = driver->connect(std::string(this->config.at("mysql").value("host", "localhost")).c_str(), std::string(this->config.at("mysql").at("username")).c_str(), std::string(this->config.at("mysql").value("password", "")).c_str());
-    this->mysqlCon->setSchema(std::string(this->config.at("mysql").at("database")).c_str());
+    if (connectionPool == nullptr) {
+        connectionPool = new MysqlConnectionPool(this->config.at("mysql").value("host", "localhost"),
+                                                 this->config.at("mysql").at("username"),
+                                                 this->config.at("mysql").value("password", ""),
+                                                 this->config.at("mysql").at("database"),
+                                                 this->config.at("mysql").value("healthCheckInterval", 30));
+    }
+    this->mysqlCon = connectionPool->acquire();
 }
 
 sql::Connection * JlweCore::getMysqlCon() const {
@@ -61,6 +99,10 @@ sql::Connection * JlweCore::getMysqlCon() const {
     return this->mysqlCon;
 }
 
+sql::PreparedStatement * JlweCore::getPreparedStatement(const std::string &sql) const {
+    return connectionPool->getPreparedStatement(this->getMysqlCon(), sql);
+}
+
 void JlweCore::loadUserDetails() {
     KeyValueParser cookies(CgiEnvironment::getCookies());
     std::string accessToken = cookies.getValue("accessToken");
@@ -68,45 +110,82 @@ void JlweCore::loadUserDetails() {
     if (!accessToken.size()) // if there is no cookie then we know the user isn't logged in
         return;
 
+    // Check for a recently loaded session (persistent workers only)
+    int sessionCacheSeconds = this->config.value("sessionCacheSeconds", 0);
+    time_t now = time(nullptr);
+    if (sessionCacheSeconds > 0 && sessionCache) {
+        auto it = sessionCache->find(accessToken);
+        if (it != sessionCache->end()) {
+            if (now - it->second.loadTime < sessionCacheSeconds) {
+                this->m_isLoggedIn = true;
+                this->m_currentUserId = it->second.userId;
+                this->m_currentUsername = it->second.username;
+                this->m_currentUserEmail = it->second.email;
+                this->userPermissions = it->second.permissions;
+                return;
+            }
+            sessionCache->erase(it);
+        }
+    }
+
+    // Get the user and all their permissions in one query, there is one row for each entry in permission_list
     sql::PreparedStatement *prep_stmt;
     sql::ResultSet *res;
-    std::string username = "";
-    prep_stmt = this->mysqlCon->prepareStatement("SELECT username FROM user_tokens WHERE token = ?;"); // AND ip_address = ?
+    prep_stmt = this->getPreparedStatement("SELECT users.user_id, users.username, users.email, permission_list.permission_id, user_permissions.value "
+                                           "FROM user_tokens INNER JOIN users ON users.username = user_tokens.username AND users.active = 1 "
+                                           "CROSS JOIN permission_list "
+                                           "LEFT JOIN user_permissions ON user_permissions.user = users.username AND user_permissions.permission = permission_list.permission_id "
+                                           "WHERE user_tokens.token = ? ORDER BY permission_list.permission_id;"); // AND ip_address = ?
     prep_stmt->setString(1, accessToken);
     //prep_stmt->setString(2, userIP);
     res = prep_stmt->executeQuery();
-    if (res->next()){
-        username = res->getString(1);
-    }
-    delete res;
-    delete prep_stmt;
-
-    if (!username.size()) // not logged in
-        return;
-
-    prep_stmt = this->mysqlCon->prepareStatement("SELECT user_id,username,email FROM users WHERE username = ? AND active = 1;");
-    prep_stmt->setString(1, username);
-    res = prep_stmt->executeQuery();
-    if (res->next()){
+    std::unordered_map<std::string, size_t> *newPermissionIndex = permissionIndex ? nullptr : new std::unordered_map<std::string, size_t>();
+    while (res->next()){
         this->m_isLoggedIn = true;
         this->m_currentUserId = res->getInt(1);
         this->m_currentUsername = res->getString(2);
-        this->m_currentUserEmail = res->getString(3);
+        this->m_currentUserEmail = res->isNull(3) ? "" : res->getString(3);
+
+        std::string permissionName = res->getString(4);
+        if (newPermissionIndex && newPermissionIndex->size() < MAX_PERMISSIONS)
+            newPermissionIndex->insert({permissionName, newPermissionIndex->size()});
+
+        if (!res->isNull(5) && res->getInt(5) == 1) {
+            std::unordered_map<std::string, size_t> *index = newPermissionIndex ? newPermissionIndex : permissionIndex;
+            auto it = index->find(permissionName);
+            if (it != index->end())
+                this->userPermissions.set(it->second);
+        }
     }
     delete res;
-    delete prep_stmt;
-
-    if (this->m_isLoggedIn) {
-        prep_stmt = this->mysqlCon->prepareStatement("SELECT permission FROM user_permissions WHERE user = ? AND value = 1;");
-        prep_stmt->setString(1, this->m_currentUsername);
-        res = prep_stmt->executeQuery();
-        while (res->next()){
-            this->userPermissions.push_back({res->getString(1), true});
+
+    // The permission list is only complete if the user is logged in (otherwise there were no rows)
+    if (newPermissionIndex) {
+        if (this->m_isLoggedIn) {
+            permissionIndex = newPermissionIndex;
+        } else {
+            delete newPermissionIndex;
         }
-        delete res;
-        delete prep_stmt;
     }
 
+    if (this->m_isLoggedIn && sessionCacheSeconds > 0) {
+        if (sessionCache == nullptr)
+            sessionCache = new std::unordered_map<std::string, Session>();
+
+        if (sessionCache->size() >= SESSION_CACHE_MAX_SIZE) {
+            for (auto it = sessionCache->begin(); it != sessionCache->end();) {
+                if (now - it->second.loadTime >= sessionCacheSeconds) {
+                    it = sessionCache->erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (sessionCache->size() >= SESSION_CACHE_MAX_SIZE)
+                sessionCache->clear();
+        }
+
+        (*sessionCache)[accessToken] = {now, this->m_currentUserId, this->m_currentUsername, this->m_currentUserEmail, this->userPermissions};
+    }
 }
 
 bool JlweCore::isLoggedIn() const {
@@ -130,11 +209,13 @@ std::string JlweCore::getCurrentUserEmail() const {
 }
 
 bool JlweCore::getPermissionValue(const std::string &permissionName) const {
-    for (size_t i = 0; i < this->userPermissions.size(); i++) {
-        if (this->userPermissions.at(i).name == permissionName)
-            return this->userPermissions.at(i).value;
-    }
-    return false;
+    if (!this->m_isLoggedIn || permissionIndex == nullptr)
+        return false;
+
+    auto it = permissionIndex->find(permissionName);
+    if (it == permissionIndex->end())
+        return false;
+    return this->userPermissions.test(it->second);
 }
 
 std::string JlweCore::getConfigFilename() const {
@@ -142,14 +223,92 @@ std::string JlweCore::getConfigFilename() const {
 }
 
 std::string JlweCore::getGlobalVar(const std::string& name) const {
-    std::string result = "";
-    sql::PreparedStatement *prep_stmt = this->mysqlCon->prepareStatement("SELECT value FROM vars WHERE name = ?;");
-    prep_stmt->setString(1, name);
-    sql::ResultSet *res = prep_stmt->executeQuery();
-    if (res->next()){
-        result = res->getString(1);
+    if (!this->m_varsChecked)
+        this->loadGlobalVars();
+
+    auto it = varsSnapshot->values.find(name);
+    if (it != varsSnapshot->values.end())
+        return it->second;
+    return "";
+}
+
+void JlweCore::invalidateGlobalVars() {
+    if (varsSnapshot) {
+        delete varsSnapshot;
+        varsSnapshot = nullptr;
     }
-    delete res;
-    delete prep_stmt;
-    return result;
+    this->m_varsChecked = false;
+    this->m_dataVersionsLoaded = false;
+    this->m_dataVersions.clear();
+    SharedCache::invalidate("vars");
+}
+
+void JlweCore::loadGlobalVars() const {
+    sql::PreparedStatement *prep_stmt;
+    sql::ResultSet *res;
+
+    // A persistent worker may still have the vars from a previous request,
+    // they only need reloading if another process has changed them since
+    unsigned long long version = this->getDataVersion("vars");
+    if (varsSnapshot && varsSnapshot->version == version && RequestLoop::isPersistent()) {
+        this->m_varsChecked = true;
+        return;
+    }
+
+    VarsSnapshot *snapshot = new VarsSnapshot();
+    snapshot->version = version;
+
+    // Another process may have loaded them recently
+    std::string cached;
+    bool loaded = false;
+    if (SharedCache::get("vars", version, &cached)) {
+        nlohmann::json vars = nlohmann::json::parse(cached, nullptr, false);
+        if (vars.is_object()) {
+            for (auto it = vars.begin(); it != vars.end(); ++it)
+                if (it->is_string())
+                    snapshot->values[it.key()] = it->get<std::string>();
+            loaded = true;
+        }
+    }
+
+    if (!loaded) {
+        try {
+            prep_stmt = this->getPreparedStatement("SELECT name, value FROM vars;");
+            res = prep_stmt->executeQuery();
+            while (res->next())
+                snapshot->values[res->getString(1)] = res->getString(2);
+            delete res;
+        } catch (...) {
+            delete snapshot;
+            throw;
+        }
+
+        if (SharedCache::isEnabled())
+            SharedCache::put("vars", version, nlohmann::json(snapshot->values).dump());
+    }
+
+    if (varsSnapshot)
+        delete varsSnapshot;
+    varsSnapshot = snapshot;
+    this->m_varsChecked = true;
+}
+
+unsigned long long JlweCore::getDataVersion(const std::string &name) const {
+    // Entries in the shared cache are also checked against the versions, as some data (eg. the menu) is only changed in SQL
+    if (!RequestLoop::isPersistent() && !SharedCache::isEnabled())
+        return 0;
+
+    if (!this->m_dataVersionsLoaded) {
+        sql::PreparedStatement *prep_stmt = this->getPreparedStatement("SELECT name, version FROM data_versions;");
+        sql::ResultSet *res = prep_stmt->executeQuery();
+        while (res->next())
+            this->m_dataVersions[res->getString(1)] = res->getUInt64(2);
+        delete res;
+        this->m_dataVersionsLoaded = true;
+    }
+
+    auto it = this->m_dataVersions.find(name);
+    if (it != this->m_dataVersions.end())
+        return it->second;
+    return 0;
 }
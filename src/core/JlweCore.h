@@ -10,13 +10,19 @@
    - Reads the cookies and finds if the user is logged in
    - Gets the permissions for the current user
 
+  The config and MySQL connection are kept for the life of the process, so when running
+  as a persistent worker (see RequestLoop) they are only loaded once, not on every request
+
   This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
   https://github.com/laighside/SAGeocachingJuneLWE
  */
 #ifndef JLWECORE_H
 #define JLWECORE_H
 
+#include <bitset>
+#include <ctime>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <mysql_driver.h>
@@ -30,6 +36,8 @@
 
 #include "../ext/nlohmann/json.hpp"
 
+#include "MysqlConnectionPool.h"
+
 class JlweCore {
 
 public:
@@ -64,14 +72,47 @@ public:
      */
     sql::Connection * getMysqlCon() const;
 
+    /*!
+     * \brief Gets a prepared statement for the given SQL from the statement cache of the MySQL connection.
+     *
+     * The statement is only prepared by the server the first time it is used by the connection.
+     * The statement is owned by the connection pool, do NOT delete it (the result set must still be deleted).
+     * Don't use this for a query that is run again while its previous result set is still being read.
+     *
+     * \param sql The SQL text of the statement
+     * \return The prepared statement, with its parameters cleared
+     */
+    sql::PreparedStatement * getPreparedStatement(const std::string &sql) const;
+
     /*!
      * \brief Gets a the value of a variable from the vars table in the JLWE database
      *
+     * The whole vars table is loaded on the first call, later calls are served from memory
+     *
      * \param name The name of the variable
      * \return The value of the variable as a string
      */
     std::string getGlobalVar(const std::string &name) const;
 
+    /*!
+     * \brief Discards the copy of the vars table held in memory
+     *
+     * Call this after changing a variable (with the setVariable SQL function) so the next call to getGlobalVar() sees the new value
+     */
+    void invalidateGlobalVars();
+
+    /*!
+     * \brief Gets the version number of some data that is cached between requests
+     *
+     * The version is increased (by the increment_data_version SQL function) every time the data is changed.
+     * All the versions are loaded from the data_versions table in a single query on the first call in each request.
+     * Only persistent workers and the shared cache need this, it always returns 0 for a normal CGI request if the shared cache is off.
+     *
+     * \param name The name of the data, eg. "vars"
+     * \return The version number
+     */
+    unsigned long long getDataVersion(const std::string &name) const;
+
     /*!
      * \brief Returns true if the user is logged in, false otherwise
      *
@@ -123,21 +164,52 @@ public:
     std::string getConfigFilename() const;
 
 private:
-    struct permission {
-        std::string name;
-        bool value;
+    // Maximum number of entries in the permission_list table
+    static const size_t MAX_PERMISSIONS = 64;
+
+    // One bit for each permission, the index of each permission is its position in permissionIndex
+    typedef std::bitset<MAX_PERMISSIONS> PermissionSet;
+
+    struct VarsSnapshot {
+        unsigned long long version;
+        std::unordered_map<std::string, std::string> values;
+    };
+
+    struct Session {
+        time_t loadTime;
+        int userId;
+        std::string username;
+        std::string email;
+        PermissionSet permissions;
     };
 
+    // Shared by every JlweCore object in this process
+    static nlohmann::json *sharedConfig;
+    static MysqlConnectionPool *connectionPool;
+    // Maps permission_id to its bit in PermissionSet
+    static std::unordered_map<std::string, size_t> *permissionIndex;
+    // Recently loaded sessions, keyed by access token (only used if sessionCacheSeconds is set in the config)
+    static std::unordered_map<std::string, Session> *sessionCache;
+    // Copy of the vars table
+    static VarsSnapshot *varsSnapshot;
+
     sql::Connection *mysqlCon;
     bool m_isLoggedIn;
     int m_currentUserId;
     std::string m_currentUserIP;
     std::string m_currentUsername;
     std::string m_currentUserEmail;
-    std::vector<permission> userPermissions;
-
+    PermissionSet userPermissions;
+    // true once varsSnapshot is known to be current for this request
+    mutable bool m_varsChecked;
+    // Versions from the data_versions table, loaded once per request
+    mutable std::unordered_map<std::string, unsigned long long> m_dataVersions;
+    mutable bool m_dataVersionsLoaded;
+
+    void loadConfig();
     void connectToMysql();
     void loadUserDetails();
+    void loadGlobalVars() const;
 
 };
 
@@ -69,6 +69,26 @@ std::string JlweUtils::timeToW3CDTF(const time_t unixtime) {
     return std::string(timeBuffer);
 }
 
+std::string JlweUtils::timeToHttpDate(const time_t unixtime) {
+    // Day and month names are done here rather than with strftime so they don't depend on the locale
+    static const char *days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    struct tm timeS;
+    gmtime_r(&unixtime, &timeS);
+    char timeBuffer[100];
+    snprintf(timeBuffer, 100, "%s, %02d %s %04d %02d:%02d:%02d GMT", days[timeS.tm_wday], timeS.tm_mday, months[timeS.tm_mon],
+             timeS.tm_year + 1900, timeS.tm_hour, timeS.tm_min, timeS.tm_sec);
+    return std::string(timeBuffer);
+}
+
+time_t JlweUtils::httpDateToTime(const std::string &httpDate) {
+    struct tm timeS = {};
+    const char *end = strptime(httpDate.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &timeS);
+    if (end == nullptr)
+        return -1;
+    return timegm(&timeS);
+}
+
 std::string JlweUtils::toString3Decimal(double number){
     char buffer [50];
     sprintf (buffer, "%2.3f", number);
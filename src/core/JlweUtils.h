@@ -45,6 +45,24 @@ public:
      */
     static std::string timeToW3CDTF(const time_t unixtime);
 
+    /*!
+     * \brief Converts time_t value to a string in the format used by HTTP headers.
+     *
+     * eg. "Sun, 06 Nov 1994 08:49:37 GMT", as used in Last-Modified
+     *
+     * \param unixtime The time_t value to convert
+     * \return The date/time in HTTP format
+     */
+    static std::string timeToHttpDate(const time_t unixtime);
+
+    /*!
+     * \brief Converts a date/time from a HTTP header (eg. If-Modified-Since) to a time_t value.
+     *
+     * \param httpDate The date/time in HTTP format
+     * \return The time_t value, or -1 if the string isn't a valid date
+     */
+    static time_t httpDateToTime(const std::string &httpDate);
+
     /*!
      * \brief Creates a string of random characters.
      *
@@ -17,8 +17,11 @@
  */
 #include "KeyValueParser.h"
 
+#include <cctype>
+#include <cstdint>
+#include <utility>
+
 #include "Encoder.h"
-#include "JlweUtils.h"
 
 KeyValueParser::KeyValueParser(const std::string &keyValueList, bool decodeUrls) {
     if (keyValueList.size())
@@ -38,9 +41,18 @@ void KeyValueParser::parseFromString(const std::string &keyValueList, bool decod
     if(true == keyValueList.empty())
       return;
 
-    std::string name, value;
-    std::string::size_type pos;
-    std::string::size_type oldPos = 0;
+    // Keep a copy of the data, the entries are views into it
+    this->strings.push_back(keyValueList);
+    this->parseFromView(this->strings.back(), decodeUrls);
+}
+
+void KeyValueParser::parseFromView(std::string_view keyValueList, bool decodeUrls) {
+    // Don't waste time on empty input
+    if(true == keyValueList.empty())
+      return;
+
+    std::string_view::size_type pos;
+    std::string_view::size_type oldPos = 0;
 
     // Parse the data in one fell swoop for efficiency
     while(true) {
@@ -48,48 +60,37 @@ void KeyValueParser::parseFromString(const std::string &keyValueList, bool decod
       pos = keyValueList.find_first_of( "&=", oldPos);
 
       // If no '=', we're finished
-      if(std::string::npos == pos)
+      if(std::string_view::npos == pos)
         break;
 
-      // Decode the name
-        // pos == '&', that means whatever is in name is the only name/value
+      // pos == '&', that means whatever is in name is the only name/value
       if( keyValueList.at( pos ) == '&' )
           {
-                const char * pszData = keyValueList.c_str() + oldPos;
-                while( *pszData == '&' ) // eat up extraneous '&'
-                {
-                        ++pszData; ++oldPos;
-                }
+                while( oldPos < pos && keyValueList.at( oldPos ) == '&' ) // eat up extraneous '&'
+                        ++oldPos;
                 if( oldPos >= pos )
                 { // its all &'s
                         oldPos = ++pos;
                         continue;
                 }
                 // this becomes an name with an empty value
-                name = removeWhiteSpaces(keyValueList.substr(oldPos, pos - oldPos));
-                if (decodeUrls)
-                    name = Encoder::urlDecode(name);
-                this->addValue(name, "");
+                this->addEntry(keyValueList.substr(oldPos, pos - oldPos), std::string_view(), decodeUrls);
                 oldPos = ++pos;
                 continue;
           }
-      name = removeWhiteSpaces(keyValueList.substr(oldPos, pos - oldPos));
-      if (decodeUrls)
-          name = Encoder::urlDecode(name);
+      std::string_view name = keyValueList.substr(oldPos, pos - oldPos);
       oldPos = ++pos;
 
       // Find the '&' or ';' separating subsequent name/value pairs
       pos = keyValueList.find_first_of(";&", oldPos);
 
       // Even if an '&' wasn't found the rest of the string is a value
-      value = removeWhiteSpaces(keyValueList.substr(oldPos, pos - oldPos));
-      if (decodeUrls)
-          value = Encoder::urlDecode(value);
+      std::string_view value = keyValueList.substr(oldPos, (std::string_view::npos == pos) ? std::string_view::npos : pos - oldPos);
 
       // Store the pair
-      this->addValue(name, value);
+      this->addEntry(name, value, decodeUrls);
 
-      if(std::string::npos == pos)
+      if(std::string_view::npos == pos)
         break;
 
       // Update parse position
@@ -97,52 +98,134 @@ void KeyValueParser::parseFromString(const std::string &keyValueList, bool decod
     }
 }
 
-void KeyValueParser::addValue(const std::string &key, const std::string &value) {
-    this->keyValues.push_back({key, value});
+void KeyValueParser::addEntry(std::string_view key, std::string_view value, bool decodeUrls) {
+    key = removeWhiteSpaces(key);
+    value = removeWhiteSpaces(value);
+
+    // Keys are needed for every lookup so they are decoded now, values are decoded when they are first used
+    if (decodeUrls && needsUrlDecode(key)) {
+        this->strings.push_back(Encoder::urlDecode(std::string(key)));
+        key = this->strings.back();
+    }
+    this->entries.push_back({key, value, decodeUrls && needsUrlDecode(value)});
+    this->index.clear();
+}
+
+void KeyValueParser::addValue(const std::string &key, std::string value) {
+    this->strings.push_back(key);
+    std::string_view keyView = this->strings.back();
+    this->strings.push_back(std::move(value));
+    this->entries.push_back({keyView, this->strings.back(), false});
+    this->index.clear();
 }
 
 std::string KeyValueParser::getValue(const std::string &key, std::string defaultValue) {
-    //return std::find_if(this->keyValues.begin(), this->keyValues.end(),FE_nameCompare(name));
+    const Entry *entry = this->findEntry(key);
+    if (entry)
+        return std::string(entry->value);
+    return defaultValue;
+}
+
+std::string_view KeyValueParser::getValueView(std::string_view key, std::string_view defaultValue) const {
+    const Entry *entry = this->findEntry(key);
+    if (entry)
+        return entry->value;
+    return defaultValue;
+}
+
+bool KeyValueParser::hasKey(std::string_view key) const {
+    return (this->findEntry(key) != nullptr);
+}
 
-    for (unsigned int i = 0; i < this->keyValues.size(); i++){
-        if (JlweUtils::compareStringsNoCase(this->keyValues.at(i).key, key)){
-            return this->keyValues.at(i).value;
+const KeyValueParser::Entry *KeyValueParser::findEntry(std::string_view key) const {
+    if (this->entries.empty())
+        return nullptr;
+    if (this->index.empty())
+        this->buildIndex();
+
+    size_t mask = this->index.size() - 1;
+    for (size_t slot = hashKey(key) & mask; this->index.at(slot); slot = (slot + 1) & mask) {
+        Entry &entry = this->entries.at(this->index.at(slot) - 1);
+        if (keysEqual(entry.key, key)) {
+            if (entry.encoded) {
+                this->strings.push_back(Encoder::urlDecode(std::string(entry.value)));
+                entry.value = this->strings.back();
+                entry.encoded = false;
+            }
+            return &entry;
         }
     }
-    return defaultValue;
+    return nullptr;
+}
+
+void KeyValueParser::buildIndex() const {
+    // Keep the table at most half full so the probe sequences stay short
+    size_t size = 8;
+    while (size < this->entries.size() * 2)
+        size *= 2;
+    this->index.assign(size, 0);
+
+    size_t mask = size - 1;
+    for (size_t i = 0; i < this->entries.size(); i++) {
+        size_t slot = hashKey(this->entries.at(i).key) & mask;
+        bool duplicate = false;
+        while (this->index.at(slot)) {
+            // Keys can appear more than once, only the first one is used
+            if (keysEqual(this->entries.at(this->index.at(slot) - 1).key, this->entries.at(i).key)) {
+                duplicate = true;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        if (!duplicate)
+            this->index.at(slot) = static_cast<unsigned int>(i + 1);
+    }
 }
 
 void KeyValueParser::clear() {
-    this->keyValues.clear();
+    this->entries.clear();
+    this->index.clear();
+    this->strings.clear();
 }
 
 bool KeyValueParser::isEmpty() {
-    return (this->keyValues.size() == 0);
+    return (this->entries.size() == 0);
 }
 
-std::string KeyValueParser::removeWhiteSpaces(const std::string& src) {
-
-    // skip leading whitespace - " \f\n\r\t\v"
-    std::string::size_type wscount_start = 0;
-    std::string::size_type wscount_end = 0;
-    std::string::const_iterator data_iter;
+std::string_view KeyValueParser::removeWhiteSpaces(std::string_view src) {
+    // skip leading and trailing whitespace - " \f\n\r\t\v"
+    while (src.size() && std::isspace(static_cast<unsigned char>(src.front())))
+        src.remove_prefix(1);
+    while (src.size() && std::isspace(static_cast<unsigned char>(src.back())))
+        src.remove_suffix(1);
+    return src;
+}
 
-    for (data_iter = src.begin(); data_iter != src.end(); ++data_iter,++wscount_start)
-      if(0 == std::isspace(*data_iter))
-        break;
+bool KeyValueParser::needsUrlDecode(std::string_view src) {
+    return (src.find_first_of("%+") != std::string_view::npos);
+}
 
-    // if the string is all white spaces;
-    if (data_iter == src.end())
-        return "";;
+// ASCII only, like the std::toupper in JlweUtils::compareStringsNoCase
+static inline unsigned char foldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c - 'A' + 'a') : static_cast<unsigned char>(c);
+}
 
-    data_iter = src.end();
-    while (data_iter != src.begin()) {
-        --data_iter;
-       if(0 == std::isspace(*data_iter))
-         break;
-       ++wscount_end;
+size_t KeyValueParser::hashKey(std::string_view key) {
+    // FNV-1a of the lower case key
+    uint32_t hash = 2166136261u;
+    for (char c : key) {
+        hash ^= foldCase(c);
+        hash *= 16777619u;
     }
+    return hash;
+}
 
-    return src.substr(wscount_start, src.length() - wscount_start - wscount_end);
-
+bool KeyValueParser::keysEqual(std::string_view key1, std::string_view key2) {
+    if (key1.size() != key2.size())
+        return false;
+    for (size_t i = 0; i < key1.size(); i++) {
+        if (foldCase(key1[i]) != foldCase(key2[i]))
+            return false;
+    }
+    return true;
 }
@@ -9,7 +9,9 @@
   or: key1=value1;key2=value2;key3=value3
   Delimiters supported are & and ;
   The keys are not necessarily unique
-  URL decoding of keys and values is also provided
+  URL decoding of keys and values is also provided, values are only decoded the first time they are used
+  Lookups use a case-insensitive hash index that is built the first time a value is requested
+  getValueView() returns views into the parser's own copy of the data, so nothing is copied
   This class reuses a lot of code from the cgicc library: https://www.gnu.org/software/cgicc/index.html
 
   This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
@@ -18,7 +20,9 @@
 #ifndef KEYVALUEPARSER_H
 #define KEYVALUEPARSER_H
 
+#include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
 
 class KeyValueParser {
@@ -39,23 +43,65 @@ public:
     */
     ~KeyValueParser();
 
-    struct KeyValuePair {
-        std::string key;
-        std::string value;
-    };
+    // The views returned by getValueView() point into this object, so it can't be copied
+    KeyValueParser(const KeyValueParser &) = delete;
+    KeyValueParser &operator=(const KeyValueParser &) = delete;
 
     void parseFromString(const std::string &keyValueList, bool decodeUrls);
     std::string getValue(const std::string &key, std::string defaultValue = "");
+
+    /**
+      Finds the value of a key, without copying it. If the key appears more than once the first value is used.
+
+      @param key is the key to find, the comparison is case-insensitive.
+      @param defaultValue is returned if the key isn't found.
+      @return a view of the value, valid for as long as this object exists.
+    */
+    std::string_view getValueView(std::string_view key, std::string_view defaultValue = std::string_view()) const;
+
+    /**
+      Checks if a key exists.
+
+      @param key is the key to find, the comparison is case-insensitive.
+      @return true if the key was found.
+    */
+    bool hasKey(std::string_view key) const;
+
     void clear();
     bool isEmpty();
 
 protected:
-    void addValue(const std::string &key, const std::string &value);
+    void addValue(const std::string &key, std::string value); // the value is moved in, pass it with std::move() to avoid a copy
+
+    /**
+      Parses key-value data without copying it. Used when the data is already stored in the derived class.
+
+      @param keyValueList is the key-value data, it must stay valid for as long as this object exists.
+      @param decodeUrls is set to true if URL decoding is required.
+    */
+    void parseFromView(std::string_view keyValueList, bool decodeUrls);
 
 private:
-    static std::string removeWhiteSpaces(const std::string& src);
+    struct Entry {
+        std::string_view key;
+        std::string_view value;
+        bool encoded; // true if the value still needs URL decoding
+    };
+
+    void addEntry(std::string_view key, std::string_view value, bool decodeUrls);
+    const Entry *findEntry(std::string_view key) const;
+    void buildIndex() const;
+
+    static std::string_view removeWhiteSpaces(std::string_view src);
+    static bool needsUrlDecode(std::string_view src);
+    static size_t hashKey(std::string_view key);
+    static bool keysEqual(std::string_view key1, std::string_view key2);
 
-    std::vector<KeyValuePair> keyValues;
+    // Storage for copies of input data and decoded strings, a deque doesn't move its elements so views stay valid
+    mutable std::deque<std::string> strings;
+    mutable std::vector<Entry> entries;
+    // Open addressing hash table of (index in entries + 1), zero is an empty slot
+    mutable std::vector<unsigned int> index;
 };
 
 #endif // KEYVALUEPARSER_H
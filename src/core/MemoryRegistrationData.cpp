@@ -0,0 +1,87 @@
+/**
+  @file    MemoryRegistrationData.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Holds the order and payment data for PaymentUtils in memory, instead of reading it from the database
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "MemoryRegistrationData.h"
+
+MemoryRegistrationData::MemoryRegistrationData() {
+    // do nothing
+}
+
+void MemoryRegistrationData::loadFixture(const nlohmann::json &fixture) {
+    nlohmann::json menus = fixture.value("menus", nlohmann::json::object());
+    for (const auto &menu : menus.items()) {
+        std::vector<DinnerUtils::dinner_menu_item> items;
+        for (const nlohmann::json &item : menu.value())
+            items.push_back({item.at("id"), item.value("name", ""), item.value("name_plural", ""), item.value("price", 0)});
+        this->setDinnerMenuItems(std::stoi(menu.key()), items);
+    }
+
+    for (const nlohmann::json &user : fixture.value("users", nlohmann::json::array())) {
+        std::string userKey = user.at("key");
+
+        UserOrder order;
+        if (user.contains("event")) {
+            order.has_event = true;
+            order.number_adults = user.at("event").value("adults", 0);
+            order.number_children = user.at("event").value("children", 0);
+        }
+        if (user.contains("camping")) {
+            order.has_camping = true;
+            order.camping_price_code = user.at("camping").value("price_code", "");
+            order.camping_people = user.at("camping").value("people", 0);
+            order.camping_nights = user.at("camping").value("nights", 0);
+        }
+        for (const nlohmann::json &dinner : user.value("dinner", nlohmann::json::array())) {
+            // The order can be given as an object or as a string of JSON
+            const nlohmann::json &dinnerOrder = dinner.at("order");
+            order.dinner_orders.push_back({dinner.at("form_id"), dinnerOrder.is_string() ? dinnerOrder.get<std::string>() : dinnerOrder.dump()});
+        }
+        order.merch_cost = user.value("merch_cost", 0);
+        order.card_fees = user.value("card_fees", 0);
+        this->setUserOrder(userKey, order);
+
+        for (const nlohmann::json &payment : user.value("payments", nlohmann::json::array()))
+            this->addPayment(userKey, {payment.value("id", ""), payment.value("timestamp", static_cast<time_t>(0)), payment.value("amount", 0), payment.value("type", "bank")});
+    }
+}
+
+void MemoryRegistrationData::setUserOrder(const std::string &userKey, const UserOrder &order) {
+    this->orders[userKey] = order;
+}
+
+void MemoryRegistrationData::addPayment(const std::string &userKey, const PaymentUtils::paymentEntry &payment) {
+    this->payments[userKey].push_back(payment);
+}
+
+void MemoryRegistrationData::setDinnerMenuItems(int dinner_form_id, const std::vector<DinnerUtils::dinner_menu_item> &items) {
+    this->menu_items[dinner_form_id] = items;
+}
+
+std::vector<PaymentUtils::paymentEntry> MemoryRegistrationData::getUserPayments(const std::string &userKey) {
+    auto it = this->payments.find(userKey);
+    if (it == this->payments.end())
+        return {};
+    return it->second;
+}
+
+RegistrationData::UserOrder MemoryRegistrationData::getUserOrder(const std::string &userKey) {
+    auto it = this->orders.find(userKey);
+    if (it == this->orders.end())
+        return UserOrder();
+    return it->second;
+}
+
+std::vector<DinnerUtils::dinner_menu_item> MemoryRegistrationData::getDinnerMenuItems(int dinner_form_id) {
+    auto it = this->menu_items.find(dinner_form_id);
+    if (it == this->menu_items.end())
+        return {};
+    return it->second;
+}
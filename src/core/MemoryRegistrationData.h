@@ -0,0 +1,66 @@
+/**
+  @file    MemoryRegistrationData.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Holds the order and payment data for PaymentUtils in memory, instead of reading it from the database
+  The data is either added one user at a time or loaded from a JSON fixture, this is used to benchmark the
+  payment code without a MySQL server
+
+  Fixture format (all keys are optional):
+    {
+      "menus": {"1": [{"id": 1, "name": "Steak", "name_plural": "Steaks", "price": 3000}, ...]},
+      "users": [{"key": "abc123",
+                 "event": {"adults": 2, "children": 1},
+                 "camping": {"price_code": "powered", "people": 2, "nights": 2},
+                 "dinner": [{"form_id": 1, "order": {...}}],
+                 "merch_cost": 0, "card_fees": 0,
+                 "payments": [{"id": "1", "timestamp": 1700000000, "amount": 5000, "type": "bank"}]}, ...]
+    }
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef MEMORYREGISTRATIONDATA_H
+#define MEMORYREGISTRATIONDATA_H
+
+#include <unordered_map>
+
+#include "RegistrationData.h"
+
+#include "../ext/nlohmann/json.hpp"
+
+class MemoryRegistrationData : public RegistrationData {
+public:
+
+    /*!
+     * \brief MemoryRegistrationData Constructor, makes an empty data set.
+     */
+    MemoryRegistrationData();
+
+    /*!
+     * \brief Adds the menus and users in a JSON fixture to the data set (see the format at the top of this file).
+     *
+     * \param fixture The fixture JSON
+     */
+    void loadFixture(const nlohmann::json &fixture);
+
+    void setUserOrder(const std::string &userKey, const UserOrder &order);
+    void addPayment(const std::string &userKey, const PaymentUtils::paymentEntry &payment);
+    void setDinnerMenuItems(int dinner_form_id, const std::vector<DinnerUtils::dinner_menu_item> &items);
+
+    std::vector<PaymentUtils::paymentEntry> getUserPayments(const std::string &userKey) override;
+    UserOrder getUserOrder(const std::string &userKey) override;
+    std::vector<DinnerUtils::dinner_menu_item> getDinnerMenuItems(int dinner_form_id) override;
+
+private:
+    // The key of these maps is the user key
+    std::unordered_map<std::string, UserOrder> orders;
+    std::unordered_map<std::string, std::vector<PaymentUtils::paymentEntry>> payments;
+
+    // The key is the dinner form id
+    std::unordered_map<int, std::vector<DinnerUtils::dinner_menu_item>> menu_items;
+};
+
+#endif // MEMORYREGISTRATIONDATA_H
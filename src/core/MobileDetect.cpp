@@ -0,0 +1,194 @@
+/**
+  @file    MobileDetect.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Detects mobile browsers from the HTTP user agent string
+  All functions are static so there is no need to create instances of the MobileDetect object
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "MobileDetect.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Maximum number of user agents kept in the LRU cache
+#define CACHE_MAX_SIZE 256
+
+// The characters that appear in the tokens, used to index the trie children
+#define TOKEN_ALPHABET "abcdefghijklmnopqrstuvwxyz0123456789 ./"
+
+// Tokens that can appear anywhere in a mobile user agent
+// This is the literal part of the first regex: avantgo|bada\/|blackberry|...|xiino
+// The two rules "(android|bb\d+|meego).+mobile" and "mobile.+firefox" can't be expressed as plain tokens so they are checked separately
+static const char *MOBILE_TOKENS[] = {
+    "avantgo", "bada/", "blackberry", "blazer", "compal", "elaine", "fennec", "hiptop", "iemobile", "iphone",
+    "ipod", "iris", "kindle", "lge ", "maemo", "midp", "mmp", "netfront", "opera mobi", "opera mini",
+    "palm", "phone", "pixi/", "pre/", "plucker", "pocket", "psp", "series40", "series60", "symbian",
+    "treo", "up.browser", "up.link", "vodafone", "wap", "windows ce", "xda", "xiino"
+};
+
+// Every four character string that matches the second regex: ^(1207|6310|6590|3gso|4thp|50[1-6]i|...|zte\-)
+// All the alternatives in that regex are exactly four characters long, so the regex is the same as looking up
+// the first four characters of the user agent in this list. Must be kept in sorted order for the binary search.
+static const char MOBILE_PREFIXES[][5] = {
+    "1207", "3gso", "4thp", "501i", "502i", "503i", "504i", "505i", "506i", "6310", "6590", "770s",
+    "802s", "a wa", "abac", "acer", "acoo", "acs-", "aiko", "airn", "alav", "alca", "alco", "amoi",
+    "anex", "anny", "anyw", "aptu", "arch", "argo", "aste", "asus", "attw", "au-m", "audi", "aur ",
+    "aus ", "avan", "beck", "bell", "benq", "bilb", "bird", "blac", "blaz", "brew", "brvw", "bumb",
+    "bw-n", "bw-u", "c55/", "capi", "ccwa", "cdm-", "cell", "chtm", "cldc", "cmd-", "comp", "cond",
+    "craw", "dait", "dall", "dang", "dbte", "dc-s", "devi", "dica", "dmob", "doco", "dopo", "ds-d",
+    "ds12", "el49", "elai", "eml2", "emul", "eric", "erk0", "esl8", "ez40", "ez50", "ez60", "ez70",
+    "ezos", "ezwa", "ezze", "fetc", "fly-", "fly_", "g-mo", "g1 u", "g560", "gene", "gf-5", "go.w",
+    "good", "grad", "grun", "haie", "hcit", "hd-m", "hd-p", "hd-t", "hei-", "hipt", "hita", "hp i",
+    "hpip", "hs-c", "htc ", "htc-", "htc_", "htca", "htcg", "htcp", "htcs", "htct", "http", "huaw",
+    "hutc", "i-20", "i-go", "i-ma", "i230", "iac ", "iac-", "iac/", "ibro", "idea", "ig01", "ikom",
+    "im1k", "inno", "ipaq", "iris", "jata", "java", "jbro", "jemu", "jigs", "kddi", "keji", "kgt ",
+    "kgt/", "klon", "kpt ", "kwc-", "kyoc", "kyok", "leno", "lexi", "lg g", "lg-a", "lg-b", "lg-c",
+    "lg-d", "lg-e", "lg-f", "lg-g", "lg-h", "lg-i", "lg-j", "lg-k", "lg-l", "lg-m", "lg-n", "lg-o",
+    "lg-p", "lg-q", "lg-r", "lg-s", "lg-t", "lg-u", "lg-v", "lg-w", "lg/k", "lg/l", "lg/u", "lg50",
+    "lg54", "libw", "lynx", "m-cr", "m1-w", "m3ga", "m50/", "mate", "maui", "maxo", "mc01", "mc21",
+    "mcca", "merc", "meri", "mio8", "mioa", "mits", "mmef", "mo01", "mo02", "mobi", "mode", "modo",
+    "mot ", "mot-", "moto", "motv", "mozz", "mt50", "mtp1", "mtv ", "mwbp", "mywa", "n100", "n101",
+    "n102", "n202", "n203", "n300", "n302", "n500", "n502", "n505", "n700", "n701", "n710", "nec-",
+    "nem-", "neon", "netf", "newf", "newg", "newt", "nok6", "noki", "nzph", "o2im", "opti", "opwv",
+    "oran", "owg1", "p800", "pana", "pand", "pant", "pdxg", "pg-1", "pg-2", "pg-3", "pg-4", "pg-5",
+    "pg-6", "pg-7", "pg-8", "pg-c", "pg13", "phil", "pire", "play", "pluc", "pn-2", "pock", "port",
+    "pose", "prox", "psio", "pt-g", "qa-a", "qc-2", "qc-3", "qc-4", "qc-5", "qc-6", "qc-7", "qc07",
+    "qc12", "qc21", "qc32", "qc60", "qci-", "qtek", "r380", "r600", "raks", "rim9", "rove", "rozo",
+    "s55/", "sage", "sama", "samm", "sams", "sany", "sava", "sc01", "sch-", "scoo", "scp-", "sdk/",
+    "se47", "sec-", "sec0", "sec1", "semc", "send", "seri", "sgh-", "shar", "sie-", "siem", "sk-0",
+    "sl45", "slid", "smal", "smar", "smb3", "smit", "smt5", "soft", "sony", "sp01", "sph-", "spv ",
+    "spv-", "sy01", "symb", "t-mo", "t218", "t250", "t600", "t610", "t618", "tagt", "talk", "tcl-",
+    "tdg-", "teli", "telm", "tim-", "topl", "tosh", "ts70", "tsm-", "tsm3", "tsm5", "tx-9", "up.b",
+    "upg1", "upsi", "utst", "v400", "v750", "veri", "virg", "vite", "vk-v", "vk40", "vk50", "vk51",
+    "vk52", "vk53", "vm40", "voda", "vulc", "vx52", "vx53", "vx60", "vx61", "vx70", "vx80", "vx81",
+    "vx83", "vx85", "vx98", "w3c ", "w3c-", "webc", "whit", "wig ", "winc", "winw", "wmlb", "wonu",
+    "x700", "yas-", "your", "zeto", "zte-"
+};
+
+std::vector<MobileDetect::TrieNode> MobileDetect::trie;
+std::list<std::pair<std::string, bool>> MobileDetect::cacheList;
+std::unordered_map<std::string, std::list<std::pair<std::string, bool>>::iterator> MobileDetect::cacheIndex;
+
+int MobileDetect::alphabetIndex[256];
+
+static std::string toLowerAscii(const std::string &str) {
+    std::string result = str;
+    for (char &c : result) {
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+    }
+    return result;
+}
+
+bool MobileDetect::isMobileUserAgent(const std::string &userAgent) {
+    auto it = cacheIndex.find(userAgent);
+    if (it != cacheIndex.end()) {
+        cacheList.splice(cacheList.begin(), cacheList, it->second);
+        return it->second->second;
+    }
+
+    bool result = matchUserAgent(userAgent);
+
+    cacheList.emplace_front(userAgent, result);
+    cacheIndex[userAgent] = cacheList.begin();
+    if (cacheList.size() > CACHE_MAX_SIZE) {
+        cacheIndex.erase(cacheList.back().first);
+        cacheList.pop_back();
+    }
+    return result;
+}
+
+bool MobileDetect::matchUserAgent(const std::string &userAgent) {
+    std::string lowerUserAgent = toLowerAscii(userAgent);
+    return matchPrefix(lowerUserAgent) || matchTokens(lowerUserAgent);
+}
+
+void MobileDetect::clearCache() {
+    cacheList.clear();
+    cacheIndex.clear();
+}
+
+void MobileDetect::buildTrie() {
+    const size_t alphabetSize = std::strlen(TOKEN_ALPHABET);
+    std::fill(alphabetIndex, alphabetIndex + 256, -1);
+    for (size_t i = 0; i < alphabetSize; i++)
+        alphabetIndex[static_cast<unsigned char>(TOKEN_ALPHABET[i])] = static_cast<int>(i);
+
+    trie.clear();
+    trie.push_back({std::vector<int>(alphabetSize, -1), false});
+
+    for (const char *token : MOBILE_TOKENS) {
+        int node = 0;
+        for (const char *c = token; *c; c++) {
+            int index = alphabetIndex[static_cast<unsigned char>(*c)];
+            if (trie[node].children[index] < 0) {
+                trie[node].children[index] = static_cast<int>(trie.size());
+                trie.push_back({std::vector<int>(alphabetSize, -1), false});
+            }
+            node = trie[node].children[index];
+        }
+        trie[node].terminal = true;
+    }
+}
+
+bool MobileDetect::matchPrefix(const std::string &lowerUserAgent) {
+    if (lowerUserAgent.size() < 4)
+        return false;
+
+    const size_t count = sizeof(MOBILE_PREFIXES) / sizeof(MOBILE_PREFIXES[0]);
+    return std::binary_search(MOBILE_PREFIXES, MOBILE_PREFIXES + count, lowerUserAgent.c_str(), [](const char *a, const char *b) {
+        return std::strncmp(a, b, 4) < 0;
+    });
+}
+
+bool MobileDetect::matchTokens(const std::string &lowerUserAgent) {
+    if (trie.empty())
+        buildTrie();
+
+    const size_t length = lowerUserAgent.size();
+    for (size_t i = 0; i < length; i++) {
+        int node = 0;
+        for (size_t j = i; j < length; j++) {
+            int index = alphabetIndex[static_cast<unsigned char>(lowerUserAgent[j])];
+            if (index < 0)
+                break;
+            node = trie[node].children[index];
+            if (node < 0)
+                break;
+            if (trie[node].terminal)
+                return true;
+        }
+    }
+
+    // (android|bb\d+|meego).+mobile
+    // Find where the earliest of "android", "bb<digits>" or "meego" ends, then look for "mobile" at least one character after that
+    size_t firstEnd = std::string::npos;
+    size_t pos = lowerUserAgent.find("android");
+    if (pos != std::string::npos)
+        firstEnd = std::min(firstEnd, pos + 7);
+    pos = lowerUserAgent.find("meego");
+    if (pos != std::string::npos)
+        firstEnd = std::min(firstEnd, pos + 5);
+    pos = lowerUserAgent.find("bb");
+    while (pos != std::string::npos && pos + 2 < length) {
+        if (lowerUserAgent[pos + 2] >= '0' && lowerUserAgent[pos + 2] <= '9') {
+            firstEnd = std::min(firstEnd, pos + 3);
+            break;
+        }
+        pos = lowerUserAgent.find("bb", pos + 1);
+    }
+    if (firstEnd != std::string::npos && lowerUserAgent.find("mobile", firstEnd + 1) != std::string::npos)
+        return true;
+
+    // mobile.+firefox
+    pos = lowerUserAgent.find("mobile");
+    if (pos != std::string::npos && lowerUserAgent.find("firefox", pos + 7) != std::string::npos)
+        return true;
+
+    return false;
+}
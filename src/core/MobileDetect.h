@@ -0,0 +1,89 @@
+/**
+  @file    MobileDetect.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Detects mobile browsers from the HTTP user agent string
+  The matcher is equivalent to the two "detectmobilebrowsers" regular expressions that used to be in HtmlTemplate,
+  but is built once per process instead of compiling std::regex objects on every request
+  All functions are static so there is no need to create instances of the MobileDetect object
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef MOBILEDETECT_H
+#define MOBILEDETECT_H
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class MobileDetect {
+public:
+
+    /*!
+     * \brief Checks if a user agent belongs to a mobile browser
+     *
+     * Results are kept in a small LRU cache, so repeated requests from the same browser
+     * (eg. in a FastCGI worker) don't need to run the matcher again
+     *
+     * \param userAgent The user agent string from the HTTP request
+     * \return True if it is a mobile browser
+     */
+    static bool isMobileUserAgent(const std::string &userAgent);
+
+    /*!
+     * \brief Runs the matcher on a user agent without using the cache
+     *
+     * \param userAgent The user agent string from the HTTP request
+     * \return True if it is a mobile browser
+     */
+    static bool matchUserAgent(const std::string &userAgent);
+
+    /*!
+     * \brief Empties the LRU cache
+     */
+    static void clearCache();
+
+private:
+
+    // One node of the token trie. Children are indexed by the position of the character in TOKEN_ALPHABET
+    struct TrieNode {
+        std::vector<int> children;
+        bool terminal;
+    };
+
+    /*!
+     * \brief Builds the token trie, only done once per process
+     */
+    static void buildTrie();
+
+    /*!
+     * \brief Checks the first four characters of the user agent against the list of known mobile prefixes
+     *
+     * \param lowerUserAgent The user agent, already converted to lower case
+     * \return True if the prefix is in the list
+     */
+    static bool matchPrefix(const std::string &lowerUserAgent);
+
+    /*!
+     * \brief Searches the user agent for any of the mobile tokens (eg. "iphone", "symbian")
+     *
+     * \param lowerUserAgent The user agent, already converted to lower case
+     * \return True if a token was found
+     */
+    static bool matchTokens(const std::string &lowerUserAgent);
+
+    static std::vector<TrieNode> trie;
+    static int alphabetIndex[256];
+
+    // LRU cache of user agent -> result, most recently used at the front
+    static std::list<std::pair<std::string, bool>> cacheList;
+    static std::unordered_map<std::string, std::list<std::pair<std::string, bool>>::iterator> cacheIndex;
+
+};
+
+#endif // MOBILEDETECT_H
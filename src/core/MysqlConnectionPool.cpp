@@ -0,0 +1,155 @@
+/**
+  @file    MysqlConnectionPool.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  A pool of MySQL connections that are kept open for the life of the process
+   - Connections that have been idle for a while are checked before being reused
+   - Broken connections are replaced with new ones
+   - Each connection has a cache of prepared statements, keyed by the SQL text,
+     so frequently used queries are only prepared by the server once per connection
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "MysqlConnectionPool.h"
+
+#include <stdexcept>
+
+// MySQL client error codes for a lost connection
+#define CR_SERVER_GONE_ERROR  2006
+#define CR_SERVER_LOST        2013
+
+MysqlConnectionPool::MysqlConnectionPool(const std::string &host, const std::string &username, const std::string &password, const std::string &database, int healthCheckSeconds) {
+    this->m_host = host;
+    this->m_username = username;
+    this->m_password = password;
+    this->m_database = database;
+    this->m_healthCheckSeconds = healthCheckSeconds;
+}
+
+MysqlConnectionPool::~MysqlConnectionPool() {
+    for (unsigned int i = 0; i < this->connections.size(); i++)
+        closeConnection(this->connections.at(i));
+}
+
+sql::Connection * MysqlConnectionPool::connect() {
+    sql::Driver *driver = get_driver_instance();
+    sql::Connection *con = driver->connect(this->m_host.c_str(), this->m_username.c_str(), this->m_password.c_str());
+    con->setSchema(this->m_database.c_str());
+    return con;
+}
+
+sql::Connection * MysqlConnectionPool::acquire() {
+    time_t now = time(nullptr);
+
+    for (unsigned int i = 0; i < this->connections.size(); ) {
+        PooledConnection &pooled = this->connections.at(i);
+        if (pooled.inUse) {
+            i++;
+            continue;
+        }
+
+        // Check connections that have been idle for a while, the server may have closed them (wait_timeout)
+        bool healthy = !pooled.con->isClosed();
+        if (healthy && now - pooled.lastUsed > this->m_healthCheckSeconds) {
+            try {
+                healthy = pooled.con->isValid();
+            } catch (const sql::SQLException &) {
+                healthy = false;
+            }
+        }
+
+        if (!healthy) {
+            // Prepared statements don't survive a reconnect so drop it, a new connection is made if none of the others are usable
+            // The next connection moves into this index, so keep looking without moving on
+            closeConnection(pooled);
+            this->connections.erase(this->connections.begin() + i);
+            continue;
+        }
+
+        pooled.inUse = true;
+        pooled.lastUsed = now;
+        return pooled.con;
+    }
+
+    sql::Connection *con = this->connect();
+    this->connections.push_back({con, true, now, {}});
+    return con;
+}
+
+void MysqlConnectionPool::release(sql::Connection *con) {
+    PooledConnection *pooled = this->findConnection(con);
+    if (pooled) {
+        pooled->inUse = false;
+        pooled->lastUsed = time(nullptr);
+    }
+}
+
+sql::PreparedStatement * MysqlConnectionPool::getPreparedStatement(sql::Connection *con, const std::string &sql) {
+    PooledConnection *pooled = this->findConnection(con);
+    if (pooled == nullptr)
+        throw std::invalid_argument("Connection is not from this connection pool");
+
+    auto it = pooled->statements.find(sql);
+    if (it != pooled->statements.end()) {
+        it->second->clearParameters();
+        return it->second;
+    }
+
+    sql::PreparedStatement *prep_stmt;
+    try {
+        prep_stmt = pooled->con->prepareStatement(sql);
+    } catch (const sql::SQLException &e) {
+        if (!isConnectionError(e))
+            throw;
+
+        // The server has gone away, reconnect and try once more
+        // The sql::Connection object is kept so pointers held by the caller stay valid
+        for (auto &statement : pooled->statements)
+            delete statement.second;
+        pooled->statements.clear();
+        if (!pooled->con->reconnect())
+            throw;
+        pooled->con->setSchema(this->m_database.c_str());
+        prep_stmt = pooled->con->prepareStatement(sql);
+    }
+
+    pooled->statements[sql] = prep_stmt;
+    return prep_stmt;
+}
+
+void MysqlConnectionPool::closeIdleConnections() {
+    for (auto it = this->connections.begin(); it != this->connections.end();) {
+        if (it->inUse) {
+            ++it;
+        } else {
+            closeConnection(*it);
+            it = this->connections.erase(it);
+        }
+    }
+}
+
+MysqlConnectionPool::PooledConnection * MysqlConnectionPool::findConnection(sql::Connection *con) {
+    for (unsigned int i = 0; i < this->connections.size(); i++) {
+        if (this->connections.at(i).con == con)
+            return &this->connections.at(i);
+    }
+    return nullptr;
+}
+
+void MysqlConnectionPool::closeConnection(PooledConnection &pooled) {
+    for (auto &statement : pooled.statements)
+        delete statement.second;
+    pooled.statements.clear();
+
+    if (pooled.con) {
+        delete pooled.con;
+        pooled.con = nullptr;
+    }
+}
+
+bool MysqlConnectionPool::isConnectionError(const sql::SQLException &e) {
+    return (e.getErrorCode() == CR_SERVER_GONE_ERROR || e.getErrorCode() == CR_SERVER_LOST);
+}
@@ -0,0 +1,112 @@
+/**
+  @file    MysqlConnectionPool.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  A pool of MySQL connections that are kept open for the life of the process
+   - Connections that have been idle for a while are checked before being reused
+   - Broken connections are replaced with new ones
+   - Each connection has a cache of prepared statements, keyed by the SQL text,
+     so frequently used queries are only prepared by the server once per connection
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef MYSQLCONNECTIONPOOL_H
+#define MYSQLCONNECTIONPOOL_H
+
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <mysql_connection.h>
+
+#include <cppconn/driver.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+
+class MysqlConnectionPool {
+
+public:
+
+    /*!
+     * \brief Constructor for MysqlConnectionPool.
+     *
+     * \param host The MySQL server host
+     * \param username The MySQL username
+     * \param password The MySQL password
+     * \param database The database (schema) to use
+     * \param healthCheckSeconds Connections idle for longer than this are checked before being reused
+     */
+    MysqlConnectionPool(const std::string &host, const std::string &username, const std::string &password, const std::string &database, int healthCheckSeconds = 30);
+
+    /*!
+     * \brief Destructor for MysqlConnectionPool. Closes all connections.
+     */
+    ~MysqlConnectionPool();
+
+    MysqlConnectionPool( const MysqlConnectionPool& ) = delete; // non construction-copyable
+    MysqlConnectionPool& operator=( const MysqlConnectionPool& ) = delete; // non copyable
+
+    /*!
+     * \brief Takes a connection from the pool, or opens a new one if none are free.
+     *
+     * The connection must be given back with release() when it is no longer needed.
+     *
+     * \return A working connection
+     */
+    sql::Connection * acquire();
+
+    /*!
+     * \brief Returns a connection to the pool so it can be used again.
+     *
+     * \param con The connection from acquire()
+     */
+    void release(sql::Connection *con);
+
+    /*!
+     * \brief Gets a prepared statement for the given SQL, from the cache of the given connection.
+     *
+     * The statement is prepared the first time it is requested and reused after that.
+     * The statement is owned by the pool so it must NOT be deleted by the caller.
+     * The parameters are cleared before the statement is returned.
+     * Finish with the result set before requesting the same SQL again, re-executing the statement invalidates it.
+     *
+     * \param con A connection from acquire()
+     * \param sql The SQL text of the statement
+     * \return The prepared statement
+     */
+    sql::PreparedStatement * getPreparedStatement(sql::Connection *con, const std::string &sql);
+
+    /*!
+     * \brief Closes all connections that are not in use.
+     */
+    void closeIdleConnections();
+
+private:
+    struct PooledConnection {
+        sql::Connection *con;
+        bool inUse;
+        time_t lastUsed;
+        std::unordered_map<std::string, sql::PreparedStatement *> statements;
+    };
+
+    std::string m_host;
+    std::string m_username;
+    std::string m_password;
+    std::string m_database;
+    int m_healthCheckSeconds;
+
+    std::vector<PooledConnection> connections;
+
+    sql::Connection * connect();
+    PooledConnection * findConnection(sql::Connection *con);
+    static void closeConnection(PooledConnection &pooled);
+
+    // true if the error means the connection to the server has been lost
+    static bool isConnectionError(const sql::SQLException &e);
+};
+
+#endif // MYSQLCONNECTIONPOOL_H
@@ -0,0 +1,200 @@
+/**
+  @file    MysqlQuery.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  A small wrapper around a MySQL prepared statement and its result set
+  The statement and result set are deleted automatically, so nothing leaks if an exception is thrown part way through
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "MysqlQuery.h"
+
+#include <chrono>
+
+#include <cppconn/exception.h>
+
+#include "JlweCore.h"
+#include "QueryProfiler.h"
+
+MysqlQuery::MysqlQuery(const JlweCore *jlwe, const std::string &sql) :
+    stmt(jlwe->getPreparedStatement(sql), StatementDeleter{false}),
+    sqlText(sql)
+{
+    this->fetchSize = 0;
+    this->bindCount = 0;
+    this->profiling = false;
+    this->rowsRead = 0;
+}
+
+MysqlQuery::MysqlQuery(sql::Connection *con, const std::string &sql) :
+    stmt(con->prepareStatement(sql), StatementDeleter{true}),
+    sqlText(sql)
+{
+    this->fetchSize = 0;
+    this->bindCount = 0;
+    this->profiling = false;
+    this->rowsRead = 0;
+}
+
+MysqlQuery::~MysqlQuery() {
+    this->recordRows();
+    // unique_ptr members are destroyed in reverse order, so the result set goes before the statement
+}
+
+MysqlQuery &MysqlQuery::setFetchSize(size_t rows) {
+    this->fetchSize = rows;
+    try {
+        this->stmt->setFetchSize(rows);
+    } catch (const sql::SQLException &) {
+        // Not all driver versions implement this, it's only a hint anyway
+    }
+    return *this;
+}
+
+sql::ResultSet *MysqlQuery::execute() {
+    this->recordRows();
+    this->res.reset();
+    if (!QueryProfiler::isEnabled()) {
+        this->res.reset(this->stmt->executeQuery());
+        return this->res.get();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    this->res.reset(this->stmt->executeQuery());
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    // The rows are added as they are read, rowsCount() doesn't work for results that are streamed from the server
+    QueryProfiler::record(this->sqlText, this->bindCount, duration.count(), 0);
+    this->profiling = true;
+    this->rowsRead = 0;
+    return this->res.get();
+}
+
+int MysqlQuery::executeUpdate() {
+    this->recordRows();
+    this->res.reset();
+    if (!QueryProfiler::isEnabled())
+        return this->stmt->executeUpdate();
+
+    auto start = std::chrono::steady_clock::now();
+    int rows = this->stmt->executeUpdate();
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    QueryProfiler::record(this->sqlText, this->bindCount, duration.count(), static_cast<unsigned long long>(rows));
+    return rows;
+}
+
+bool MysqlQuery::next() {
+    if (!this->res)
+        this->execute();
+    if (!this->res->next())
+        return false;
+    if (this->profiling)
+        this->rowsRead++;
+    return true;
+}
+
+void MysqlQuery::recordRows() {
+    if (this->profiling && this->rowsRead)
+        QueryProfiler::recordRows(this->sqlText, this->rowsRead);
+    this->profiling = false;
+    this->rowsRead = 0;
+}
+
+sql::ResultSet *MysqlQuery::result() const {
+    return this->res.get();
+}
+
+void MysqlQuery::bindValue(unsigned int index, int value) {
+    this->stmt->setInt(index, value);
+}
+
+void MysqlQuery::bindValue(unsigned int index, unsigned int value) {
+    this->stmt->setUInt(index, value);
+}
+
+void MysqlQuery::bindValue(unsigned int index, long value) {
+    this->stmt->setInt64(index, static_cast<int64_t>(value));
+}
+
+void MysqlQuery::bindValue(unsigned int index, long long value) {
+    this->stmt->setInt64(index, static_cast<int64_t>(value));
+}
+
+void MysqlQuery::bindValue(unsigned int index, unsigned long value) {
+    this->stmt->setUInt64(index, static_cast<uint64_t>(value));
+}
+
+void MysqlQuery::bindValue(unsigned int index, unsigned long long value) {
+    this->stmt->setUInt64(index, static_cast<uint64_t>(value));
+}
+
+void MysqlQuery::bindValue(unsigned int index, double value) {
+    this->stmt->setDouble(index, value);
+}
+
+void MysqlQuery::bindValue(unsigned int index, bool value) {
+    this->stmt->setBoolean(index, value);
+}
+
+void MysqlQuery::bindValue(unsigned int index, const std::string &value) {
+    this->stmt->setString(index, value);
+}
+
+void MysqlQuery::bindValue(unsigned int index, const char *value) {
+    if (value) {
+        this->stmt->setString(index, value);
+    } else {
+        this->stmt->setNull(index, sql::DataType::SQLNULL);
+    }
+}
+
+void MysqlQuery::bindValue(unsigned int index, std::nullptr_t) {
+    this->stmt->setNull(index, sql::DataType::SQLNULL);
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, int *value) {
+    *value = res->getInt(column);
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, unsigned int *value) {
+    *value = res->getUInt(column);
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, long *value) {
+    *value = static_cast<long>(res->getInt64(column));
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, long long *value) {
+    *value = static_cast<long long>(res->getInt64(column));
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, unsigned long *value) {
+    *value = static_cast<unsigned long>(res->getUInt64(column));
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, unsigned long long *value) {
+    *value = static_cast<unsigned long long>(res->getUInt64(column));
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, double *value) {
+    *value = static_cast<double>(res->getDouble(column));
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, bool *value) {
+    *value = (res->getInt(column) != 0);
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, char *value) {
+    std::string str = res->getString(column);
+    *value = str.size() ? str.at(0) : '\0';
+}
+
+void MysqlQuery::readColumn(const sql::ResultSet *res, uint32_t column, std::string *value) {
+    if (res->isNull(column)) {
+        value->clear();
+    } else {
+        *value = res->getString(column);
+    }
+}
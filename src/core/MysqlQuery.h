@@ -0,0 +1,265 @@
+/**
+  @file    MysqlQuery.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  A small wrapper around a MySQL prepared statement and its result set
+  The statement and result set are deleted automatically, so nothing leaks if an exception is thrown part way through
+  Parameters can be bound in one call, and rows can be read straight into structs that have a MysqlRow field list
+
+  Example:
+    struct Team { int id; std::string name; };
+    template <> struct MysqlRow<Team> {
+        static constexpr auto fields = std::make_tuple(&Team::id, &Team::name);
+    };
+
+    MysqlQuery query(&jlwe, "SELECT team_id, team_name FROM game_teams WHERE team_id > ?;");
+    query.bind(10);
+    std::vector<Team> teams = query.fetchAll<Team>();
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef MYSQLQUERY_H
+#define MYSQLQUERY_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <mysql_connection.h>
+
+#include <cppconn/datatype.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+
+class JlweCore;
+
+/*!
+ * \brief The list of fields that a row of a query result is read into, in the same order as the columns in the SELECT.
+ *
+ * Specialise this for each struct, with a tuple of pointers to its members called "fields".
+ */
+template <typename T>
+struct MysqlRow;
+
+class MysqlQuery {
+public:
+
+    /*!
+     * \brief Constructor for MysqlQuery. Uses the statement cache of the JlweCore connection, so the SQL is only prepared once per connection.
+     *
+     * Finish with the results before making another MysqlQuery (or calling getPreparedStatement) with the same SQL.
+     *
+     * \param jlwe JlweCore object (for mysql access)
+     * \param sql The SQL text of the statement
+     */
+    MysqlQuery(const JlweCore *jlwe, const std::string &sql);
+
+    /*!
+     * \brief Constructor for MysqlQuery. Prepares a new statement on the connection, which is deleted with the MysqlQuery.
+     *
+     * \param con The MySQL connection
+     * \param sql The SQL text of the statement
+     */
+    MysqlQuery(sql::Connection *con, const std::string &sql);
+
+    /*!
+     * \brief Destructor for MysqlQuery. Deletes the result set, and the statement if this object prepared it.
+     */
+    ~MysqlQuery();
+
+    MysqlQuery( const MysqlQuery& ) = delete; // non construction-copyable
+    MysqlQuery& operator=( const MysqlQuery& ) = delete; // non copyable
+
+    /*!
+     * \brief Sets all the parameters of the statement, in order, starting from the first one.
+     *
+     * Supported types are integers, bool, double, strings, nullptr (NULL) and std::optional (NULL if empty).
+     *
+     * \param args The values of the parameters
+     * \return This query, so calls can be chained
+     */
+    template <typename... Args>
+    MysqlQuery &bind(const Args&... args) {
+        unsigned int index = 0;
+        (bindValue(++index, args), ...);
+        this->bindCount = index;
+        return *this;
+    }
+
+    /*!
+     * \brief Sets a hint of how many rows the query will return.
+     *
+     * fetchAll() reserves space for this many rows, and the hint is passed on to the driver when it supports it.
+     *
+     * \param rows The expected number of rows
+     * \return This query, so calls can be chained
+     */
+    MysqlQuery &setFetchSize(size_t rows);
+
+    /*!
+     * \brief Runs the query. Any previous result set from this query is deleted.
+     *
+     * The time taken is recorded by QueryProfiler if it is turned on.
+     *
+     * \return The result set, which is owned by this object
+     */
+    sql::ResultSet *execute();
+
+    /*!
+     * \brief Runs a statement that doesn't return rows (INSERT, UPDATE, DELETE).
+     *
+     * \return The number of rows affected
+     */
+    int executeUpdate();
+
+    /*!
+     * \brief Moves to the next row of the results, running the query first if it hasn't been run yet.
+     *
+     * \return True if there is another row
+     */
+    bool next();
+
+    /*!
+     * \brief Gets the current result set.
+     *
+     * \return The result set, or nullptr if the query hasn't been run
+     */
+    sql::ResultSet *result() const;
+
+    /*!
+     * \brief Reads the current row into a struct using the MysqlRow<T> field list.
+     *
+     * \param row The struct to fill in
+     */
+    template <typename T>
+    void readRow(T *row) const {
+        readFields(row, MysqlRow<T>::fields, std::make_index_sequence<std::tuple_size<decltype(MysqlRow<T>::fields)>::value>());
+    }
+
+    /*!
+     * \brief Runs the query (if needed) and reads all the remaining rows.
+     *
+     * \return The rows, read using the MysqlRow<T> field list
+     */
+    template <typename T>
+    std::vector<T> fetchAll() {
+        std::vector<T> rows;
+        rows.reserve(this->fetchSize);
+        while (this->next()) {
+            rows.emplace_back();
+            this->readRow(&rows.back());
+        }
+        return rows;
+    }
+
+    /*!
+     * \brief Runs the query (if needed) and reads the next row.
+     *
+     * \param row The struct to fill in
+     * \return False if there are no more rows
+     */
+    template <typename T>
+    bool fetchOne(T *row) {
+        if (!this->next())
+            return false;
+        this->readRow(row);
+        return true;
+    }
+
+    /*!
+     * \brief Runs the query (if needed) and reads the first column of the next row.
+     *
+     * \param defaultValue The value returned if there are no more rows
+     * \return The value of the column
+     */
+    template <typename T>
+    T fetchValue(const T &defaultValue) {
+        if (!this->next())
+            return defaultValue;
+        T value;
+        readColumn(this->res.get(), 1, &value);
+        return value;
+    }
+
+    // Reading single columns, NULL values become 0 or an empty string unless read into a std::optional
+    static void readColumn(const sql::ResultSet *res, uint32_t column, int *value);
+    static void readColumn(const sql::ResultSet *res, uint32_t column, unsigned int *value);
+    static void readColumn(const sql::ResultSet *res, uint32_t column, long *value);
+    static void readColumn(const sql::ResultSet *res, uint32_t column, long long *value);
+    static void readColumn(const sql::ResultSet *res, uint32_t column, unsigned long *value);
+    static void readColumn(const sql::ResultSet *res, uint32_t column, unsigned long long *value);
+    static void readColumn(const sql::ResultSet *res, uint32_t column, double *value);
+    static void readColumn(const sql::ResultSet *res, uint32_t column, bool *value);
+    static void readColumn(const sql::ResultSet *res, uint32_t column, char *value); // first character, or '\0' if empty
+    static void readColumn(const sql::ResultSet *res, uint32_t column, std::string *value);
+
+    template <typename T>
+    static void readColumn(const sql::ResultSet *res, uint32_t column, std::optional<T> *value) {
+        if (res->isNull(column)) {
+            value->reset();
+        } else {
+            T v;
+            readColumn(res, column, &v);
+            *value = v;
+        }
+    }
+
+private:
+
+    // Only deletes the statement if this object prepared it, cached statements belong to the connection pool
+    struct StatementDeleter {
+        bool owned;
+        void operator()(sql::PreparedStatement *stmt) const {
+            if (owned)
+                delete stmt;
+        }
+    };
+
+    void bindValue(unsigned int index, int value);
+    void bindValue(unsigned int index, unsigned int value);
+    void bindValue(unsigned int index, long value);
+    void bindValue(unsigned int index, long long value);
+    void bindValue(unsigned int index, unsigned long value);
+    void bindValue(unsigned int index, unsigned long long value);
+    void bindValue(unsigned int index, double value);
+    void bindValue(unsigned int index, bool value);
+    void bindValue(unsigned int index, const std::string &value);
+    void bindValue(unsigned int index, const char *value);
+    void bindValue(unsigned int index, std::nullptr_t);
+
+    template <typename T>
+    void bindValue(unsigned int index, const std::optional<T> &value) {
+        if (value) {
+            this->bindValue(index, *value);
+        } else {
+            this->bindValue(index, nullptr);
+        }
+    }
+
+    template <typename T, typename Fields, size_t... I>
+    void readFields(T *row, const Fields &fields, std::index_sequence<I...>) const {
+        (readColumn(this->res.get(), static_cast<uint32_t>(I + 1), &(row->*std::get<I>(fields))), ...);
+    }
+
+    // The result set has to be deleted before the statement, so it is declared after it
+    std::unique_ptr<sql::PreparedStatement, StatementDeleter> stmt;
+    std::unique_ptr<sql::ResultSet> res;
+    size_t fetchSize;
+    // Only used by QueryProfiler
+    std::string sqlText;
+    unsigned int bindCount;
+    bool profiling; // true if the current result set was recorded, so the rows read from it are counted
+    unsigned long long rowsRead;
+
+    // Adds the rows read from the current result set to QueryProfiler
+    void recordRows();
+};
+
+#endif // MYSQLQUERY_H
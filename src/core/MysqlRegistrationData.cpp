@@ -0,0 +1,103 @@
+/**
+  @file    MysqlRegistrationData.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Loads the order and payment data for PaymentUtils from the MySQL database
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "MysqlRegistrationData.h"
+
+#include "MysqlQuery.h"
+
+MysqlRegistrationData::MysqlRegistrationData(sql::Connection *con) {
+    this->m_con = con;
+}
+
+std::vector<PaymentUtils::paymentEntry> MysqlRegistrationData::getUserPayments(const std::string &userKey) {
+    std::vector<PaymentUtils::paymentEntry> result;
+
+    //get bank/cash payments
+    MysqlQuery paymentQuery(this->m_con, "SELECT id, timestamp, amount_received, payment_type FROM payment_log WHERE user_key = ?;");
+    paymentQuery.bind(userKey);
+    while (paymentQuery.next()){
+        sql::ResultSet *res = paymentQuery.result();
+        PaymentUtils::paymentEntry entry;
+        entry.id = res->getString(1);
+        entry.timestamp = res->getInt64(2);
+        entry.payment_amount = res->getInt(3);
+        entry.payment_type = res->getString(4);
+        result.push_back(entry);
+    }
+
+    //get card payments
+    MysqlQuery sessionQuery(this->m_con, "SELECT stripe_session_id FROM event_registrations WHERE idempotency = ? UNION SELECT stripe_session_id FROM camping WHERE idempotency = ? UNION SELECT stripe_session_id FROM sat_dinner WHERE idempotency = ? UNION SELECT stripe_session_id FROM merch_orders WHERE idempotency = ?;");
+    std::string cs_id = sessionQuery.bind(userKey, userKey, userKey, userKey).fetchValue<std::string>("");
+
+    if (cs_id.size()) {
+        MysqlQuery intentQuery(this->m_con, "SELECT payment_intent FROM stripe_event_log WHERE cs_id = ?;");
+        std::string payment_intent = intentQuery.bind(cs_id).fetchValue<std::string>("");
+
+        if (payment_intent.size()) {
+
+            MysqlQuery cardQuery(this->m_con, "SELECT id, timestamp, amount_received FROM stripe_event_log WHERE payment_intent = ? AND (type = 'payment_intent.succeeded' OR type = 'charge.refunded');");
+            cardQuery.bind(payment_intent);
+            while (cardQuery.next()){
+                sql::ResultSet *res = cardQuery.result();
+                PaymentUtils::paymentEntry entry;
+                entry.id = res->getString(1);
+                entry.timestamp = res->getInt64(2);
+                entry.payment_amount = res->getInt(3);
+                entry.payment_type = "card";
+                result.push_back(entry);
+            }
+        }
+    }
+
+    return result;
+}
+
+RegistrationData::UserOrder MysqlRegistrationData::getUserOrder(const std::string &userKey) {
+    UserOrder order;
+
+    MysqlQuery eventQuery(this->m_con, "SELECT number_adults, number_children FROM event_registrations WHERE idempotency = ?;");
+    eventQuery.bind(userKey);
+    if (eventQuery.next()){
+        order.has_event = true;
+        order.number_adults = eventQuery.result()->getInt(1);
+        order.number_children = eventQuery.result()->getInt(2);
+    }
+
+    MysqlQuery campingQuery(this->m_con, "SELECT camping.number_people, camping_options.price_code, (camping.leave_date - camping.arrive_date) FROM camping INNER JOIN camping_options ON camping.camping_type=camping_options.id_string WHERE camping.idempotency = ?;");
+    campingQuery.bind(userKey);
+    if (campingQuery.next()){
+        sql::ResultSet *res = campingQuery.result();
+        order.has_camping = true;
+        order.camping_people = res->getInt(1);
+        order.camping_price_code = res->getString(2);
+        order.camping_nights = res->getInt(3);
+    }
+
+    MysqlQuery dinnerQuery(this->m_con, "SELECT dinner_form_id, dinner_options_adults FROM sat_dinner WHERE idempotency = ?;");
+    dinnerQuery.bind(userKey);
+    while (dinnerQuery.next()) {
+        order.dinner_orders.push_back({dinnerQuery.result()->getInt(1), dinnerQuery.result()->getString(2)});
+    }
+
+    MysqlQuery merchQuery(this->m_con, "SELECT SUM(merch_items.cost) FROM merch_items INNER JOIN merch_order_items ON merch_items.id=merch_order_items.item_id INNER JOIN merch_orders ON merch_orders.order_id=merch_order_items.order_id WHERE merch_orders.idempotency = ?;");
+    order.merch_cost = merchQuery.bind(userKey).fetchValue<int>(0);
+
+    order.card_fees = PaymentUtils::getCardPaymentFees(this->m_con, userKey);
+
+    return order;
+}
+
+std::vector<DinnerUtils::dinner_menu_item> MysqlRegistrationData::getDinnerMenuItems(int dinner_form_id) {
+    auto it = this->menu_items.find(dinner_form_id);
+    if (it == this->menu_items.end())
+        it = this->menu_items.emplace(dinner_form_id, DinnerUtils::getDinnerMenuItems(this->m_con, dinner_form_id)).first;
+    return it->second;
+}
@@ -0,0 +1,42 @@
+/**
+  @file    MysqlRegistrationData.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Loads the order and payment data for PaymentUtils from the MySQL database
+  Dinner menus are kept after the first time they are read, so one object can be used for a whole list of users
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef MYSQLREGISTRATIONDATA_H
+#define MYSQLREGISTRATIONDATA_H
+
+#include <map>
+
+#include "RegistrationData.h"
+
+class MysqlRegistrationData : public RegistrationData {
+public:
+
+    /*!
+     * \brief MysqlRegistrationData Constructor.
+     *
+     * \param con MySQL connection object
+     */
+    MysqlRegistrationData(sql::Connection *con);
+
+    std::vector<PaymentUtils::paymentEntry> getUserPayments(const std::string &userKey) override;
+    UserOrder getUserOrder(const std::string &userKey) override;
+    std::vector<DinnerUtils::dinner_menu_item> getDinnerMenuItems(int dinner_form_id) override;
+
+private:
+    sql::Connection *m_con;
+
+    // Menu items for each dinner form that has been read, the key is the form id
+    // Keep one object for a whole list of users (eg. every row of a spreadsheet) so each menu is only read once
+    std::map<int, std::vector<DinnerUtils::dinner_menu_item>> menu_items;
+};
+
+#endif // MYSQLREGISTRATIONDATA_H
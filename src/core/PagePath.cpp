@@ -0,0 +1,99 @@
+/**
+  @file    PagePath.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Turns the URL of a page request into a clean path, and finds the file in the document root for it (if there is one)
+  All functions are static so there is no need to create instances of the PagePath object
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "PagePath.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <vector>
+
+PagePath::DirectoryCache PagePath::cache = {"", {0, 0}, {}};
+
+std::string PagePath::normalise(const std::string &requestUri) {
+    // remove any url arguments (like fbclid)
+    std::string uri = requestUri.substr(0, requestUri.find_first_of("?#"));
+
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= uri.size()) {
+        size_t end = uri.find_first_of("/\\", start);
+        if (end == std::string::npos)
+            end = uri.size();
+
+        std::string part = uri.substr(start, end - start);
+        if (part == "..") {
+            if (parts.size())
+                parts.pop_back();
+        } else if (part.size() && part != ".") {
+            parts.push_back(part);
+        }
+        start = end + 1;
+    }
+
+    // default to index.html page
+    bool directory = (uri.empty() || uri.back() == '/' || uri.back() == '\\');
+    if (!directory) {
+        size_t lastSlash = uri.find_last_of("/\\");
+        std::string last = uri.substr(lastSlash == std::string::npos ? 0 : lastSlash + 1);
+        directory = (last == "." || last == "..");
+    }
+    if (directory)
+        parts.push_back("index.html");
+
+    std::string path;
+    for (const std::string &part : parts)
+        path += "/" + part;
+    return path;
+}
+
+void PagePath::loadDirectory(const std::string &directory, const struct timespec &modifiedTime) {
+    cache.directory = directory;
+    cache.modifiedTime = modifiedTime;
+    cache.files.clear();
+
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr)
+        return;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != nullptr) {
+        if (ent->d_name[0] == '.')
+            continue;
+
+        bool regularFile = (ent->d_type == DT_REG);
+        if (ent->d_type == DT_UNKNOWN || ent->d_type == DT_LNK) {
+            struct stat file_info;
+            regularFile = (stat((directory + "/" + ent->d_name).c_str(), &file_info) == 0 && S_ISREG(file_info.st_mode));
+        }
+        if (regularFile)
+            cache.files.insert(ent->d_name);
+    }
+    closedir(dir);
+}
+
+std::string PagePath::findDocumentRootFile(const std::string &docRoot, const std::string &path) {
+    // Only files directly in the document root, so the path must be a single part
+    if (path.size() < 2 || path.find('/', 1) != std::string::npos)
+        return "";
+
+    struct stat dir_info;
+    if (stat(docRoot.c_str(), &dir_info) != 0)
+        return "";
+
+    // Adding, removing or renaming a file changes the directory's modified time
+    if (cache.directory != docRoot || cache.modifiedTime.tv_sec != dir_info.st_mtim.tv_sec || cache.modifiedTime.tv_nsec != dir_info.st_mtim.tv_nsec)
+        loadDirectory(docRoot, dir_info.st_mtim);
+
+    std::string name = path.substr(1);
+    if (cache.files.find(name) == cache.files.end())
+        return "";
+    return docRoot + "/" + name;
+}
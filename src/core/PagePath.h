@@ -0,0 +1,62 @@
+/**
+  @file    PagePath.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Turns the URL of a page request into a clean path, and finds the file in the document root for it (if there is one)
+  The list of files in the document root is read once and kept until the directory changes
+  All functions are static so there is no need to create instances of the PagePath object
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef PAGEPATH_H
+#define PAGEPATH_H
+
+#include <ctime>
+#include <string>
+#include <unordered_set>
+
+class PagePath {
+public:
+
+    /*!
+     * \brief Makes a clean path from a request URI.
+     *
+     * The query string is removed, backslashes are treated as slashes, empty and "." parts are removed
+     * and ".." removes the part before it (it can't go above the root). A path ending in / gets index.html added.
+     *
+     * eg. "/a/../b//c.html?x=1" becomes "/b/c.html", and "/" becomes "/index.html"
+     *
+     * \param requestUri The URI of the request
+     * \return The path, always starting with a /
+     */
+    static std::string normalise(const std::string &requestUri);
+
+    /*!
+     * \brief Finds the file in the document root for a page.
+     *
+     * Only regular files directly in the document root are used, not sub-directories or hidden files.
+     *
+     * \param docRoot The document root directory
+     * \param path A path from normalise()
+     * \return The full filename, or an empty string if there isn't a file for the path
+     */
+    static std::string findDocumentRootFile(const std::string &docRoot, const std::string &path);
+
+private:
+
+    // The files in the document root, kept until the directory's modified time changes
+    struct DirectoryCache {
+        std::string directory;
+        struct timespec modifiedTime;
+        std::unordered_set<std::string> files;
+    };
+
+    static DirectoryCache cache;
+
+    static void loadDirectory(const std::string &directory, const struct timespec &modifiedTime);
+};
+
+#endif // PAGEPATH_H
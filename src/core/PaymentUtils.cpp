@@ -14,85 +14,25 @@
 
 #include "../prices.h"
 #include "../registration/DinnerUtils.h"
-
-#include <mysql_driver.h>
-#include <mysql_connection.h>
-
-#include <cppconn/driver.h>
-#include <cppconn/exception.h>
-#include <cppconn/resultset.h>
-#include <cppconn/statement.h>
-#include <cppconn/prepared_statement.h>
+#include "MysqlQuery.h"
+#include "MysqlRegistrationData.h"
 
 std::vector<PaymentUtils::paymentEntry> PaymentUtils::getUserPayments(sql::Connection *con, const std::string &userKey) {
-    std::vector<paymentEntry> result;
-    sql::PreparedStatement *prep_stmt;
-    sql::ResultSet *res;
-
-    //get bank/cash payments
-    prep_stmt = con->prepareStatement("SELECT id, timestamp, amount_received, payment_type FROM payment_log WHERE user_key = ?;");
-    prep_stmt->setString(1, userKey);
-    res = prep_stmt->executeQuery();
-    while (res->next()){
-        paymentEntry entry;
-        entry.id = res->getString(1);
-        entry.timestamp = res->getInt64(2);
-        entry.payment_amount = res->getInt(3);
-        entry.payment_type = res->getString(4);
-        result.push_back(entry);
-    }
-    delete res;
-    delete prep_stmt;
-
-    //get card payments
-    std::string cs_id = "";
-    prep_stmt = con->prepareStatement("SELECT stripe_session_id FROM event_registrations WHERE idempotency = ? UNION SELECT stripe_session_id FROM camping WHERE idempotency = ? UNION SELECT stripe_session_id FROM sat_dinner WHERE idempotency = ? UNION SELECT stripe_session_id FROM merch_orders WHERE idempotency = ?;");
-    prep_stmt->setString(1, userKey);
-    prep_stmt->setString(2, userKey);
-    prep_stmt->setString(3, userKey);
-    prep_stmt->setString(4, userKey);
-    res = prep_stmt->executeQuery();
-    if (res->next()){
-        cs_id = res->getString(1);
-    }
-    delete res;
-    delete prep_stmt;
-
-    if (cs_id.size()) {
-        std::string payment_intent = "";
-        prep_stmt = con->prepareStatement("SELECT payment_intent FROM stripe_event_log WHERE cs_id = ?;");
-        prep_stmt->setString(1, cs_id);
-        res = prep_stmt->executeQuery();
-        if (res->next()){
-            payment_intent = res->getString(1);
-        }
-        delete res;
-        delete prep_stmt;
-
-        if (payment_intent.size()) {
-
-            prep_stmt = con->prepareStatement("SELECT id, timestamp, amount_received FROM stripe_event_log WHERE payment_intent = ? AND (type = 'payment_intent.succeeded' OR type = 'charge.refunded');");
-            prep_stmt->setString(1, payment_intent);
-            res = prep_stmt->executeQuery();
-            while (res->next()){
-                paymentEntry entry;
-                entry.id = res->getString(1);
-                entry.timestamp = res->getInt64(2);
-                entry.payment_amount = res->getInt(3);
-                entry.payment_type = "card";
-                result.push_back(entry);
-            }
-            delete res;
-            delete prep_stmt;
-        }
-    }
-
-    return result;
+    MysqlRegistrationData data(con);
+    return getUserPayments(&data, userKey);
 }
 
+std::vector<PaymentUtils::paymentEntry> PaymentUtils::getUserPayments(RegistrationData *data, const std::string &userKey) {
+    return data->getUserPayments(userKey);
+}
 
 int PaymentUtils::getTotalPaymentReceived(sql::Connection *con, const std::string &userKey) {
-    std::vector<paymentEntry> table = getUserPayments(con, userKey);
+    MysqlRegistrationData data(con);
+    return getTotalPaymentReceived(&data, userKey);
+}
+
+int PaymentUtils::getTotalPaymentReceived(RegistrationData *data, const std::string &userKey) {
+    std::vector<paymentEntry> table = data->getUserPayments(userKey);
     return getTotalPaymentReceived(&table);
 }
 
@@ -106,154 +46,67 @@ int PaymentUtils::getTotalPaymentReceived(std::vector<PaymentUtils::paymentEntry
 
 int PaymentUtils::getCardPaymentFees(sql::Connection *con, const std::string &userKey) {
     int total = 0;
-    sql::PreparedStatement *prep_stmt;
-    sql::ResultSet *res;
-    prep_stmt = con->prepareStatement("SELECT fee FROM stripe_card_fees WHERE idempotency = ?;");
-    prep_stmt->setString(1, userKey);
-    res = prep_stmt->executeQuery();
-    while (res->next()){
-        total += res->getInt(1);
+    MysqlQuery query(con, "SELECT fee FROM stripe_card_fees WHERE idempotency = ?;");
+    query.bind(userKey);
+    while (query.next()){
+        total += query.result()->getInt(1);
     }
-    delete res;
-    delete prep_stmt;
     return total;
 }
 
 int PaymentUtils::getUserCost(sql::Connection *con, const std::string &userKey) {
+    MysqlRegistrationData data(con);
+    return getUserCost(&data, userKey);
+}
+
+int PaymentUtils::getUserCost(RegistrationData *data, const std::string &userKey) {
     int result = 0;
-    sql::PreparedStatement *prep_stmt;
-    sql::ResultSet *res;
-    prep_stmt = con->prepareStatement("SELECT number_adults, number_children FROM event_registrations WHERE idempotency = ?;");
-    prep_stmt->setString(1, userKey);
-    res = prep_stmt->executeQuery();
-    if (res->next()){
-        result = res->getInt(1) * PRICE_EVENT_ADULT + res->getInt(2) * PRICE_EVENT_CHILD;
-    }
-    delete res;
-    delete prep_stmt;
+    RegistrationData::UserOrder order = data->getUserOrder(userKey);
 
-    prep_stmt = con->prepareStatement("SELECT camping.number_people, camping_options.price_code, (camping.leave_date - camping.arrive_date) FROM camping INNER JOIN camping_options ON camping.camping_type=camping_options.id_string WHERE camping.idempotency = ?;");
-    prep_stmt->setString(1, userKey);
-    res = prep_stmt->executeQuery();
-    if (res->next()){
-        result += getCampingPrice(res->getString(2), res->getInt(1), res->getInt(3));
-    }
-    delete res;
-    delete prep_stmt;
+    if (order.has_event)
+        result = order.number_adults * PRICE_EVENT_ADULT + order.number_children * PRICE_EVENT_CHILD;
+
+    if (order.has_camping)
+        result += getCampingPrice(order.camping_price_code, order.camping_people, order.camping_nights);
 
     // dinner costs
-    prep_stmt = con->prepareStatement("SELECT dinner_form_id, dinner_options_adults FROM sat_dinner WHERE idempotency = ?;");
-    prep_stmt->setString(1, userKey);
-    res = prep_stmt->executeQuery();
-    while (res->next()) {
-        result += DinnerUtils::getDinnerCost(con, res->getInt(1), res->getString(2));
-    }
-    delete res;
-    delete prep_stmt;
+    for (const auto &dinner : order.dinner_orders)
+        result += DinnerUtils::getDinnerCost(data->getDinnerMenuItems(dinner.first), dinner.second);
 
     // merch costs
-    prep_stmt = con->prepareStatement("SELECT SUM(merch_items.cost) FROM merch_items INNER JOIN merch_order_items ON merch_items.id=merch_order_items.item_id INNER JOIN merch_orders ON merch_orders.order_id=merch_order_items.order_id WHERE merch_orders.idempotency = ?;");
-    prep_stmt->setString(1, userKey);
-    res = prep_stmt->executeQuery();
-    if (res->next()){
-        result += res->getInt(1);
-    }
-    delete res;
-    delete prep_stmt;
+    result += order.merch_cost;
 
     // card payment fees
-    result += PaymentUtils::getCardPaymentFees(con, userKey);
+    result += order.card_fees;
 
     return result;
 }
 
 std::string PaymentUtils::getRegistrationType(sql::Connection *con, const std::string &userKey) {
-    std::string result = "";
-    sql::PreparedStatement *prep_stmt;
-    sql::ResultSet *res;
-
-    prep_stmt = con->prepareStatement("SELECT gc_username FROM event_registrations WHERE idempotency = ?;");
-    prep_stmt->setString(1, userKey);
-    res = prep_stmt->executeQuery();
-    if (res->next()){
-        result = "event";
-    }
-    delete res;
-    delete prep_stmt;
-
-    if (!result.size()) {
-        prep_stmt = con->prepareStatement("SELECT gc_username FROM camping WHERE idempotency = ?;");
-        prep_stmt->setString(1, userKey);
-        res = prep_stmt->executeQuery();
-        if (res->next()){
-            result = "camping_only";
-        }
-        delete res;
-        delete prep_stmt;
-    }
-
-    if (!result.size()) {
-        prep_stmt = con->prepareStatement("SELECT gc_username FROM sat_dinner WHERE idempotency = ?;");
-        prep_stmt->setString(1, userKey);
-        res = prep_stmt->executeQuery();
-        if (res->next()){
-            result = "dinner_only";
-        }
-        delete res;
-        delete prep_stmt;
-    }
-
-    if (!result.size()) {
-        prep_stmt = con->prepareStatement("SELECT gc_username FROM merch_orders WHERE idempotency = ?;");
-        prep_stmt->setString(1, userKey);
-        res = prep_stmt->executeQuery();
-        if (res->next()){
-            result = "merch";
-        }
-        delete res;
-        delete prep_stmt;
+    // The first table with an entry for the user decides the type
+    static const std::pair<const char *, const char *> types[] = {
+        {"SELECT gc_username FROM event_registrations WHERE idempotency = ?;", "event"},
+        {"SELECT gc_username FROM camping WHERE idempotency = ?;", "camping_only"},
+        {"SELECT gc_username FROM sat_dinner WHERE idempotency = ?;", "dinner_only"},
+        {"SELECT gc_username FROM merch_orders WHERE idempotency = ?;", "merch"}
+    };
+
+    for (const auto &type : types) {
+        MysqlQuery query(con, type.first);
+        if (query.bind(userKey).next())
+            return type.second;
     }
 
-    return result;
+    return "";
 }
 
 std::string PaymentUtils::getUserEmail(sql::Connection *con, const std::string &userKey) {
-    std::string result = "";
-    sql::PreparedStatement *prep_stmt;
-    sql::ResultSet *res;
-
-    prep_stmt = con->prepareStatement("SELECT email_address FROM event_registrations WHERE idempotency = ? UNION SELECT email_address FROM camping WHERE idempotency = ? UNION SELECT email_address FROM sat_dinner WHERE idempotency = ? UNION SELECT email_address FROM merch_orders WHERE idempotency = ?;");
-    prep_stmt->setString(1, userKey);
-    prep_stmt->setString(2, userKey);
-    prep_stmt->setString(3, userKey);
-    prep_stmt->setString(4, userKey);
-    res = prep_stmt->executeQuery();
-    if (res->next()){
-        result = res->getString(1);
-    }
-    delete res;
-    delete prep_stmt;
-
-    return result;
+    MysqlQuery query(con, "SELECT email_address FROM event_registrations WHERE idempotency = ? UNION SELECT email_address FROM camping WHERE idempotency = ? UNION SELECT email_address FROM sat_dinner WHERE idempotency = ? UNION SELECT email_address FROM merch_orders WHERE idempotency = ?;");
+    return query.bind(userKey, userKey, userKey, userKey).fetchValue<std::string>("");
 }
 
 
 std::string PaymentUtils::getUserName(sql::Connection *con, const std::string &userKey) {
-    std::string result = "";
-    sql::PreparedStatement *prep_stmt;
-    sql::ResultSet *res;
-
-    prep_stmt = con->prepareStatement("SELECT gc_username FROM event_registrations WHERE idempotency = ? UNION SELECT gc_username FROM camping WHERE idempotency = ? UNION SELECT gc_username FROM sat_dinner WHERE idempotency = ? UNION SELECT gc_username FROM merch_orders WHERE idempotency = ?;");
-    prep_stmt->setString(1, userKey);
-    prep_stmt->setString(2, userKey);
-    prep_stmt->setString(3, userKey);
-    prep_stmt->setString(4, userKey);
-    res = prep_stmt->executeQuery();
-    if (res->next()){
-        result = res->getString(1);
-    }
-    delete res;
-    delete prep_stmt;
-
-    return result;
+    MysqlQuery query(con, "SELECT gc_username FROM event_registrations WHERE idempotency = ? UNION SELECT gc_username FROM camping WHERE idempotency = ? UNION SELECT gc_username FROM sat_dinner WHERE idempotency = ? UNION SELECT gc_username FROM merch_orders WHERE idempotency = ?;");
+    return query.bind(userKey, userKey, userKey, userKey).fetchValue<std::string>("");
 }
@@ -18,6 +18,8 @@
 
 #include <cppconn/connection.h>
 
+class RegistrationData;
+
 class PaymentUtils {
 public:
 
@@ -61,6 +63,15 @@ public:
      */
     static std::vector<paymentEntry> getUserPayments(sql::Connection *con, const std::string &userKey);
 
+    /*!
+     * \brief Gets a list of all payments received from a given user
+     *
+     * \param data Where to load the payments from
+     * \param userKey The key of the user to get payment info for
+     * \return The list of payments
+     */
+    static std::vector<paymentEntry> getUserPayments(RegistrationData *data, const std::string &userKey);
+
     /*!
      * \brief Gets the total value of all payments from a table of payments
      *
@@ -78,6 +89,15 @@ public:
      */
     static int getTotalPaymentReceived(sql::Connection *con, const std::string &userKey);
 
+    /*!
+     * \brief Gets the total value of all payments received from a given user
+     *
+     * \param data Where to load the payments from
+     * \param userKey The key of the user to get payment info for
+     * \return The total value (in cents)
+     */
+    static int getTotalPaymentReceived(RegistrationData *data, const std::string &userKey);
+
     /*!
      * \brief Gets the total cost of all items a given user has ordered
      *
@@ -87,6 +107,17 @@ public:
      */
     static int getUserCost(sql::Connection *con, const std::string &userKey);
 
+    /*!
+     * \brief Gets the total cost of all items a given user has ordered
+     *
+     * Use this version when working out the cost for many users, the data object only reads each dinner menu once
+     *
+     * \param data Where to load the user's order from
+     * \param userKey The key of the user to get payment info for
+     * \return The total cost (in cents)
+     */
+    static int getUserCost(RegistrationData *data, const std::string &userKey);
+
     /*!
      * \brief Gets the type of registration for a user (event, camping_only, dinner_only or merch)
      *
@@ -18,17 +18,32 @@
  */
 #include "PostDataParser.h"
 
+#include <algorithm>
+#include <functional> // boyer_moore_horspool_searcher
 #include <iostream>  //cout, cin
 #include <limits>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
 
 #include "CgiEnvironment.h"
 #include "JlweUtils.h"
 #include "Encoder.h"
 
-PostDataParser::PostDataParser(long maxContentLength) :
+// Multipart data is read from stdin in chunks of this size
+#define READ_CHUNK_SIZE 65536
+
+// The largest allowed header block for one part of multipart data
+#define MAX_PART_HEADER_SIZE 16384
+
+// Where file uploads larger than the spill threshold are written while the request is being read
+#define TEMP_FILE_TEMPLATE "/tmp/jlwe_upload.XXXXXX"
+
+PostDataParser::PostDataParser(long maxContentLength, size_t spillThreshold) :
     KeyValueParser()
 {
     this->dataBuffer = nullptr;
+    this->mSpillThreshold = spillThreshold;
     this->mParseError = false;
     this->mErrorText = "";
     this->mContentLength = CgiEnvironment::getContentLength();
@@ -47,18 +62,19 @@ PostDataParser::PostDataParser(long maxContentLength) :
         if (this->mContentLength > maxContentLength)
             throw std::invalid_argument("Content-Length is too large, limit is " + std::to_string(maxContentLength) + " bytes");
 
-        this->dataBuffer = new char[static_cast<unsigned int>(this->mContentLength)];
-        if (!this->dataBuffer)
-            throw std::invalid_argument("Unable to allocate " + std::to_string(this->mContentLength) + " bytes of memory for post data");
-
-        std::cin.read(this->dataBuffer, this->mContentLength);
-        long readLength = std::cin.gcount();
-        if (readLength != mContentLength)
-            throw std::invalid_argument("Only able to read " + std::to_string(readLength) + " of " + std::to_string(this->mContentLength) + " bytes");
-
-        // if it is a multipart post (ie. a file upload) then parse it
-        if (JlweUtils::compareStringsNoCase(this->mContentType.substr(0, multipart_type.size()), multipart_type))
+        if (JlweUtils::compareStringsNoCase(this->mContentType.substr(0, multipart_type.size()), multipart_type)) {
+            // if it is a multipart post (ie. a file upload) then parse it while it is read
             this->parseMultiPart();
+        } else {
+            this->dataBuffer = new char[static_cast<unsigned int>(this->mContentLength)];
+            if (!this->dataBuffer)
+                throw std::invalid_argument("Unable to allocate " + std::to_string(this->mContentLength) + " bytes of memory for post data");
+
+            std::cin.read(this->dataBuffer, this->mContentLength);
+            long readLength = std::cin.gcount();
+            if (readLength != mContentLength)
+                throw std::invalid_argument("Only able to read " + std::to_string(readLength) + " of " + std::to_string(this->mContentLength) + " bytes");
+        }
 
     } catch (std::exception& e) {
         this->mParseError = true;
@@ -73,10 +89,17 @@ PostDataParser::PostDataParser(long maxContentLength) :
 PostDataParser::~PostDataParser() {
     if (this->dataBuffer)
         delete [] this->dataBuffer;
+
+    // Remove any temporary files that weren't moved by saveFile()
+    for (const FormFile &file : this->mFiles) {
+        if (file.tempFilename.size())
+            unlink(file.tempFilename.c_str());
+    }
 }
 
 void PostDataParser::parseUrlEncodedForm() {
-    this->parseFromString(std::string(this->dataBuffer, this->mContentLength), true);
+    if (this->dataBuffer)
+        this->parseFromView(std::string_view(this->dataBuffer, static_cast<size_t>(this->mContentLength)), true);
 }
 
 bool PostDataParser::hasError() {
@@ -109,77 +132,216 @@ std::vector<PostDataParser::FormFile> * PostDataParser::getFiles() {
     return &(this->mFiles);
 }
 
-void PostDataParser::parseMultiPart() {
-    std::string data(this->dataBuffer, this->mContentLength);
+bool PostDataParser::saveFile(const FormFile &file, const std::string &filename) {
+    if (file.tempFilename.empty()) {
+        FILE *output = fopen(filename.c_str(), "wb");
+        if (!output)
+            return false;
+        bool ok = (fwrite(file.data.data(), 1, file.data.size(), output) == file.data.size());
+        return (fclose(output) == 0) && ok;
+    }
 
-    // Find out what the separator is
-    std::string 		bType 	= "boundary=";
-    std::string::size_type 	pos 	= this->mContentType.find(bType);
-
-    // Remove next sentence
-    std::string                 commatek=";";
-
-    // generate the separators
-    std::string sep1 = this->mContentType.substr(pos + bType.length());
-    if (sep1.find(";")!=std::string::npos)
-       sep1=sep1.substr(0,sep1.find(";"));
-    sep1.append("\r\n");
-    sep1.insert(0, "--");
-
-    std::string sep2 = this->mContentType.substr(pos + bType.length());
-    if (sep2.find(";")!=std::string::npos)
-       sep2=sep2.substr(0,sep2.find(";"));
-    sep2.append("--\r\n");
-    sep2.insert(0, "--");
-
-    // Find the data between the separators
-    std::string::size_type start  = data.find(sep1);
-    std::string::size_type sepLen = sep1.length();
-    std::string::size_type oldPos = start + sepLen;
-
-    while(true) {
-      pos = data.find(sep1, oldPos);
-
-      // If sep1 wasn't found, the rest of the data is an item
-      if(std::string::npos == pos)
-        break;
-
-      // parse the data
-      parseMIME(data.substr(oldPos, pos - oldPos));
-
-      // update position
-      oldPos = pos + sepLen;
+    // Temporary files are created with mode 0600, give the file the permissions it would have had if it was made with fopen
+    mode_t mask = umask(0);
+    umask(mask);
+    chmod(file.tempFilename.c_str(), 0666 & ~mask);
+
+    if (rename(file.tempFilename.c_str(), filename.c_str()) == 0)
+        return true;
+
+    // rename() doesn't work across filesystems, so copy it instead
+    FILE *input = fopen(file.tempFilename.c_str(), "rb");
+    if (!input)
+        return false;
+    FILE *output = fopen(filename.c_str(), "wb");
+    if (!output) {
+        fclose(input);
+        return false;
     }
+    bool ok = true;
+    char buffer[READ_CHUNK_SIZE];
+    size_t size;
+    while ((size = fread(buffer, 1, READ_CHUNK_SIZE, input)) > 0) {
+        if (fwrite(buffer, 1, size, output) != size) {
+            ok = false;
+            break;
+        }
+    }
+    fclose(input);
+    if (fclose(output) != 0)
+        ok = false;
+    if (ok)
+        unlink(file.tempFilename.c_str());
+    return ok;
+}
+
+void PostDataParser::parseMultiPart() {
+    // Find out what the separator is
+    std::string bType = "boundary=";
+    std::string::size_type pos = this->mContentType.find(bType);
+    if (pos == std::string::npos)
+        throw std::invalid_argument("No boundary in multipart Content-Type");
+
+    std::string boundary = this->mContentType.substr(pos + bType.length());
+    if (boundary.find(";") != std::string::npos)
+        boundary = boundary.substr(0, boundary.find(";"));
+    JlweUtils::trimString(boundary);
+    if (boundary.size() >= 2 && boundary.front() == '"' && boundary.back() == '"')
+        boundary = boundary.substr(1, boundary.size() - 2);
+    if (boundary.empty())
+        throw std::invalid_argument("No boundary in multipart Content-Type");
+
+    // Every separator is "--boundary" with a CRLF before it, except the first one
+    // So a CRLF is added to the start of the data, then all the separators are the same
+    const std::string delimiter = "\r\n--" + boundary;
+    const std::boyer_moore_horspool_searcher<std::string::const_iterator> searcher(delimiter.begin(), delimiter.end());
+
+    enum { PREAMBLE, AFTER_DELIMITER, HEADERS, BODY, EPILOGUE } state = PREAMBLE;
+    std::string buffer = "\r\n";
+    size_t start = 0; // the first byte in buffer that hasn't been used
+    long remaining = this->mContentLength;
+    std::vector<char> chunk(READ_CHUNK_SIZE);
+    CurrentPart part = {};
+    part.tempFile = nullptr;
 
-    // The data is terminated by sep2
-    pos = data.find(sep2, oldPos);
-    // parse the data, if found
-    if(std::string::npos != pos) {
-      parseMIME(data.substr(oldPos, pos - oldPos));
+    try {
+        while (state != EPILOGUE) {
+            bool needMoreData = false;
+
+            if (state == PREAMBLE || state == BODY) {
+                std::string::const_iterator found = std::search(buffer.cbegin() + static_cast<long>(start), buffer.cend(), searcher);
+                if (found == buffer.cend()) {
+                    // Use everything except the last few bytes, they could be the start of a separator
+                    size_t keep = std::min(buffer.size() - start, delimiter.size() - 1);
+                    size_t usable = buffer.size() - start - keep;
+                    if (state == BODY)
+                        this->appendToPart(&part, buffer.data() + start, usable);
+                    start += usable;
+                    needMoreData = true;
+                } else {
+                    size_t foundPos = static_cast<size_t>(found - buffer.cbegin());
+                    if (state == BODY) {
+                        this->appendToPart(&part, buffer.data() + start, foundPos - start);
+                        this->finishPart(&part);
+                    }
+                    start = foundPos + delimiter.size();
+                    state = AFTER_DELIMITER;
+                }
+            } else if (state == AFTER_DELIMITER) {
+                // The separator is followed by "--" at the end of the data, otherwise by a CRLF (maybe with whitespace before it)
+                if (buffer.size() - start >= 2 && buffer.compare(start, 2, "--") == 0) {
+                    state = EPILOGUE;
+                } else {
+                    size_t lineEnd = buffer.find("\r\n", start);
+                    if (lineEnd == std::string::npos) {
+                        if (buffer.size() - start > MAX_PART_HEADER_SIZE)
+                            throw std::runtime_error("Malformed input");
+                        needMoreData = true;
+                    } else {
+                        start = lineEnd + 2;
+                        state = HEADERS;
+                    }
+                }
+            } else if (state == HEADERS) {
+                // Search from the CRLF before the headers, so a part with no headers is found too
+                // (the CRLF is always still in the buffer, see below)
+                size_t headerEnd = buffer.find("\r\n\r\n", start - 2);
+                if (headerEnd == std::string::npos) {
+                    if (buffer.size() - start > MAX_PART_HEADER_SIZE)
+                        throw std::runtime_error("Multipart header is too large");
+                    needMoreData = true;
+                } else {
+                    this->startPart(&part, (headerEnd + 4 > start) ? buffer.substr(start, headerEnd + 4 - start) : "");
+                    start = headerEnd + 4;
+                    state = BODY;
+                }
+            }
+
+            if (needMoreData) {
+                if (remaining <= 0)
+                    throw std::runtime_error("Malformed input");
+
+                // Remove the used data from the buffer, then read the next chunk
+                // While reading the headers, the CRLF before them is kept for the search above
+                size_t keep = (state == HEADERS) ? 2 : 0;
+                buffer.erase(0, start - keep);
+                start = keep;
+                std::cin.read(chunk.data(), std::min<long>(remaining, READ_CHUNK_SIZE));
+                long readLength = std::cin.gcount();
+                if (readLength <= 0)
+                    throw std::invalid_argument("Only able to read " + std::to_string(this->mContentLength - remaining) + " of " + std::to_string(this->mContentLength) + " bytes");
+                buffer.append(chunk.data(), static_cast<size_t>(readLength));
+                remaining -= readLength;
+            }
+        }
+    } catch (...) {
+        if (part.tempFile) {
+            fclose(part.tempFile);
+            unlink(part.tempFilename.c_str());
+        }
+        throw;
     }
 }
 
-void PostDataParser::parseMIME(const std::string& data) {
-  // Find the header
-  std::string end = "\r\n\r\n";
-  std::string::size_type headLimit = data.find(end, 0);
+void PostDataParser::startPart(CurrentPart *part, const std::string &headerData) {
+    part->header = parseHeader(headerData);
+    part->data.clear();
+    part->tempFile = nullptr;
+    part->tempFilename = "";
+    part->size = 0;
+}
 
-  // Detect error
-  if(std::string::npos == headLimit)
-    throw std::runtime_error("Malformed input");
+void PostDataParser::appendToPart(CurrentPart *part, const char *data, size_t length) {
+    if (length == 0)
+        return;
+    part->size += length;
+
+    // Large files are moved out of memory into a temporary file
+    if (!part->tempFile && part->header.filename.size() && part->data.size() + length > this->mSpillThreshold) {
+        char tempFilename[] = TEMP_FILE_TEMPLATE;
+        int fd = mkstemp(tempFilename);
+        if (fd < 0)
+            throw std::runtime_error("Unable to create temporary file for upload");
+        part->tempFile = fdopen(fd, "wb");
+        if (!part->tempFile) {
+            close(fd);
+            unlink(tempFilename);
+            throw std::runtime_error("Unable to create temporary file for upload");
+        }
+        part->tempFilename = tempFilename;
+
+        if (fwrite(part->data.data(), 1, part->data.size(), part->tempFile) != part->data.size())
+            throw std::runtime_error("Unable to write temporary file for upload");
+        part->data.clear();
+        part->data.shrink_to_fit();
+    }
 
-  // Extract the value - there is still a trailing CR/LF to be subtracted off
-  std::string::size_type valueStart = headLimit + end.length();
-  std::string value = data.substr(valueStart, data.length() - valueStart - 2);
+    if (part->tempFile) {
+        if (fwrite(data, 1, length, part->tempFile) != length)
+            throw std::runtime_error("Unable to write temporary file for upload");
+    } else {
+        part->data.append(data, length);
+    }
+}
 
-  // Parse the header - pass trailing CR/LF x 2 to parseHeader
-  MultipartHeader head = parseHeader(data.substr(0, valueStart));
+void PostDataParser::finishPart(CurrentPart *part) {
+    if (part->tempFile) {
+        int result = fclose(part->tempFile);
+        part->tempFile = nullptr;
+        if (result != 0) {
+            unlink(part->tempFilename.c_str());
+            throw std::runtime_error("Unable to write temporary file for upload");
+        }
+    }
 
-  if (head.filename.empty()) {
-    this->addValue(head.name, value);
-  } else {
-    this->mFiles.push_back({head.name, head.filename, head.contentType, value});
-  }
+    // The data is moved rather than copied, an in memory file can be up to the spill size
+    if (part->header.filename.empty()) {
+        this->addValue(part->header.name, std::move(part->data));
+    } else {
+        this->mFiles.push_back({part->header.name, part->header.filename, part->header.contentType, std::move(part->data), std::move(part->tempFilename), part->size});
+    }
+    part->data.clear();
+    part->tempFilename.clear();
 }
 
 PostDataParser::MultipartHeader PostDataParser::parseHeader(const std::string& data)
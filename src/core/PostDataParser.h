@@ -11,6 +11,9 @@
    * The Url encoded data from a submitted form (Content-Type: application/x-www-form-urlencoded)
    * A multipart encoded form data eg. file upload (Content-Type: multipart/form-data)
 
+  Multipart data is parsed as it is read from stdin, so the whole request is never held in memory.
+  Form fields are kept in memory, file parts larger than the spill threshold are written to temporary files.
+
   This class reuses a lot of code from the cgicc library: https://www.gnu.org/software/cgicc/index.html
 
   This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
@@ -20,6 +23,7 @@
 #ifndef POSTDATAPARSER_H
 #define POSTDATAPARSER_H
 
+#include <cstdio>
 #include <string>
 #include <vector>
 
@@ -32,15 +36,18 @@ public:
         std::string name;
         std::string filename;
         std::string dataType;
-        std::string data;
+        std::string data;         // the file contents, empty if the file was written to tempFilename
+        std::string tempFilename; // the temporary file holding the contents, empty if the file is in data
+        size_t size;              // the size of the file in bytes
     };
 
     /**
       Constructer for PostDataParser class. The post data is parsed on construction.
 
       @param maxContentLength is maxium maximum content to accept. If a request larger than this is received, it will be ignored and a error will occur.
+      @param spillThreshold files in multipart data larger than this (in bytes) are written to a temporary file instead of being kept in memory
     */
-    PostDataParser(long maxContentLength);
+    PostDataParser(long maxContentLength, size_t spillThreshold = 1048576);
 
     /**
       Destructor for PostDataParser class.
@@ -84,6 +91,8 @@ public:
     /*!
      * \brief Returns a pointer to the post data received.
      *
+     * Multipart data isn't kept after it is parsed, so this is nullptr for multipart posts.
+     *
      * \return A pointer to the data, call contentLength() to get the size of this array
      */
     char * data();
@@ -91,7 +100,7 @@ public:
     /*!
      * \brief Returns the the post data received as a string.
      *
-     * \return A string containing the post data
+     * \return A string containing the post data (empty for multipart posts)
      */
     std::string dataAsString();
 
@@ -102,12 +111,24 @@ public:
      */
     std::vector<FormFile> * getFiles();
 
+    /*!
+     * \brief Saves a file from a multipart/form-data post.
+     *
+     * If the file was written to a temporary file it is moved to the new location, otherwise the data is written out.
+     *
+     * \param file The file from getFiles()
+     * \param filename The full path to save the file to
+     * \return true if successful, false if the file couldn't be written
+     */
+    static bool saveFile(const FormFile &file, const std::string &filename);
+
 
 private:
 
     std::string mRequestMethod;
     std::string mContentType;
     long mContentLength;
+    size_t mSpillThreshold;
     char *dataBuffer;
     std::vector<FormFile> mFiles;
 
@@ -121,8 +142,19 @@ private:
         std::string contentType;
     };
 
+    // The part of the multipart data that is currently being read
+    struct CurrentPart {
+        MultipartHeader header;
+        std::string data;
+        FILE *tempFile;
+        std::string tempFilename;
+        size_t size;
+    };
+
     void parseMultiPart();
-    void parseMIME(const std::string& data);
+    void startPart(CurrentPart *part, const std::string &headerData);
+    void appendToPart(CurrentPart *part, const char *data, size_t length);
+    void finishPart(CurrentPart *part);
     PostDataParser::MultipartHeader parseHeader(const std::string& data);
 };
 
@@ -0,0 +1,159 @@
+/**
+  @file    QueryProfiler.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Records every SQL statement run through MysqlQuery during a request (text, number of parameters, time taken and rows)
+  Statements with the same text that are run many times in one request are flagged, as they are usually a query inside
+  a loop (N+1 queries) that could be replaced by a single query
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "QueryProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+#include "CgiEnvironment.h"
+
+// Statements longer than this are shortened in the header
+#define HEADER_SQL_LENGTH 120
+
+bool QueryProfiler::enabled = false;
+bool QueryProfiler::debugHeader = false;
+unsigned int QueryProfiler::repeatThreshold = 10;
+std::string QueryProfiler::logFile = "";
+
+std::unordered_map<std::string, QueryProfiler::StatementStats> QueryProfiler::statements;
+unsigned int QueryProfiler::queryCount = 0;
+double QueryProfiler::totalMilliseconds = 0;
+std::chrono::system_clock::time_point QueryProfiler::requestStart;
+
+// Puts the SQL on one line, so each statement is one line of the log
+static std::string oneLine(const std::string &sql) {
+    std::string result = sql;
+    for (char &c : result) {
+        if (c == '\r' || c == '\n' || c == '\t')
+            c = ' ';
+    }
+    return result;
+}
+
+void QueryProfiler::beginRequest(const nlohmann::json &config) {
+    statements.clear();
+    queryCount = 0;
+    totalMilliseconds = 0;
+    requestStart = std::chrono::system_clock::now();
+
+    enabled = false;
+    auto it = config.find("queryProfiler");
+    if (it != config.end() && it->is_object()) {
+        enabled = it->value("enabled", false);
+        debugHeader = it->value("debugHeader", false);
+        repeatThreshold = it->value("repeatThreshold", 10u);
+        logFile = it->value("logFile", "");
+    }
+}
+
+void QueryProfiler::endRequest() {
+    if (!enabled)
+        return;
+    enabled = false;
+
+    if (!logFile.size())
+        return;
+
+    char timeText[32];
+    time_t startTime = std::chrono::system_clock::to_time_t(requestStart);
+    strftime(timeText, sizeof(timeText), "%Y-%m-%d %H:%M:%S", localtime(&startTime));
+    char totals[96];
+    snprintf(totals, sizeof(totals), " %u queries, %.2f ms, %u repeated\n", queryCount, totalMilliseconds, repeatedStatementCount());
+
+    std::string text = std::string(timeText) + " " + CgiEnvironment::getenvAsString("REQUEST_METHOD") + " " + CgiEnvironment::getenvAsString("REQUEST_URI") + totals + getSummary() + "\n";
+
+    // One write in append mode, so entries from different processes don't get mixed together
+    FILE *file = fopen(logFile.c_str(), "a");
+    if (file) {
+        fwrite(text.data(), 1, text.size(), file);
+        fclose(file);
+    }
+}
+
+void QueryProfiler::record(const std::string &sql, unsigned int bindCount, double milliseconds, unsigned long long rows) {
+    StatementStats &stats = statements[sql];
+    stats.count++;
+    stats.bindCount = bindCount;
+    stats.totalMilliseconds += milliseconds;
+    stats.maxMilliseconds = std::max(stats.maxMilliseconds, milliseconds);
+    stats.rows += rows;
+
+    queryCount++;
+    totalMilliseconds += milliseconds;
+}
+
+void QueryProfiler::recordRows(const std::string &sql, unsigned long long rows) {
+    if (!enabled)
+        return;
+    auto it = statements.find(sql);
+    if (it != statements.end())
+        it->second.rows += rows;
+}
+
+std::vector<std::pair<const std::string *, const QueryProfiler::StatementStats *>> QueryProfiler::sortedStatements() {
+    std::vector<std::pair<const std::string *, const StatementStats *>> result;
+    result.reserve(statements.size());
+    for (const auto &statement : statements)
+        result.push_back({&statement.first, &statement.second});
+    std::sort(result.begin(), result.end(), [](const auto &a, const auto &b) {
+        return a.second->totalMilliseconds > b.second->totalMilliseconds;
+    });
+    return result;
+}
+
+unsigned int QueryProfiler::repeatedStatementCount() {
+    unsigned int count = 0;
+    for (const auto &statement : statements) {
+        if (statement.second.count > repeatThreshold)
+            count++;
+    }
+    return count;
+}
+
+std::string QueryProfiler::getSummary() {
+    std::string result;
+    for (const auto &statement : sortedStatements()) {
+        const StatementStats *stats = statement.second;
+        char line[160];
+        snprintf(line, sizeof(line), "  %-9s %5ux %9.2f ms (max %.2f) %7llu rows %2u params  ",
+                 (stats->count > repeatThreshold ? "REPEATED" : ""), stats->count, stats->totalMilliseconds,
+                 stats->maxMilliseconds, stats->rows, stats->bindCount);
+        result += line + oneLine(*statement.first) + "\n";
+    }
+    return result;
+}
+
+std::string QueryProfiler::getHeaderValue() {
+    if (!enabled || !debugHeader)
+        return "";
+
+    char totals[96];
+    snprintf(totals, sizeof(totals), "queries=%u; time=%.2fms; repeated=%u", queryCount, totalMilliseconds, repeatedStatementCount());
+    std::string result = totals;
+
+    // The statement run the most times, if it is over the limit
+    const std::string *worstSql = nullptr;
+    unsigned int worstCount = repeatThreshold;
+    for (const auto &statement : statements) {
+        if (statement.second.count > worstCount) {
+            worstSql = &statement.first;
+            worstCount = statement.second.count;
+        }
+    }
+    if (worstSql) {
+        result += "; worst=" + std::to_string(worstCount) + "x " + oneLine(worstSql->substr(0, HEADER_SQL_LENGTH));
+    }
+    return result;
+}
@@ -0,0 +1,113 @@
+/**
+  @file    QueryProfiler.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Records every SQL statement run through MysqlQuery during a request (text, number of parameters, time taken and rows)
+  Statements with the same text that are run many times in one request are flagged, as they are usually a query inside
+  a loop (N+1 queries) that could be replaced by a single query
+  The summary is appended to a log file and/or sent in an X-Query-Profile header (by Response)
+
+  Turned on by the "queryProfiler" section of the config file, it does nothing otherwise
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef QUERYPROFILER_H
+#define QUERYPROFILER_H
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../ext/nlohmann/json.hpp"
+
+class QueryProfiler {
+public:
+
+    /*!
+     * \brief Starts profiling a new request, and discards everything recorded for the previous one.
+     *
+     * Called by JlweCore when it is constructed.
+     *
+     * \param config The website config, the settings are in the "queryProfiler" object
+     */
+    static void beginRequest(const nlohmann::json &config);
+
+    /*!
+     * \brief Writes the summary of the current request to the log file (if one is set) and stops profiling.
+     *
+     * Called by JlweCore when it is destroyed.
+     */
+    static void endRequest();
+
+    /*!
+     * \brief Returns true if statements should be recorded for the current request.
+     *
+     * \return True if profiling is turned on
+     */
+    static inline bool isEnabled() {
+        return enabled;
+    }
+
+    /*!
+     * \brief Records a statement that has been run.
+     *
+     * \param sql The SQL text of the statement
+     * \param bindCount The number of parameters that were set
+     * \param milliseconds How long the statement took
+     * \param rows The number of rows returned (or affected, for an update)
+     */
+    static void record(const std::string &sql, unsigned int bindCount, double milliseconds, unsigned long long rows);
+
+    /*!
+     * \brief Adds rows read from the result set of a statement that has already been recorded.
+     *
+     * \param sql The SQL text of the statement
+     * \param rows The number of rows read
+     */
+    static void recordRows(const std::string &sql, unsigned long long rows);
+
+    /*!
+     * \brief Gets the value for the X-Query-Profile header.
+     *
+     * eg. "queries=143; time=52.31ms; repeated=2; worst=40x SELECT ..."
+     *
+     * \return The header value, or an empty string if the header is turned off
+     */
+    static std::string getHeaderValue();
+
+    /*!
+     * \brief Gets the summary of the current request, one line per distinct statement, most time first.
+     *
+     * \return The summary text
+     */
+    static std::string getSummary();
+
+private:
+    struct StatementStats {
+        unsigned int count;
+        unsigned int bindCount;
+        double totalMilliseconds;
+        double maxMilliseconds;
+        unsigned long long rows;
+    };
+
+    static bool enabled;
+    static bool debugHeader;
+    static unsigned int repeatThreshold;
+    static std::string logFile;
+
+    static std::unordered_map<std::string, StatementStats> statements;
+    static unsigned int queryCount;
+    static double totalMilliseconds;
+    static std::chrono::system_clock::time_point requestStart;
+
+    // The statements sorted by total time, most first
+    static std::vector<std::pair<const std::string *, const StatementStats *>> sortedStatements();
+    static unsigned int repeatedStatementCount();
+};
+
+#endif // QUERYPROFILER_H
@@ -0,0 +1,79 @@
+/**
+  @file    RegistrationData.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Interface for loading the order and payment data that PaymentUtils needs to work out what a user owes
+  MysqlRegistrationData reads it from the database, MemoryRegistrationData holds it in memory (for benchmarks)
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef REGISTRATIONDATA_H
+#define REGISTRATIONDATA_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "PaymentUtils.h"
+#include "../registration/DinnerUtils.h"
+
+class RegistrationData {
+public:
+
+    /*!
+     * \brief Everything a single user has ordered, across all the order tables
+     */
+    struct UserOrder {
+        // event registration (event_registrations table)
+        bool has_event = false;
+        int number_adults = 0;
+        int number_children = 0;
+
+        // camping (camping table)
+        bool has_camping = false;
+        std::string camping_price_code;
+        int camping_people = 0;
+        int camping_nights = 0;
+
+        // dinner orders (sat_dinner table), as pairs of dinner form id and order JSON
+        std::vector<std::pair<int, std::string>> dinner_orders;
+
+        // total cost of merch items ordered (in cents)
+        int merch_cost = 0;
+
+        // total Stripe card fees (in cents)
+        int card_fees = 0;
+    };
+
+    virtual ~RegistrationData() {}
+
+    /*!
+     * \brief Gets a list of all payments received from a given user (cash, bank and card)
+     *
+     * \param userKey The key of the user to get payment info for
+     * \return The list of payments
+     */
+    virtual std::vector<PaymentUtils::paymentEntry> getUserPayments(const std::string &userKey) = 0;
+
+    /*!
+     * \brief Gets everything a given user has ordered
+     *
+     * \param userKey The key of the user to get the order for
+     * \return The order details
+     */
+    virtual UserOrder getUserOrder(const std::string &userKey) = 0;
+
+    /*!
+     * \brief Gets the menu items for a given dinner form
+     *
+     * \param dinner_form_id The ID number of the dinner form
+     * \return A list of menu items
+     */
+    virtual std::vector<DinnerUtils::dinner_menu_item> getDinnerMenuItems(int dinner_form_id) = 0;
+
+};
+
+#endif // REGISTRATIONDATA_H
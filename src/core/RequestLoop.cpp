@@ -0,0 +1,159 @@
+/**
+  @file    RequestLoop.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Runs the request handler of a CGI script
+  In a normal CGI build the handler is called once and the process exits
+  When built with FastCGI support (HAVE_FASTCGI) and started by a FastCGI process manager,
+  the handler is called once for every request received, so the process (and the
+  config, MySQL connection and caches held by JlweCore) stays alive between requests
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "RequestLoop.h"
+
+#include <cstdio>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef HAVE_FASTCGI
+#include <fcgiapp.h>
+#include <fcgio.h>
+
+#include "CgiEnvironment.h"
+
+// The request being handled, so finishResponse() can end it early
+static FCGX_Request *current_request = nullptr;
+
+// Passes the output on to another stream buffer, and notes if anything has been written
+// so a handler that fails can still be given an error status if it hadn't started its response
+class WatchedStreambuf : public std::streambuf {
+public:
+    WatchedStreambuf(std::streambuf *target) {
+        this->target = target;
+        this->written = false;
+    }
+    bool hasWritten() const {
+        return this->written;
+    }
+protected:
+    int overflow(int c) override {
+        if (c == EOF)
+            return this->target->pubsync() == 0 ? 0 : EOF;
+        this->written = true;
+        return this->target->sputc(static_cast<char>(c));
+    }
+    std::streamsize xsputn(const char *s, std::streamsize n) override {
+        if (n > 0)
+            this->written = true;
+        return this->target->sputn(s, n);
+    }
+    int sync() override {
+        return this->target->pubsync();
+    }
+private:
+    std::streambuf *target;
+    bool written;
+};
+#endif
+
+bool RequestLoop::m_persistent = false;
+
+int RequestLoop::run(RequestHandler handler) {
+#ifdef HAVE_FASTCGI
+    // If stdin isn't a FastCGI socket then we were started as a normal CGI script
+    if (!FCGX_IsCGI()) {
+        m_persistent = true;
+
+        FCGX_Init();
+        FCGX_Request request;
+        FCGX_InitRequest(&request, 0, 0);
+
+        std::streambuf *cin_original = std::cin.rdbuf();
+        std::streambuf *cout_original = std::cout.rdbuf();
+        std::streambuf *cerr_original = std::cerr.rdbuf();
+
+        while (FCGX_Accept_r(&request) == 0) {
+            fcgi_streambuf cin_fcgi(request.in);
+            fcgi_streambuf cout_fcgi(request.out);
+            fcgi_streambuf cerr_fcgi(request.err);
+            WatchedStreambuf cout_watched(&cout_fcgi);
+            std::cin.rdbuf(&cin_fcgi);
+            std::cout.rdbuf(&cout_watched);
+            std::cerr.rdbuf(&cerr_fcgi);
+            std::cin.clear();
+            std::cout.clear();
+
+            CgiEnvironment::setEnvironment(request.envp);
+            current_request = &request;
+
+            // The handlers catch their own errors, this is just so one bad request can't kill the worker
+            // The error goes to the FastCGI error stream, which the web server writes to its error log
+            bool failed = false;
+            try {
+                handler();
+            } catch (const std::exception &e) {
+                std::cerr << "Uncaught exception in request handler: " << e.what() << "\n";
+                failed = true;
+            } catch (...) {
+                std::cerr << "Uncaught exception in request handler: unknown exception\n";
+                failed = true;
+            }
+
+            // Don't finish the request as if it worked when nothing has been sent (unless finishResponse() already ended it)
+            if (failed && current_request && !cout_watched.hasWritten())
+                std::cout << "Status: 500 Internal Server Error\r\nContent-Type: text/plain\r\n\r\nInternal Server Error\n";
+
+            std::cout.flush();
+            std::cerr.flush();
+
+            current_request = nullptr;
+            CgiEnvironment::setEnvironment(nullptr);
+            std::cin.rdbuf(cin_original);
+            std::cout.rdbuf(cout_original);
+            std::cerr.rdbuf(cerr_original);
+
+            FCGX_Finish_r(&request);
+        }
+        return 0;
+    }
+#endif
+
+    return handler();
+}
+
+bool RequestLoop::isPersistent() {
+    return m_persistent;
+}
+
+void RequestLoop::finishResponse() {
+    std::cout.flush();
+    std::cerr.flush();
+
+#ifdef HAVE_FASTCGI
+    if (m_persistent) {
+        if (current_request) {
+            // The streams are freed when the request is finished, so nothing can be written to them after this
+            // (finishing the request again before the next one is accepted does nothing)
+            std::cin.rdbuf(nullptr);
+            std::cout.rdbuf(nullptr);
+            std::cerr.rdbuf(nullptr);
+            FCGX_Finish_r(current_request);
+            current_request = nullptr;
+        }
+        return;
+    }
+#endif
+
+    // The web server sends the response once stdout is closed, /dev/null takes its place so later writes don't fail
+    fflush(stdout);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+}
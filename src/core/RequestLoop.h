@@ -0,0 +1,58 @@
+/**
+  @file    RequestLoop.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Runs the request handler of a CGI script
+  In a normal CGI build the handler is called once and the process exits
+  When built with FastCGI support (HAVE_FASTCGI) and started by a FastCGI process manager,
+  the handler is called once for every request received, so the process (and the
+  config, MySQL connection and caches held by JlweCore) stays alive between requests
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef REQUESTLOOP_H
+#define REQUESTLOOP_H
+
+class RequestLoop {
+public:
+
+    /*!
+     * \brief A function that handles a single HTTP request
+     *
+     * It reads the request from CgiEnvironment and std::cin and writes the response to std::cout
+     */
+    typedef int (*RequestHandler)();
+
+    /*!
+     * \brief Runs the request handler for each request this process receives.
+     *
+     * Call this from main().
+     *
+     * \param handler The function that handles a single request
+     * \return The exit code for the process
+     */
+    static int run(RequestHandler handler);
+
+    /*!
+     * \brief Returns true if this process is a persistent worker that handles more than one request.
+     *
+     * \return True if running as a FastCGI worker, false if running as a normal CGI script
+     */
+    static bool isPersistent();
+
+    /*!
+     * \brief Sends the response to the client now, so the handler can keep working without making them wait.
+     *
+     * Anything written to std::cout after this is discarded.
+     */
+    static void finishResponse();
+
+private:
+    static bool m_persistent;
+
+};
+
+#endif // REQUESTLOOP_H
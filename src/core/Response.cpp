@@ -0,0 +1,295 @@
+/**
+  @file    Response.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Buffers a complete HTTP response so it can be sent with a Content-Length, compressed and written in one go
+  gzip compression uses zlib, brotli is only available if the build found libbrotlienc (HAVE_BROTLI)
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "Response.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#include "CgiEnvironment.h"
+#include "JlweUtils.h"
+#include "QueryProfiler.h"
+#include "RequestLoop.h"
+
+// Bodies smaller than this aren't worth compressing
+#define MIN_COMPRESS_SIZE 1024
+
+// Brotli quality level (0-11), 5 is a good trade off between speed and size for dynamic pages
+#define BROTLI_QUALITY 5
+
+Response::Response() : bodyBuffer(&this->body) {
+    this->flushed = false;
+    this->phaseStart = std::chrono::steady_clock::now();
+    this->previousBuffer = std::cout.rdbuf(&this->bodyBuffer);
+}
+
+Response::~Response() {
+    this->discard();
+}
+
+Response::StringBuffer::int_type Response::StringBuffer::overflow(int_type c) {
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+        this->buffer->push_back(traits_type::to_char_type(c));
+    return traits_type::not_eof(c);
+}
+
+std::streamsize Response::StringBuffer::xsputn(const char *s, std::streamsize n) {
+    this->buffer->append(s, static_cast<size_t>(n));
+    return n;
+}
+
+void Response::setStatus(int code, const std::string &reason) {
+    this->status = std::to_string(code) + " " + reason;
+}
+
+void Response::setContentType(const std::string &contentType) {
+    this->contentType = contentType;
+}
+
+void Response::setHeader(const std::string &name, const std::string &value) {
+    this->headers.push_back({name, value});
+}
+
+void Response::startPhase(const std::string &name) {
+    this->endPhase();
+    this->currentPhase = name;
+}
+
+void Response::endPhase() {
+    auto now = std::chrono::steady_clock::now();
+    if (this->currentPhase.size()) {
+        double ms = std::chrono::duration<double, std::milli>(now - this->phaseStart).count();
+        bool found = false;
+        for (auto &phase : this->phases) {
+            if (phase.first == this->currentPhase) {
+                phase.second += ms;
+                found = true;
+            }
+        }
+        if (!found)
+            this->phases.push_back({this->currentPhase, ms});
+    }
+    this->currentPhase = "";
+    this->phaseStart = now;
+}
+
+bool Response::gzipCompress(const std::string &input, std::string *output, int level) {
+    z_stream stream = {};
+    // windowBits of 15 + 16 makes zlib write a gzip header instead of a zlib one
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    output->resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&(*output)[0]);
+    stream.avail_out = static_cast<uInt>(output->size());
+
+    int result = deflate(&stream, Z_FINISH);
+    output->resize(stream.total_out);
+    deflateEnd(&stream);
+    return (result == Z_STREAM_END);
+}
+
+bool Response::brotliCompress(const std::string &input, std::string *output, int quality) {
+#ifdef HAVE_BROTLI
+    size_t size = BrotliEncoderMaxCompressedSize(input.size());
+    if (size == 0)
+        return false;
+
+    output->resize(size);
+    if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, input.size(),
+                               reinterpret_cast<const uint8_t *>(input.data()), &size, reinterpret_cast<uint8_t *>(&(*output)[0])))
+        return false;
+    output->resize(size);
+    return true;
+#else
+    (void)input;
+    (void)output;
+    (void)quality;
+    return false;
+#endif
+}
+
+void Response::discard() {
+    if (this->flushed)
+        return;
+    std::cout.rdbuf(this->previousBuffer);
+    this->flushed = true;
+    this->body.clear();
+}
+
+void Response::flush() {
+    if (this->flushed)
+        return;
+    this->endPhase();
+    std::cout.rdbuf(this->previousBuffer);
+    this->flushed = true;
+
+    std::string encoding;
+    std::string encodedBody;
+    bool compressible = isCompressible(this->contentType);
+    if (compressible && this->body.size() >= MIN_COMPRESS_SIZE) {
+        this->startPhase("compress");
+        encoding = negotiateEncoding(CgiEnvironment::getenvAsString("HTTP_ACCEPT_ENCODING"));
+        bool ok = false;
+        if (encoding == "gzip") {
+            ok = gzipCompress(this->body, &encodedBody, Z_DEFAULT_COMPRESSION);
+#ifdef HAVE_BROTLI
+        } else if (encoding == "br") {
+            ok = brotliCompress(this->body, &encodedBody, BROTLI_QUALITY);
+#endif
+        }
+        if (!ok || encodedBody.size() >= this->body.size())
+            encoding = "";
+        this->endPhase();
+    }
+    const std::string &output = encoding.size() ? encodedBody : this->body;
+
+    std::string headerText;
+    if (this->status.size())
+        headerText += "Status: " + this->status + "\r\n";
+    if (this->contentType.size())
+        headerText += "Content-Type: " + this->contentType + "\r\n";
+    for (const auto &header : this->headers)
+        headerText += header.first + ": " + header.second + "\r\n";
+    if (compressible)
+        headerText += "Vary: Accept-Encoding\r\n";
+    if (encoding.size())
+        headerText += "Content-Encoding: " + encoding + "\r\n";
+    headerText += "Content-Length: " + std::to_string(output.size()) + "\r\n";
+
+    if (this->phases.size()) {
+        headerText += "Server-Timing: ";
+        for (size_t i = 0; i < this->phases.size(); i++) {
+            char duration[32];
+            snprintf(duration, sizeof(duration), "%.2f", this->phases.at(i).second);
+            headerText += (i ? ", " : "") + this->phases.at(i).first + ";dur=" + duration;
+        }
+        headerText += "\r\n";
+    }
+    std::string queryProfile = QueryProfiler::getHeaderValue();
+    if (queryProfile.size())
+        headerText += "X-Query-Profile: " + queryProfile + "\r\n";
+    headerText += "\r\n";
+
+    this->write(headerText, output);
+}
+
+void Response::write(const std::string &headerText, const std::string &output) {
+    // In a FastCGI worker std::cout is connected to the FastCGI request, not stdout
+    if (RequestLoop::isPersistent()) {
+        std::cout.write(headerText.data(), static_cast<std::streamsize>(headerText.size()));
+        std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+        std::cout.flush();
+        return;
+    }
+
+    // Anything already written to std::cout has to go out first
+    std::cout.flush();
+    fflush(stdout);
+
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<char *>(headerText.data());
+    iov[0].iov_len = headerText.size();
+    iov[1].iov_base = const_cast<char *>(output.data());
+    iov[1].iov_len = output.size();
+
+    struct iovec *next = iov;
+    int count = 2;
+    while (count > 0) {
+        ssize_t written = writev(STDOUT_FILENO, next, count);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        // Skip over whatever was written, in case it was only a partial write
+        size_t remaining = static_cast<size_t>(written);
+        while (count > 0 && remaining >= next->iov_len) {
+            remaining -= next->iov_len;
+            next++;
+            count--;
+        }
+        if (count > 0) {
+            next->iov_base = static_cast<char *>(next->iov_base) + remaining;
+            next->iov_len -= remaining;
+        }
+    }
+}
+
+bool Response::isCompressible(const std::string &contentType) {
+    return (contentType.compare(0, 5, "text/") == 0 ||
+            contentType.find("json") != std::string::npos ||
+            contentType.find("xml") != std::string::npos ||
+            contentType.find("javascript") != std::string::npos);
+}
+
+std::string Response::negotiateEncoding(const std::string &acceptEncoding) {
+    // q-values of each encoding, -1 means it wasn't listed
+    double gzipQ = -1;
+    double brQ = -1;
+    double anyQ = -1;
+
+    size_t start = 0;
+    while (start <= acceptEncoding.size()) {
+        size_t end = acceptEncoding.find(',', start);
+        if (end == std::string::npos)
+            end = acceptEncoding.size();
+        std::string item = acceptEncoding.substr(start, end - start);
+        start = end + 1;
+
+        double q = 1;
+        size_t semicolon = item.find(';');
+        if (semicolon != std::string::npos) {
+            size_t qPos = item.find("q=", semicolon);
+            if (qPos != std::string::npos) {
+                try {
+                    q = std::stod(item.substr(qPos + 2));
+                } catch (...) {
+                    q = 0;
+                }
+            }
+            item = item.substr(0, semicolon);
+        }
+        JlweUtils::trimString(item);
+
+        if (JlweUtils::compareStringsNoCase(item, "gzip") || JlweUtils::compareStringsNoCase(item, "x-gzip")) {
+            gzipQ = q;
+        } else if (JlweUtils::compareStringsNoCase(item, "br")) {
+            brQ = q;
+        } else if (item == "*") {
+            anyQ = q;
+        }
+    }
+
+    if (gzipQ < 0)
+        gzipQ = (anyQ < 0) ? 0 : anyQ;
+    if (brQ < 0)
+        brQ = (anyQ < 0) ? 0 : anyQ;
+
+#ifdef HAVE_BROTLI
+    if (brQ > 0 && brQ >= gzipQ)
+        return "br";
+#endif
+    if (gzipQ > 0)
+        return "gzip";
+    return "";
+}
@@ -0,0 +1,145 @@
+/**
+  @file    Response.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Buffers a complete HTTP response so it can be sent with a Content-Length, compressed and written in one go
+  While a Response object exists everything written to std::cout is captured into its buffer
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef RESPONSE_H
+#define RESPONSE_H
+
+#include <chrono>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Response {
+public:
+
+    /*!
+     * \brief Constructor for Response. Starts capturing std::cout and starts the timer for the Server-Timing header.
+     */
+    Response();
+
+    /*!
+     * \brief Destructor for Response. Stops capturing std::cout.
+     *
+     * If flush() hasn't been called the buffered output is discarded, so if a handler throws
+     * part way through a page the catch block can write a clean error message instead.
+     */
+    ~Response();
+
+    /*!
+     * \brief Sets the HTTP status of the response. If this isn't called the server uses 200 OK.
+     *
+     * \param code The HTTP status code, eg. 404
+     * \param reason The reason phrase, eg. "Not Found"
+     */
+    void setStatus(int code, const std::string &reason);
+
+    /*!
+     * \brief Sets the Content-Type header.
+     *
+     * \param contentType The MIME type of the body, eg. "text/html"
+     */
+    void setContentType(const std::string &contentType);
+
+    /*!
+     * \brief Adds a HTTP header to the response.
+     *
+     * \param name The header name, eg. "Content-Disposition"
+     * \param value The header value
+     */
+    void setHeader(const std::string &name, const std::string &value);
+
+    /*!
+     * \brief Starts timing a new phase for the Server-Timing header, and ends the previous one.
+     *
+     * Phases with the same name are added together, so a handler can switch between eg. "db" and "render" as often as needed.
+     *
+     * \param name The name of the phase, eg. "config", "db" or "render"
+     */
+    void startPhase(const std::string &name);
+
+    /*!
+     * \brief Sends the response.
+     *
+     * Stops capturing std::cout, compresses the body if the browser supports it, then writes
+     * the headers (including Content-Length and Server-Timing) and body in a single write.
+     */
+    void flush();
+
+    /*!
+     * \brief Stops capturing std::cout and throws away everything buffered so far.
+     *
+     * Used when a handler decides to write a different response directly to std::cout (eg. an error page).
+     */
+    void discard();
+
+    /*!
+     * \brief Picks the content encoding to use from an Accept-Encoding header.
+     *
+     * \param acceptEncoding The value of the Accept-Encoding header
+     * \return "br", "gzip" or an empty string if the response shouldn't be compressed
+     */
+    static std::string negotiateEncoding(const std::string &acceptEncoding);
+
+    /*!
+     * \brief Compresses data with gzip.
+     *
+     * \param input The data to compress
+     * \param output Set to the compressed data
+     * \param level The zlib compression level (1-9)
+     * \return true if successful, false if zlib failed
+     */
+    static bool gzipCompress(const std::string &input, std::string *output, int level);
+
+    /*!
+     * \brief Compresses data with brotli.
+     *
+     * \param input The data to compress
+     * \param output Set to the compressed data
+     * \param quality The brotli quality level (0-11)
+     * \return true if successful, false if it failed or brotli isn't available in this build
+     */
+    static bool brotliCompress(const std::string &input, std::string *output, int quality);
+
+private:
+
+    // A streambuf that appends everything written to it onto a string
+    class StringBuffer : public std::streambuf {
+    public:
+        StringBuffer(std::string *buffer) : buffer(buffer) {}
+    protected:
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(const char *s, std::streamsize n) override;
+    private:
+        std::string *buffer;
+    };
+
+    static bool isCompressible(const std::string &contentType);
+    void endPhase();
+    void write(const std::string &headerText, const std::string &output);
+
+    std::string body;
+    StringBuffer bodyBuffer;
+    std::streambuf *previousBuffer;
+    bool flushed;
+
+    std::string status;
+    std::string contentType;
+    std::vector<std::pair<std::string, std::string>> headers;
+
+    std::vector<std::pair<std::string, double>> phases; // name, milliseconds
+    std::string currentPhase;
+    std::chrono::steady_clock::time_point phaseStart;
+
+};
+
+#endif // RESPONSE_H
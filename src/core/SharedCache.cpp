@@ -0,0 +1,265 @@
+/**
+  @file    SharedCache.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  A cache of small read-mostly data that is shared by every process on the server, using a memory mapped file
+  Readers use the sequence number in each slot to detect a write happening at the same time, and retry if there was one
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "SharedCache.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "JLWECACH", so a file with any other contents is reset
+#define SHARED_CACHE_MAGIC  0x4843414345574C4AULL
+// Increase this if the file layout changes
+#define SHARED_CACHE_LAYOUT  1
+
+#define SHARED_CACHE_SLOTS  32
+#define SHARED_CACHE_SLOT_SIZE  (128 * 1024)
+#define SHARED_CACHE_NAME_SIZE  64
+// The slots start after the first page
+#define SHARED_CACHE_HEADER_SIZE  4096
+#define SHARED_CACHE_FILE_SIZE  (SHARED_CACHE_HEADER_SIZE + SHARED_CACHE_SLOTS * SHARED_CACHE_SLOT_SIZE)
+
+// Number of times a read is tried when a write happens at the same time
+#define SHARED_CACHE_READ_RETRIES  8
+
+struct FileHeader {
+    uint64_t magic;
+    uint32_t layout;
+    uint32_t slotCount;
+    uint32_t slotSize;
+};
+
+// The data follows the header in each slot
+struct SlotHeader {
+    // Odd while the slot is being written
+    std::atomic<uint64_t> sequence;
+    // Empty if the slot has never been used
+    char name[SHARED_CACHE_NAME_SIZE];
+    uint64_t dataVersion;
+    // 0 if the entry has been invalidated
+    int64_t storedAt;
+    uint32_t length;
+};
+
+#define SHARED_CACHE_MAX_DATA  (SHARED_CACHE_SLOT_SIZE - sizeof(SlotHeader))
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "SharedCache needs lock free 64 bit atomics to work between processes");
+
+// Holds an exclusive lock on the cache file until it goes out of scope
+class CacheFileLock {
+public:
+    CacheFileLock(int fd) {
+        this->fd = fd;
+        flock(this->fd, LOCK_EX);
+    }
+    ~CacheFileLock() {
+        flock(this->fd, LOCK_UN);
+    }
+private:
+    int fd;
+};
+
+unsigned char * SharedCache::mapping = nullptr;
+int SharedCache::fd = -1;
+int SharedCache::maxAgeSeconds = 30;
+bool SharedCache::configured = false;
+
+static inline SlotHeader * getSlot(unsigned char *mapping, unsigned int slot) {
+    return reinterpret_cast<SlotHeader *>(mapping + SHARED_CACHE_HEADER_SIZE + static_cast<size_t>(slot) * SHARED_CACHE_SLOT_SIZE);
+}
+
+// The data of a slot, straight after its header
+static inline unsigned char * slotData(SlotHeader *slot) {
+    return reinterpret_cast<unsigned char *>(slot) + sizeof(SlotHeader);
+}
+
+void SharedCache::configure(const nlohmann::json &config) {
+    if (configured)
+        return;
+    configured = true;
+
+    auto it = config.find("sharedCache");
+    if (it == config.end() || !it->is_object() || !it->value("enabled", false))
+        return;
+    maxAgeSeconds = it->value("maxAgeSeconds", 30);
+
+    // One file for each database, in case there is more than one website on the server
+    std::string filename = it->value("path", "/dev/shm/jlwe_cache");
+    auto mysqlConfig = config.find("mysql");
+    if (mysqlConfig != config.end() && mysqlConfig->is_object())
+        filename += "_" + mysqlConfig->value("database", "");
+
+    fd = open(filename.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0)
+        return;
+
+    // A new file needs to be sized before it can be mapped
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0 || file_info.st_size < SHARED_CACHE_FILE_SIZE) {
+        CacheFileLock lock(fd);
+        if (fstat(fd, &file_info) != 0 || (file_info.st_size < SHARED_CACHE_FILE_SIZE && ftruncate(fd, SHARED_CACHE_FILE_SIZE) != 0)) {
+            close(fd);
+            fd = -1;
+            return;
+        }
+    }
+
+    void *address = mmap(nullptr, SHARED_CACHE_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        close(fd);
+        fd = -1;
+        return;
+    }
+    unsigned char *newMapping = static_cast<unsigned char *>(address);
+
+    // Reset the file if it is new (all zeros) or from a different layout
+    FileHeader *header = reinterpret_cast<FileHeader *>(newMapping);
+    if (header->magic != SHARED_CACHE_MAGIC || header->layout != SHARED_CACHE_LAYOUT) {
+        CacheFileLock lock(fd);
+        if (header->magic != SHARED_CACHE_MAGIC || header->layout != SHARED_CACHE_LAYOUT) {
+            for (unsigned int i = 0; i < SHARED_CACHE_SLOTS; i++) {
+                SlotHeader *slot = getSlot(newMapping, i);
+                slot->sequence.store(0, std::memory_order_relaxed);
+                memset(slot->name, 0, sizeof(slot->name));
+                slot->dataVersion = 0;
+                slot->storedAt = 0;
+                slot->length = 0;
+            }
+            header->layout = SHARED_CACHE_LAYOUT;
+            header->slotCount = SHARED_CACHE_SLOTS;
+            header->slotSize = SHARED_CACHE_SLOT_SIZE;
+            std::atomic_thread_fence(std::memory_order_release);
+            header->magic = SHARED_CACHE_MAGIC;
+        }
+    }
+
+    mapping = newMapping;
+}
+
+unsigned int SharedCache::homeSlot(const std::string &name) {
+    // FNV-1a, this must give the same result in every program that uses the file
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash % SHARED_CACHE_SLOTS;
+}
+
+bool SharedCache::get(const std::string &name, unsigned long long dataVersion, std::string *value) {
+    if (!mapping || name.size() >= SHARED_CACHE_NAME_SIZE)
+        return false;
+
+    long long now = static_cast<long long>(time(nullptr));
+    unsigned int home = homeSlot(name);
+    for (unsigned int i = 0; i < SHARED_CACHE_SLOTS; i++) {
+        SlotHeader *slot = getSlot(mapping, (home + i) % SHARED_CACHE_SLOTS);
+        bool otherName = false;
+
+        for (int attempt = 0; attempt < SHARED_CACHE_READ_RETRIES; attempt++) {
+            uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence & 1)
+                continue;
+
+            // Copy everything out of the slot, then check nothing was written while copying
+            char slotName[SHARED_CACHE_NAME_SIZE];
+            memcpy(slotName, slot->name, sizeof(slotName));
+            uint64_t slotVersion = slot->dataVersion;
+            int64_t storedAt = slot->storedAt;
+            uint32_t length = slot->length;
+            if (length > SHARED_CACHE_MAX_DATA)
+                length = 0;
+            bool match = (strncmp(slotName, name.c_str(), sizeof(slotName)) == 0);
+            if (match)
+                value->assign(reinterpret_cast<const char *>(slotData(slot)), length);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->sequence.load(std::memory_order_relaxed) != sequence)
+                continue;
+
+            // Names are never removed from a slot, so an empty slot is the end of the search
+            if (slotName[0] == '\0')
+                return false;
+            if (!match) {
+                otherName = true;
+                break;
+            }
+            if (storedAt == 0 || now - storedAt >= maxAgeSeconds || now < storedAt)
+                return false;
+            return (dataVersion == 0 || slotVersion == dataVersion);
+        }
+
+        // Still being written after all the retries, read from the database this time
+        if (!otherName)
+            return false;
+    }
+    return false;
+}
+
+void SharedCache::writeSlot(const std::string &name, unsigned long long dataVersion, const std::string *value) {
+    // Use the slot that already has this name, or the first empty one.
+    // If the cache is full, the entry in the home slot is replaced
+    unsigned int home = homeSlot(name);
+    SlotHeader *slot = nullptr;
+    for (unsigned int i = 0; i < SHARED_CACHE_SLOTS && !slot; i++) {
+        SlotHeader *s = getSlot(mapping, (home + i) % SHARED_CACHE_SLOTS);
+        if (s->name[0] == '\0' || strncmp(s->name, name.c_str(), sizeof(s->name)) == 0)
+            slot = s;
+    }
+    if (!slot) {
+        if (!value)
+            return;
+        slot = getSlot(mapping, home);
+    }
+
+    // Make the sequence odd while writing, this still works if a previous writer stopped part way through
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed) | 1;
+    slot->sequence.store(sequence, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memset(slot->name, 0, sizeof(slot->name));
+    memcpy(slot->name, name.c_str(), name.size());
+    slot->dataVersion = dataVersion;
+    if (value) {
+        memcpy(slotData(slot), value->data(), value->size());
+        slot->length = static_cast<uint32_t>(value->size());
+        slot->storedAt = static_cast<int64_t>(time(nullptr));
+    } else {
+        slot->length = 0;
+        slot->storedAt = 0;
+    }
+
+    slot->sequence.store(sequence + 1, std::memory_order_release);
+}
+
+void SharedCache::put(const std::string &name, unsigned long long dataVersion, const std::string &value) {
+    if (!mapping || !name.size() || name.size() >= SHARED_CACHE_NAME_SIZE)
+        return;
+
+    // Too big to cache, but any older value still needs removing
+    CacheFileLock lock(fd);
+    writeSlot(name, dataVersion, value.size() <= SHARED_CACHE_MAX_DATA ? &value : nullptr);
+}
+
+void SharedCache::invalidate(const std::string &name) {
+    if (!mapping || !name.size() || name.size() >= SHARED_CACHE_NAME_SIZE)
+        return;
+
+    CacheFileLock lock(fd);
+    writeSlot(name, 0, nullptr);
+}
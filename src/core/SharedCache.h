@@ -0,0 +1,92 @@
+/**
+  @file    SharedCache.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  A cache of small read-mostly data (vars, the menu, camping options, etc.) that is shared by every process on the server
+  The data is kept in a memory mapped file (usually in /dev/shm) divided into fixed size slots, one slot per name
+  Each slot is protected by a sequence number (seqlock), so reading never takes a lock, only writers lock the file
+
+  An entry is used until it is older than maxAgeSeconds or is invalidated by the code that changes the data
+  Persistent workers also pass the version from the data_versions table, so changes made in SQL are seen immediately
+
+  Turned on by the "sharedCache" section of the config file, it does nothing otherwise
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef SHAREDCACHE_H
+#define SHAREDCACHE_H
+
+#include <string>
+
+#include "../ext/nlohmann/json.hpp"
+
+class SharedCache {
+public:
+
+    /*!
+     * \brief Opens (or creates) the cache file if the cache is turned on in the config file.
+     *
+     * Called by JlweCore when it is constructed, the file is only opened once per process.
+     *
+     * \param config The website config, the settings are in the "sharedCache" object
+     */
+    static void configure(const nlohmann::json &config);
+
+    /*!
+     * \brief Returns true if the cache file is open and can be used.
+     *
+     * \return True if the cache is turned on
+     */
+    static inline bool isEnabled() {
+        return mapping != nullptr;
+    }
+
+    /*!
+     * \brief Gets an entry from the cache.
+     *
+     * \param name The name of the entry
+     * \param dataVersion The version of the data from the data_versions table, or 0 if it isn't known
+     * \param value Set to the cached value if it is found
+     * \return True if a current entry was found
+     */
+    static bool get(const std::string &name, unsigned long long dataVersion, std::string *value);
+
+    /*!
+     * \brief Adds or replaces an entry in the cache.
+     *
+     * Values that don't fit in a slot are not cached.
+     *
+     * \param name The name of the entry
+     * \param dataVersion The version of the data from the data_versions table, or 0 if it isn't known
+     * \param value The value to cache
+     */
+    static void put(const std::string &name, unsigned long long dataVersion, const std::string &value);
+
+    /*!
+     * \brief Removes an entry from the cache, so the next process to need it reads it from the database.
+     *
+     * Should be called after anything that changes the cached data.
+     *
+     * \param name The name of the entry
+     */
+    static void invalidate(const std::string &name);
+
+private:
+
+    // Start of the memory mapped file, nullptr if the cache isn't being used
+    static unsigned char *mapping;
+    static int fd;
+    static int maxAgeSeconds;
+    static bool configured;
+
+    // Gets the slot number that the search for a name starts at
+    static unsigned int homeSlot(const std::string &name);
+
+    // Writes to the slot for a name (value is nullptr to clear it), the file must be locked
+    static void writeSlot(const std::string &name, unsigned long long dataVersion, const std::string *value);
+};
+
+#endif // SHAREDCACHE_H
@@ -0,0 +1,255 @@
+/**
+  @file    StaticPages.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Writes pre-rendered copies of the public pages from the webpages table into the static_pages directory of the
+  document root, so Apache can send them to visitors who aren't logged in without running jlwe.cgi
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "StaticPages.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <set>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CgiEnvironment.h"
+#include "HtmlTemplate.h"
+#include "JlweUtils.h"
+#include "MysqlQuery.h"
+#include "RequestLoop.h"
+#include "Response.h"
+#include "SharedCache.h"
+
+#include "../ext/nlohmann/json.hpp"
+
+// Directory in the document root that the pages are written to, this must match the rewrite rules in .htaccess
+#define STATIC_PAGES_DIR "/static_pages"
+
+// Records what the pages were rendered from, so jlwe.cgi can tell when they are out of date
+#define MANIFEST_FILE "/manifest.json"
+
+// The files are only compressed once, so use the best compression
+#define STATIC_GZIP_LEVEL 9
+#define STATIC_BROTLI_QUALITY 11
+
+// Holds the publish lock until it goes out of scope
+// If wait is false and another process has the lock, isLocked() returns false instead of waiting for it
+class PublishLock {
+public:
+    PublishLock(const std::string &filename, bool wait) {
+        this->fd = open(filename.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+        if (this->fd < 0)
+            throw std::runtime_error("Unable to open " + filename + ": " + strerror(errno));
+        this->locked = (flock(this->fd, wait ? LOCK_EX : (LOCK_EX | LOCK_NB)) == 0);
+    }
+    ~PublishLock() {
+        if (this->locked)
+            flock(this->fd, LOCK_UN);
+        close(this->fd);
+    }
+    bool isLocked() const {
+        return this->locked;
+    }
+private:
+    int fd;
+    bool locked;
+};
+
+bool StaticPages::isEnabled(JlweCore *jlwe) {
+    auto it = jlwe->config.find("staticPages");
+    if (it == jlwe->config.end() || !it->is_object())
+        return false;
+    return it->value("enabled", false);
+}
+
+std::string StaticPages::getDirectory() {
+    return CgiEnvironment::getDocumentRoot() + STATIC_PAGES_DIR;
+}
+
+std::string StaticPages::pageFileName(const std::string &path) {
+    if (path.size() < 2 || path.at(0) != '/')
+        return "";
+    std::string name = path.substr(1);
+
+    // Only top level .html/.htm pages go through jlwe.cgi
+    if (name.find_first_of("/\\") != std::string::npos || name.find("..") != std::string::npos || name.at(0) == '.')
+        return "";
+    size_t extension = name.rfind('.');
+    if (extension == std::string::npos || !(name.substr(extension) == ".html" || name.substr(extension) == ".htm"))
+        return "";
+
+    // Year pages (eg. 2019.html) are sent to jlwe_year.cgi before the static page rules
+    if (name.size() == 9 && isdigit(name[0]) && isdigit(name[1]) && isdigit(name[2]) && isdigit(name[3]) && name.substr(4) == ".html")
+        return "";
+
+    return name;
+}
+
+long long StaticPages::modifiedTime(const std::string &filename) {
+    struct stat file_info;
+    if (stat(filename.c_str(), &file_info) != 0)
+        return 0;
+    return static_cast<long long>(file_info.st_mtime);
+}
+
+void StaticPages::writeFile(const std::string &filename, const std::string &data) {
+    std::string tmpFilename = filename + ".tmp" + std::to_string(getpid());
+    FILE *file = fopen(tmpFilename.c_str(), "wb");
+    if (!file)
+        throw std::runtime_error("Unable to write " + tmpFilename + ": " + strerror(errno));
+    bool ok = (fwrite(data.data(), 1, data.size(), file) == data.size());
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+        unlink(tmpFilename.c_str());
+        throw std::runtime_error("Unable to write " + filename);
+    }
+}
+
+unsigned long long StaticPages::menuVersion(JlweCore *jlwe) {
+    // JlweCore::getDataVersion() only reads the versions in persistent workers, this is needed for normal CGI requests too
+    return MysqlQuery(jlwe, "SELECT version FROM data_versions WHERE name = 'webpage_menu';").fetchValue<unsigned long long>(0);
+}
+
+bool StaticPages::readManifest(nlohmann::json *manifest) {
+    // The manifest is replaced by a rename when the pages are published, so a new file always has a new inode
+    static struct {
+        std::string filename;
+        ino_t inode;
+        struct timespec modified;
+        nlohmann::json contents;
+    } cached = {"", 0, {0, 0}, nullptr};
+
+    std::string filename = getDirectory() + MANIFEST_FILE;
+    struct stat file_info;
+    if (stat(filename.c_str(), &file_info) != 0)
+        return false;
+
+    if (cached.filename != filename || cached.inode != file_info.st_ino ||
+            cached.modified.tv_sec != file_info.st_mtim.tv_sec || cached.modified.tv_nsec != file_info.st_mtim.tv_nsec) {
+        try {
+            cached.contents = nlohmann::json::parse(JlweUtils::readFileToString(filename.c_str()));
+        } catch (...) {
+            cached.filename = "";
+            return false;
+        }
+        cached.filename = filename;
+        cached.inode = file_info.st_ino;
+        cached.modified = file_info.st_mtim;
+    }
+
+    *manifest = cached.contents;
+    return true;
+}
+
+bool StaticPages::isStale(JlweCore *jlwe, bool readMenuVersion) {
+    nlohmann::json manifest;
+    if (!readManifest(&manifest))
+        return true;
+
+    // getDataVersion() has the versions loaded at the start of the request (it only has them in persistent workers or with the shared cache)
+    unsigned long long currentMenuVersion;
+    if (!readMenuVersion && (RequestLoop::isPersistent() || SharedCache::isEnabled())) {
+        currentMenuVersion = jlwe->getDataVersion("webpage_menu");
+    } else {
+        currentMenuVersion = menuVersion(jlwe);
+    }
+
+    return manifest.value("menuVersion", 0ull) != currentMenuVersion ||
+           manifest.value("desktopTemplate", 0ll) != modifiedTime(HtmlTemplate::getTemplatePath(false)) ||
+           manifest.value("mobileTemplate", 0ll) != modifiedTime(HtmlTemplate::getTemplatePath(true));
+}
+
+int StaticPages::publish(JlweCore *jlwe, bool onlyIfStale) {
+    if (!isEnabled(jlwe))
+        return 0;
+
+    std::string directory = getDirectory();
+    const std::pair<std::string, bool> variants[] = {{"/desktop", false}, {"/mobile", true}};
+    mkdir(directory.c_str(), 0755);
+    for (const auto &variant : variants)
+        mkdir((directory + variant.first).c_str(), 0755);
+
+    // A stale site is already being brought up to date if another process has the lock
+    PublishLock lock(directory + "/.lock", !onlyIfStale);
+    if (!lock.isLocked() || (onlyIfStale && !isStale(jlwe, true)))
+        return 0;
+
+    // Read the versions before rendering, so a change made while publishing leaves the pages marked as stale
+    nlohmann::json manifest;
+    manifest["menuVersion"] = menuVersion(jlwe);
+    manifest["desktopTemplate"] = modifiedTime(HtmlTemplate::getTemplatePath(false));
+    manifest["mobileTemplate"] = modifiedTime(HtmlTemplate::getTemplatePath(true));
+
+    std::string docRoot = CgiEnvironment::getDocumentRoot();
+    std::set<std::string> keepFiles;
+    int pageCount = 0;
+
+    MysqlQuery query(jlwe, "SELECT path, page_name, html FROM webpages WHERE special_page = 0 AND draft_page = 0 AND login_only = 0;");
+    while (query.next()) {
+        std::string name = pageFileName(query.result()->getString(1));
+        if (!name.size())
+            continue;
+
+        // jlwe.cgi sends a file in the document root instead of the database page, if there is one
+        struct stat file_info;
+        if (stat((docRoot + "/" + name).c_str(), &file_info) == 0 && file_info.st_size > 0)
+            continue;
+
+        std::string title = query.result()->getString(2);
+        std::string html = query.result()->getString(3);
+        for (const auto &variant : variants) {
+            std::string page = HtmlTemplate::renderPage(jlwe, title, false, html, variant.second);
+            if (!page.size())
+                throw std::runtime_error("Unable to read the template file " + HtmlTemplate::getTemplatePath(variant.second));
+
+            std::string filename = directory + variant.first + "/" + name;
+            writeFile(filename, page);
+            keepFiles.insert(filename);
+
+            std::string compressed;
+            if (Response::gzipCompress(page, &compressed, STATIC_GZIP_LEVEL)) {
+                writeFile(filename + ".gz", compressed);
+                keepFiles.insert(filename + ".gz");
+            }
+            if (Response::brotliCompress(page, &compressed, STATIC_BROTLI_QUALITY)) {
+                writeFile(filename + ".br", compressed);
+                keepFiles.insert(filename + ".br");
+            }
+        }
+        pageCount++;
+    }
+
+    // Remove pages that have been deleted, or are now drafts or login only
+    for (const auto &variant : variants) {
+        std::string variantDirectory = directory + variant.first;
+        DIR *dir = opendir(variantDirectory.c_str());
+        if (!dir)
+            continue;
+        struct dirent *ent;
+        while ((ent = readdir(dir)) != nullptr) {
+            std::string filename = variantDirectory + "/" + ent->d_name;
+            if (ent->d_name[0] != '.' && keepFiles.find(filename) == keepFiles.end())
+                unlink(filename.c_str());
+        }
+        closedir(dir);
+    }
+
+    manifest["pages"] = pageCount;
+    manifest["published"] = static_cast<long long>(time(nullptr));
+    writeFile(directory + MANIFEST_FILE, manifest.dump(4));
+
+    return pageCount;
+}
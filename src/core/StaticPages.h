@@ -0,0 +1,87 @@
+/**
+  @file    StaticPages.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Writes pre-rendered copies of the public pages from the webpages table into the static_pages directory of the
+  document root, so Apache can send them to visitors who aren't logged in without running jlwe.cgi
+  Each page is rendered with the desktop and mobile templates, and saved with gzip (.gz) and brotli (.br) copies
+
+  The pages are published when a page is saved in the website editor, and again by jlwe.cgi (after it has sent
+  its page) if the menu or a template has changed since then. Draft and login only pages are never published.
+  Turned on by "staticPages" in the config file, the rewrite rules that serve the files are in html/.htaccess
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef STATICPAGES_H
+#define STATICPAGES_H
+
+#include <string>
+
+#include "JlweCore.h"
+
+class StaticPages {
+public:
+
+    /*!
+     * \brief Returns true if the static pages are turned on in the config file.
+     *
+     * \param jlwe JlweCore object
+     * \return True if pages should be published
+     */
+    static bool isEnabled(JlweCore *jlwe);
+
+    /*!
+     * \brief Gets the directory the pages are written to (static_pages in the document root).
+     *
+     * \return The directory path
+     */
+    static std::string getDirectory();
+
+    /*!
+     * \brief Renders every public page and writes them to the static pages directory.
+     *
+     * Files for pages that no longer exist (or are now drafts or login only) are deleted.
+     * Only one process publishes at a time, others wait for it to finish.
+     * With onlyIfStale set nothing waits, it just returns if another process is publishing.
+     *
+     * \param jlwe JlweCore object
+     * \param onlyIfStale Set to true to do nothing if the pages are already up to date (or being published)
+     * \return The number of pages published
+     */
+    static int publish(JlweCore *jlwe, bool onlyIfStale = false);
+
+    /*!
+     * \brief Checks if the menu or a template has changed since the pages were last published.
+     *
+     * This is run on every jlwe.cgi request, so the manifest is kept in memory until the file changes, and persistent
+     * workers use the menu version JlweCore has already loaded for the request.
+     *
+     * \param jlwe JlweCore object
+     * \param readMenuVersion Set to true to read the menu version from the database, in case it changed during this request
+     * \return True if the pages need publishing again
+     */
+    static bool isStale(JlweCore *jlwe, bool readMenuVersion = false);
+
+private:
+
+    // Gets the file name for a page path, or an empty string if the page can't be served by the rewrite rules
+    static std::string pageFileName(const std::string &path);
+
+    // Writes to a temporary file then renames it, so Apache never sends a half written file
+    static void writeFile(const std::string &filename, const std::string &data);
+
+    // Version of the webpage_menu data, from the data_versions table
+    static unsigned long long menuVersion(JlweCore *jlwe);
+
+    // The contents of the manifest file, only read again if the file has changed
+    // Returns false if there is no manifest
+    static bool readManifest(nlohmann::json *manifest);
+
+    // Modified time of a file, 0 if it doesn't exist
+    static long long modifiedTime(const std::string &filename);
+};
+
+#endif // STATICPAGES_H
@@ -17,10 +17,11 @@
 #include "core/PostDataParser.h"
 #include "core/JlweCore.h"
 #include "core/JsonUtils.h"
+#include "core/RequestLoop.h"
 
 #include "ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -55,3 +56,7 @@ int main () {
     std::cout << JsonUtils::makeJsonSuccess("Report received");
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
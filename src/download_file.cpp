@@ -15,12 +15,14 @@
 #include <string>
 
 #include "core/CgiEnvironment.h"
+#include "core/FileSender.h"
 #include "core/JlweCore.h"
 #include "core/JlweUtils.h"
 #include "core/KeyValueParser.h"
+#include "core/RequestLoop.h"
 #include "public_upload/ImageUtils.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
         std::string page_request = CgiEnvironment::getRequestUri();
@@ -55,6 +57,7 @@ int main () {
 
         bool validFile = false;
         bool validFilename = false;
+        bool isPublicFile = false;
 
         prep_stmt = jlwe.getMysqlCon()->prepareStatement("SELECT filename,public FROM files WHERE CONCAT(directory,filename) = ?;");
         prep_stmt->setString(1, filename);
@@ -62,6 +65,7 @@ int main () {
         if (res->next()) { // if the file exists in MySQL
             if (res->getInt(2) != 0 || jlwe.isLoggedIn()) { // if public file or user is logged in
                 mysql_filename = res->getString(1);
+                isPublicFile = (res->getInt(2) != 0);
 
                 // check if it is a file not a directory
                 if (mysql_filename.at(mysql_filename.size() - 1) != '/') {
@@ -101,40 +105,31 @@ int main () {
             }
         }
 
+        int response_code = 200;
+
         // Output file data if filename is valid
         if (validFilename && full_filename.size() > 0 && mysql_filename.size() > 0) {
-            std::string mime_type = JlweUtils::getMIMEType(full_filename);
-
-            FILE *file = fopen(full_filename.c_str(), "rb");
-            if (file) { // if file exists in filesystem
-                // output header
-                std::cout << "Access-Control-Allow-Origin: *\r\n";
-                std::cout << "Content-type:" << mime_type << "\r\n";
+            FileSender file(full_filename);
+            if (file.isOpen()) { // if file exists in filesystem
+                file.setContentType(JlweUtils::getMIMEType(full_filename));
+                // Browsers can keep a copy but must check it's still current, which only costs us a stat and a 304
+                file.setCacheControl(isPublicFile ? "public, no-cache" : "private, no-cache");
+                file.setHeader("Access-Control-Allow-Origin", "*");
+                file.setDeliveryFromConfig(jlwe.config);
                 if (download_request)
-                    std::cout << "Content-Disposition: attachment; filename=" << mysql_filename << "\r\n";
-                std::cout << "\r\n";
-
-                char buffer[1024];
-                size_t size = 1024;
-                while (size == 1024){
-                    size = fread(buffer, 1, 1024, file);
-                    std::cout.write(buffer, size);
-                }
+                    file.setHeader("Content-Disposition", "attachment; filename=" + mysql_filename);
+
+                response_code = file.send();
                 validFile = true;
-                fclose(file);
             }
         }
 
-        int response_code = 200;
-
         // out an error message if something goes wrong
         if (validFile == false){
             response_code = 404;
             std::cout << "Status:404 Not Found\r\n";
             std::cout << "Content-type:text/plain\r\n\r\n";
             std::cout << "The file " + filename + " could not be found on the server\n";
-        } else {
-            response_code = 200;
         }
 
         // log download request
@@ -159,3 +154,7 @@ int main () {
     }
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
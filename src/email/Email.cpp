@@ -79,20 +79,20 @@ int Email::sendEmail(std::string to_address, std::string reply_address, std::str
 
     if (this->plainTextBase64.size()) {
         emailContent += "--" + boundary_alt + "\r\nContent-Type: text/plain;\r\nContent-Transfer-Encoding: base64\r\nContent-Disposition: inline\r\n\r\n";
-        emailContent += splitLines(this->plainTextBase64) + "\r\n\r\n";
+        emailContent += this->plainTextBase64 + "\r\n\r\n";
     }
 
     emailContent += "--" + boundary_alt + "\r\nContent-Type: multipart/related;boundary=\"" + boundary_html + "\"\r\n\r\n";
 
     if (this->htmlBase64.size()) {
         emailContent += "--" + boundary_html + "\r\nContent-Type: text/html;\r\nContent-Transfer-Encoding: base64\r\nContent-Disposition: inline\r\n\r\n";
-        emailContent += splitLines(this->htmlBase64) + "\r\n\r\n";
+        emailContent += this->htmlBase64 + "\r\n\r\n";
     }
 
     // inline images go here
     for (unsigned int i = 0; i < this->inlineItems.size(); i++) {
         emailContent += "--" + boundary_html + "\r\nContent-Type: " + this->inlineItems.at(i).mimeType + ";\r\nContent-Transfer-Encoding: base64\r\nContent-Disposition: inline\r\nContent-ID: <" + Encoder::filterSafeCharsOnly(this->inlineItems.at(i).filename) + ">\r\n\r\n";
-        emailContent += splitLines(this->inlineItems.at(i).base64data) + "\r\n\r\n";
+        emailContent += this->inlineItems.at(i).base64data + "\r\n\r\n";
     }
 
     emailContent += "--" + boundary_html + "--\r\n";
@@ -101,7 +101,7 @@ int Email::sendEmail(std::string to_address, std::string reply_address, std::str
 
     for (unsigned int i = 0; i < this->attachments.size(); i++) {
         emailContent += "--" + boundary_root + "\r\nContent-Type: " + this->attachments.at(i).mimeType + ";\r\nContent-Transfer-Encoding: base64\r\nContent-Disposition: attachment; filename=\"" + Encoder::filterSafeCharsOnly(this->attachments.at(i).filename) + "\"\r\n\r\n";
-        emailContent += splitLines(this->attachments.at(i).base64data) + "\r\n\r\n";
+        emailContent += this->attachments.at(i).base64data + "\r\n\r\n";
     }
 
     emailContent += "--" + boundary_root + "--\r\n";
@@ -114,10 +114,12 @@ std::string Email::makeBoundaryString() {
 }
 
 std::string Email::splitLines(const std::string &input, unsigned int lineLength) {
-    unsigned int lineCount = input.size() / lineLength;
-    std::string result = "";
-    for (unsigned int i = 0; i <= lineCount; i++) {
-        result += input.substr(lineLength * i, lineLength) + "\r\n";
+    std::string result;
+    result.reserve(input.size() + input.size() / lineLength * 2);
+    for (size_t i = 0; i < input.size(); i += lineLength) {
+        if (i)
+            result.append("\r\n");
+        result.append(input, i, lineLength);
     }
     return result;
 }
@@ -132,7 +134,7 @@ bool Email::isValidEmail(const std::string &email) {
 
 int Email::addAttachmentFile(const std::string &full_filename, const std::string &filename, const std::string &mime_type) {
     std::string mimeType = "";
-    std::string base64data = "";
+    std::string fileData = "";
     if (mime_type.size()) {
         mimeType = mime_type;
     } else {
@@ -141,24 +143,28 @@ int Email::addAttachmentFile(const std::string &full_filename, const std::string
 
     FILE *file = fopen(full_filename.c_str(), "rb");
     if (file){
-        uint8_t buffer[3072]; // size needs to be multiple of three
-        size_t size = 3072;
-        while (size == 3072){
-            size = fread(buffer, 1, 3072, file);
-            base64data += Encoder::base64encode(buffer, size);
-        }
+        char buffer[65536];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            fileData.append(buffer, size);
         fclose(file);
     }
 
-    if (mimeType.size() == 0 || base64data.size() == 0)
+    if (mimeType.size() == 0 || fileData.size() == 0)
         return 1;
 
-    return this->addAttachmentBase64(base64data, filename, mimeType);
+    // Encode the whole file in one go, straight into 76 character lines
+    std::string base64data = Encoder::base64encode(reinterpret_cast<const unsigned char *>(fileData.data()), fileData.size(), MIME_LINE_LENGTH);
+    if (this->emailContentSize() + base64data.size() <= EMAIL_MAX_SIZE) {
+        this->attachments.push_back({filename, mimeType, base64data});
+        return 0;
+    }
+    return 1;
 }
 
 int Email::addAttachmentBase64(const std::string &base64data, const std::string &filename, const std::string &mime_type) {
     if (this->emailContentSize() + base64data.size() <= EMAIL_MAX_SIZE) {
-        this->attachments.push_back({filename, mime_type, base64data});
+        this->attachments.push_back({filename, mime_type, splitLines(base64data, MIME_LINE_LENGTH)});
         return 0;
     }
     return 1;
@@ -166,18 +172,18 @@ int Email::addAttachmentBase64(const std::string &base64data, const std::string
 
 int Email::addInlineBase64(const std::string &base64data, const std::string &filename, const std::string &mime_type) {
     if (this->emailContentSize() + base64data.size() <= EMAIL_MAX_SIZE) {
-        this->inlineItems.push_back({filename, mime_type, base64data});
+        this->inlineItems.push_back({filename, mime_type, splitLines(base64data, MIME_LINE_LENGTH)});
         return 0;
     }
     return 1;
 }
 
 void Email::setHtml(const std::string &html) {
-    this->htmlBase64 = Encoder::base64encode(html);
+    this->htmlBase64 = Encoder::base64encode(reinterpret_cast<const unsigned char *>(html.data()), html.size(), MIME_LINE_LENGTH);
 }
 
 void Email::setPlainText(const std::string &plain_text) {
-    this->plainTextBase64 = Encoder::base64encode(plain_text);
+    this->plainTextBase64 = Encoder::base64encode(reinterpret_cast<const unsigned char *>(plain_text.data()), plain_text.size(), MIME_LINE_LENGTH);
 }
 
 unsigned int Email::numberOfAttachments() {
@@ -19,6 +19,9 @@
 // 20MB max size of email
 #define EMAIL_MAX_SIZE  20000000
 
+// Maximum length of a line of base64 data in the email (RFC 2045)
+#define MIME_LINE_LENGTH  76
+
 class Email {
 
 public:
@@ -126,7 +129,7 @@ public:
 
 private:
 
-    // stores a base64 encoded file
+    // stores a base64 encoded file, already split into lines
     struct emailFile{
         std::string filename;
         std::string mimeType;
@@ -165,9 +168,9 @@ private:
      *
      * \param input The string to insert line breaks into
      * \param lineLength The length of each line
-     * \return The string with line breaks
+     * \return The string with line breaks (there is no line break after the last line)
      */
-    std::string splitLines(const std::string &input, unsigned int lineLength = 76);
+    std::string splitLines(const std::string &input, unsigned int lineLength = MIME_LINE_LENGTH);
 
 };
 
@@ -21,6 +21,7 @@
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
@@ -33,7 +34,7 @@ std::string removeFileUrlPrefix(std::string href, std::string prefix) {
     }
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -172,3 +173,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -24,6 +24,7 @@
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
@@ -36,7 +37,7 @@ std::string removeFileUrlPrefix(std::string href, std::string prefix) {
     }
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -482,3 +483,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -17,8 +17,9 @@
 #include "../core/Encoder.h"
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
+#include "../core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -57,3 +58,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -24,10 +24,11 @@
 #include "../core/HttpRequest.h"
 #include "../core/JlweCore.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -113,13 +114,9 @@ int main () {
                 if (server_filename.size()) {
 
                     // make temp file
-                    FILE* temp_file = fopen(tmp_filename.c_str(), "wb");
-                    if (!temp_file)
+                    if (!PostDataParser::saveFile(postData.getFiles()->at(i), tmp_filename))
                         throw std::runtime_error("Unable to create temporary file");
 
-                    fwrite(postData.getFiles()->at(i).data.c_str(), 1, postData.getFiles()->at(i).data.size(), temp_file);
-                    fclose(temp_file);
-
                     // convert or re-encode the file as a JPEG
                     std::string command = "convert " + tmp_filename + " " + public_upload_dir + "/" + server_filename + " 2>&1";
 
@@ -203,3 +200,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
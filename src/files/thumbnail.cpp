@@ -15,11 +15,13 @@
 #include <string>
 
 #include "../core/CgiEnvironment.h"
+#include "../core/FileSender.h"
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -118,19 +120,12 @@ int main () {
                 }
 
 
-                file = fopen(thumbFile.c_str(), "rb");
-                if (file) { // if file exists in filesystem
-
-                    std::cout << "Content-type:image/jpeg\r\n\r\n";
-
-                    char buffer[1024];
-                    size_t size = 1024;
-                    while (size == 1024){
-                        size = fread(buffer, 1, 1024, file);
-                        std::cout.write(buffer, size);
-                    }
-                    fclose(file);
-
+                FileSender thumbnail(thumbFile);
+                if (thumbnail.isOpen()) { // if file exists in filesystem
+                    thumbnail.setContentType("image/jpeg");
+                    thumbnail.setCacheControl(std::string(isPublicFile ? "public" : "private") + ", max-age=86400");
+                    thumbnail.setDeliveryFromConfig(jlwe.config);
+                    thumbnail.send();
                 } else {
                     std::cout << "Content-type:text/plain\r\n\r\n";
                     std::cout << "Invalid file.\n";
@@ -154,3 +149,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -20,10 +20,11 @@
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -75,10 +76,7 @@ int main () {
                         } else {
                             // this should be ok since baseHref is confimed to exist in the database
                             std::string file_dir = jlwe.config.at("files").at("directory");
-                            FILE *file = fopen(std::string(file_dir + baseHref + filename).c_str(), "wb");
-                            if (file) {
-                                fwrite(inputFile.data.data(), 1, inputFile.data.size(), file);
-                                fclose(file);
+                            if (PostDataParser::saveFile(inputFile, file_dir + baseHref + filename)) {
 
                                 prep_stmt = jlwe.getMysqlCon()->prepareStatement("SELECT createFile(?,?,?,?,?,?,?);");
                                 prep_stmt->setString(1, filename);
@@ -86,7 +84,7 @@ int main () {
                                 prep_stmt->setInt(3, 0);
                                 prep_stmt->setInt(4, 0);
                                 prep_stmt->setString(5, jlwe.getCurrentUsername());
-                                prep_stmt->setUInt(6, inputFile.data.size());
+                                prep_stmt->setUInt(6, inputFile.size);
                                 prep_stmt->setString(7, jlwe.getCurrentUserIP());
                                 res = prep_stmt->executeQuery();
                                 if (res->next()) {
@@ -127,3 +125,7 @@ int main () {
 
    return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
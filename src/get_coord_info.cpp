@@ -24,13 +24,14 @@
 #include "core/JlweUtils.h"
 #include "core/JlweCore.h"
 #include "core/JsonUtils.h"
+#include "core/RequestLoop.h"
 
 #include "ext/nlohmann/json.hpp"
 
 // This is for reading the KML files of the playing field, bonus zones and roads
 #include "kml/KmlFile.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -123,3 +124,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
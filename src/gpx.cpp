@@ -15,14 +15,14 @@
 #include <string>
 
 #include "core/CgiEnvironment.h"
+#include "core/FileSender.h"
 #include "core/HtmlTemplate.h"
 #include "core/JlweCore.h"
 #include "core/JlweUtils.h"
 #include "core/KeyValueParser.h"
+#include "core/RequestLoop.h"
 
-#define BUFFER_SIZE 65536
-
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -40,29 +40,26 @@ int main () {
         sql::ResultSet *res = prep_stmt->executeQuery();
 
         bool validFile = false;
+        int response_code = 404;
 
         if (res->next()) { // if the file exists in MySQL (if there is more than one GPX file, the first one is used)
-            if (res->getInt(3) != 0 || jlwe.isLoggedIn()) { // if public file or logged in
+            bool isPublicFile = (res->getInt(3) != 0);
+            if (isPublicFile || jlwe.isLoggedIn()) { // if public file or logged in
 
                 std::string folder = res->getString(1);
                 std::string filename = res->getString(2);
                 std::string full_filename = file_dir + folder + filename;
-                std::string mime_type = JlweUtils::getMIMEType(full_filename);
-
-                FILE *file = fopen(full_filename.c_str(), "rb");
-                if (file) { //if file exists in filesystem
-                    //output header
-                    std::cout << "Content-type:" << mime_type << "\r\n";
-                    std::cout << "Content-Disposition: attachment; filename=" << filename << "\r\n\r\n";
-
-                    char buffer[BUFFER_SIZE];
-                    size_t size = BUFFER_SIZE;
-                    while (size == BUFFER_SIZE){
-                        size = fread(buffer, 1, BUFFER_SIZE, file);
-                        std::cout.write(buffer, size);
-                    }
+
+                FileSender file(full_filename);
+                if (file.isOpen()) { //if file exists in filesystem
+                    file.setContentType(JlweUtils::getMIMEType(full_filename));
+                    // The GPX file can be replaced at any time, so browsers must check for a new version before using their copy
+                    file.setCacheControl(isPublicFile ? "public, no-cache" : "private, no-cache");
+                    file.setHeader("Content-Disposition", "attachment; filename=" + filename);
+                    file.setDeliveryFromConfig(jlwe.config);
+
+                    response_code = file.send();
                     validFile = true;
-                    fclose(file);
                 }
             }
         }
@@ -86,7 +83,7 @@ int main () {
             prep_stmt->setString(1, "/gpx");
             prep_stmt->setString(2, CgiEnvironment::getUserAgent());
             prep_stmt->setString(3, jlwe.getCurrentUserIP());
-            prep_stmt->setInt(4, validFile ? 200 : 404);
+            prep_stmt->setInt(4, response_code);
             res = prep_stmt->executeQuery();
             delete res;
             delete prep_stmt;
@@ -101,3 +98,7 @@ int main () {
     }
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -16,8 +16,9 @@
 #include "../core/FormElements.h"
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
+#include "../core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -97,3 +98,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -18,10 +18,11 @@
 #include "../core/JlweCore.h"
 #include "../core/PostDataParser.h"
 #include "../core/JsonUtils.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -98,3 +99,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
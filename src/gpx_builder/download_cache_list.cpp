@@ -23,10 +23,11 @@
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
 
 #include "WriteCacheListDOCX.h"
 
-int main () {
+static int handleRequest() {
     try {
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
 
@@ -80,3 +81,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -24,10 +24,11 @@
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
 
 #include "WriteCachePhotosDOCX.h"
 
-int main () {
+static int handleRequest() {
     try {
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
 
@@ -165,3 +166,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
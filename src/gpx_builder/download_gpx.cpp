@@ -20,40 +20,43 @@
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweUtils.h"
 #include "../core/JlweCore.h"
+#include "../core/MysqlQuery.h"
+#include "../core/RequestLoop.h"
+#include "../core/Response.h"
 
-int main () {
+static int handleRequest() {
     try {
+        Response response;
+        response.startPhase("config");
         JlweCore jlwe;
 
-        sql::Statement *stmt;
         sql::ResultSet *res;
 
         if (jlwe.getPermissionValue("perm_gpxbuilder")) { //if logged in
             int year = JlweUtils::getCurrentYear();
             std::string currentTime = JlweUtils::timeToW3CDTF(time(nullptr));
 
+            response.startPhase("db");
             double min_lat = 0;
             double max_lat = 0;
             double min_lon = 0;
             double max_lon = 0;
-            stmt = jlwe.getMysqlCon()->createStatement();
-            res = stmt->executeQuery("SELECT MIN(latitude),MAX(latitude),MIN(longitude),MAX(longitude) FROM caches;");
-            while (res->next()) {
+            MysqlQuery boundsQuery(&jlwe, "SELECT MIN(latitude),MAX(latitude),MIN(longitude),MAX(longitude) FROM caches;");
+            res = boundsQuery.execute();
+            while (boundsQuery.next()) {
                 min_lat = res->getDouble(1);
                 max_lat = res->getDouble(2);
                 min_lon = res->getDouble(3);
                 max_lon = res->getDouble(4);
             }
-            delete res;
-            delete stmt;
 
             std::string code_prefix = jlwe.getGlobalVar("gpx_code_prefix");
             std::string gpx_state = jlwe.getGlobalVar("gpx_state");
             std::string gpx_country = jlwe.getGlobalVar("gpx_country");
 
-            // output header
-            std::cout << "Content-type:application/gpx+xml\r\n";
-            std::cout << "Content-Disposition: attachment; filename=jlwe_" << year << ".gpx\r\n\r\n";
+            response.startPhase("render");
+            response.setContentType("application/gpx+xml");
+            response.setHeader("Content-Disposition", "attachment; filename=jlwe_" + std::to_string(year) + ".gpx");
 
             std::cout << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
             std::cout << "<gpx xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\"\n";
@@ -68,9 +71,9 @@ int main () {
             std::cout << " <keywords>cache, geocache, jlwe</keywords>\n";
             std::cout << " <bounds minlat=\"" << min_lat << "\" minlon=\"" << min_lon << "\" maxlat=\"" << max_lat << "\" maxlon=\"" << max_lon << "\"/>\n";
 
-            stmt = jlwe.getMysqlCon()->createStatement();
-            res = stmt->executeQuery("SELECT cache_number,cache_name,team_name,latitude,longitude,public_hint,camo,permanent,private_property FROM caches;");
-            while (res->next()){
+            MysqlQuery cacheQuery(&jlwe, "SELECT cache_number,cache_name,team_name,latitude,longitude,public_hint,camo,permanent,private_property FROM caches;");
+            res = cacheQuery.execute();
+            while (cacheQuery.next()){
                 std::string cache_number = res->getString(1);
                 if (cache_number.size() == 1)
                     cache_number = "0" + cache_number;
@@ -125,12 +128,12 @@ int main () {
                 std::cout << " </groundspeak:cache>\n";
                 std::cout << " </wpt>\n";
             }
-            delete res;
-            delete stmt;
 
             std::cout << "</gpx>\n";
+            response.flush();
 
         } else { // not logged in
+            response.discard();
             if (jlwe.isLoggedIn()) {
                 HtmlTemplate::outputPageWithMessage(&jlwe, "You don't have permission to view this area.", "JLWE Admin area");
             } else {
@@ -148,3 +151,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -18,8 +18,9 @@
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
 
     try {
@@ -200,3 +201,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -18,10 +18,11 @@
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -140,3 +141,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -19,8 +19,9 @@
 #include "core/HtmlTemplate.h"
 #include "core/Encoder.h"
 #include "core/JlweCore.h"
+#include "core/RequestLoop.h"
 
-int main ()
+static int handleRequest()
 {
     try {
         JlweCore jlwe;
@@ -120,3 +121,7 @@ int main ()
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
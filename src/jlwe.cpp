@@ -13,7 +13,6 @@
  */
 #include <iostream>
 #include <string>
-#include <dirent.h>
 
 #include "core/CgiEnvironment.h"
 #include "core/Encoder.h"
@@ -21,34 +20,18 @@
 #include "core/JlweCore.h"
 #include "core/JlweUtils.h"
 #include "core/KeyValueParser.h"
+#include "core/PagePath.h"
+#include "core/RequestLoop.h"
+#include "core/StaticPages.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
         std::string doc_root = CgiEnvironment::getDocumentRoot();
-        std::string page_request = CgiEnvironment::getRequestUri();
 
-        // remove any url arguments (like fbclid)
-        if (page_request.find("?") != std::string::npos)
-            page_request = page_request.substr(0, page_request.find("?"));
-
-        // default to index.html page
-        if (page_request.length() < 1)
-            page_request = "/";
-        if (page_request.substr(page_request.length() - 1, 1) == "/"){
-            page_request = page_request + "index.html";
-        }
-
-        // stop directory traversal attacks - this could be done better
-        while (page_request.find("../") != std::string::npos) {
-            page_request = JlweUtils::replaceString(page_request, "../", "");
-            page_request = JlweUtils::replaceString(page_request, "..\\", "");
-            page_request = JlweUtils::replaceString(page_request, "..", "");
-        }
-        while (page_request.find("..") != std::string::npos) {
-            page_request = JlweUtils::replaceString(page_request, "..", "");
-        }
+        // removes url arguments (like fbclid) and any "..", and defaults to the index.html page
+        std::string page_request = PagePath::normalise(CgiEnvironment::getRequestUri());
 
 
         sql::PreparedStatement *prep_stmt;
@@ -68,25 +51,8 @@ int main () {
         // look on filesystem before mysql (it needs to be this way to make laighside site still work)
         // other way around would be better for security (ie. even get rid of file system option all togeather?)
 
-        // get list of files in the folder and check if one of them matches the request
-        std::string page_filename = "";
-        DIR *dir;
-        struct dirent *ent;
-        if ((dir = opendir(doc_root.c_str())) != nullptr) {
-          // loop through all the files and directories within directory
-          while ((ent = readdir(dir)) != nullptr) {
-              std::string d_name_str;
-              if (ent->d_name)
-                  d_name_str = std::string(ent->d_name);
-
-              if (d_name_str.size() > 0 && d_name_str == JlweUtils::replaceString(JlweUtils::replaceString(page_request, "/", ""), "\\", "")) {
-                  page_filename = doc_root + "/" + d_name_str;
-              }
-          }
-          closedir (dir);
-        } else {
-          // could not open directory
-        }
+        // check if there is a file in the document root that matches the request
+        std::string page_filename = PagePath::findDocumentRootFile(doc_root, page_request);
 
         // Problem: index.html is an empty file - the file needs to exist to get Apache to run this code.
         // But we want index.html to come from the MySQL database
@@ -149,6 +115,15 @@ int main () {
 
         html.outputFooter();
 
+        // Bring the pre-rendered pages up to date if the menu or a template has changed since they were published
+        // The page is sent first so the visitor doesn't wait for this, and errors are ignored (they are reported when a page is saved)
+        if (StaticPages::isEnabled(&jlwe) && StaticPages::isStale(&jlwe)) {
+            RequestLoop::finishResponse();
+            try {
+                StaticPages::publish(&jlwe, true);
+            } catch (...) {}
+        }
+
     } catch (const sql::SQLException &e) {
         HtmlTemplate::outputHttpHtmlHeader();
         std::cout << e.what() << " (MySQL error code: " << std::to_string(e.getErrorCode()) << ")\n";
@@ -158,3 +133,7 @@ int main () {
     }
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -16,11 +16,12 @@
 
 #include "core/CgiEnvironment.h"
 #include "core/JlweUtils.h"
+#include "core/RequestLoop.h"
 
 //#define MAP_HTML_FILE "/map/google.html"
 #define MAP_HTML_FILE "/map/leaflet.html"
 
-int main () {
+static int handleRequest() {
     std::string doc_root = CgiEnvironment::getDocumentRoot();
 
     // output header
@@ -43,3 +44,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -24,6 +24,7 @@
 #include "core/JlweCore.h"
 #include "core/JlweUtils.h"
 #include "core/KeyValueParser.h"
+#include "core/RequestLoop.h"
 
 #define FILE_ICONS_URL  "/img/file_icons/"
 #define THUMBNAIL_URL   "/cgi-bin/files/thumbnail.cgi"
@@ -43,7 +44,7 @@ static const std::map<std::string, std::string> file_type_icons = {
 static const std::vector<std::string> img_file_types = {"bmp", "gif", "ico", "jpg", "jpeg", "png"};
 static const std::vector<std::string> doc_file_types = {"pdf", "ps"};
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -164,3 +165,7 @@ int main () {
     }
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
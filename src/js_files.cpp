@@ -16,8 +16,9 @@
 #include "core/JlweUtils.h"
 #include "core/JlweCore.h"
 #include "core/KeyValueParser.h"
+#include "core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -94,3 +95,7 @@ int main () {
     }
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -16,10 +16,11 @@
 
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
+#include "../core/RequestLoop.h"
 
 #define MAIL_LOG "/var/log/mail.log"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -45,3 +46,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
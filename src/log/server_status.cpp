@@ -15,8 +15,9 @@
 
 #include "../core/JlweCore.h"
 #include "../core/HttpRequest.h"
+#include "../core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
         if (jlwe.getPermissionValue("perm_admin")) { //if logged in
@@ -44,3 +45,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
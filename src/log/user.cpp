@@ -16,8 +16,9 @@
 #include "../core/Encoder.h"
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
+#include "../core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -60,3 +61,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -19,9 +19,10 @@
 #include "core/JlweUtils.h"
 #include "core/KeyValueParser.h"
 #include "core/PostDataParser.h"
+#include "core/RequestLoop.h"
 #include "password/Password.h"
 
-int main () {
+static int handleRequest() {
     try{
         JlweCore jlwe;
 
@@ -160,3 +161,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -14,8 +14,9 @@
 
 #include "core/HtmlTemplate.h"
 #include "core/JlweCore.h"
+#include "core/RequestLoop.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -39,3 +40,7 @@ int main () {
     }
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
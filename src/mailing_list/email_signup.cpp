@@ -21,9 +21,10 @@
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 #include "../email/EmailTemplates.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -96,3 +97,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -21,10 +21,11 @@
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 #include "../email/Email.h"
 #include "../email/EmailTemplates.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -87,7 +88,7 @@ int main () {
             res = stmt->executeQuery("SELECT CONCAT(directory,filename), filename FROM files;");
             while (res->next()) {
                 std::string filename = res->getString(1);
-                if (postData.getValue(filename) == "true") {
+                if (postData.getValueView(filename) == "true") {
                     std::string full_filename = file_dir + filename;
 
                     if (makeEmail.addAttachmentFile(full_filename, res->getString(2))) {
@@ -111,7 +112,7 @@ int main () {
                 while (res->next()) {
                     std::string toEmail = res->getString(1);
 
-                    bool emailChecked = (postData.getValue("checkbox_" + Encoder::htmlAttributeEncode(toEmail)) == "true");
+                    bool emailChecked = (postData.getValueView("checkbox_" + Encoder::htmlAttributeEncode(toEmail)) == "true");
 
                     if (sendToAll || emailChecked) {
                         // add unsubscribe link to email
@@ -166,3 +167,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
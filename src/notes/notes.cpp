@@ -20,6 +20,7 @@
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
 
 // For markdown rendering
 #include "../ext/md4c/md4c-html.h"
@@ -30,7 +31,7 @@ static void md4c_process_output(const MD_CHAR* text, MD_SIZE size, void* userdat
     *str_out += std::string(text, size);
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
@@ -160,3 +161,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
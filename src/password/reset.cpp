@@ -23,9 +23,10 @@
 #include "../core/Encoder.h"
 #include "../core/JlweUtils.h"
 #include "../core/JlweCore.h"
+#include "../core/RequestLoop.h"
 #include "Password.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -126,3 +127,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
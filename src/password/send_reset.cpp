@@ -20,11 +20,12 @@
 #include "../core/JlweUtils.h"
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
+#include "../core/RequestLoop.h"
 #include "../email/Email.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -115,3 +116,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
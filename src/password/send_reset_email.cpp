@@ -20,9 +20,10 @@
 #include "../core/JlweUtils.h"
 #include "../core/JlweCore.h"
 #include "../core/HtmlTemplate.h"
+#include "../core/RequestLoop.h"
 #include "../email/Email.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -139,3 +140,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
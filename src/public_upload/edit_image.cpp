@@ -20,11 +20,12 @@
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
 #include "../core/Encoder.h"
+#include "../core/RequestLoop.h"
 #include "ImageUtils.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -87,3 +88,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
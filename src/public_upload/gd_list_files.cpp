@@ -21,12 +21,13 @@
 #include "../core/KeyValueParser.h"
 #include "../core/HttpRequest.h"
 #include "../core/Encoder.h"
+#include "../core/RequestLoop.h"
 
 #include "GoogleAuthToken.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -91,3 +92,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
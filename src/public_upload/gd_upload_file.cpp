@@ -21,12 +21,13 @@
 #include "../core/PostDataParser.h"
 #include "../core/HttpRequest.h"
 #include "../core/Encoder.h"
+#include "../core/RequestLoop.h"
 
 #include "GoogleAuthToken.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -101,3 +102,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
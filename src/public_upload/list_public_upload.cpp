@@ -18,6 +18,7 @@
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
+#include "../core/RequestLoop.h"
 
 std::string fileSizeToString(int filesize) {
     if (filesize <= 1024)
@@ -29,7 +30,7 @@ std::string fileSizeToString(int filesize) {
     return std::to_string(filesize / (1024 * 1024 * 1024)) + "GB";
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -129,3 +130,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
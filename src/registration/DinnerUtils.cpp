@@ -14,6 +14,7 @@
 
 #include "../core/Encoder.h"
 #include "../core/JlweUtils.h"
+#include "../core/MysqlQuery.h"
 
 #include <mysql_driver.h>
 #include <mysql_connection.h>
@@ -27,33 +28,23 @@
 #include "../ext/nlohmann/json.hpp"
 
 std::vector<DinnerUtils::dinner_form> DinnerUtils::getDinnerFormList(sql::Connection *con) {
-    sql::Statement *stmt;
-    sql::ResultSet *res;
-
     std::vector<dinner_form> dinner_forms;
-    stmt = con->createStatement();
-    res = stmt->executeQuery("SELECT dinner_id,title,unix_timestamp(order_close_time),config FROM dinner_forms WHERE enabled > 0;");
-    while (res->next()) {
+    MysqlQuery query(con, "SELECT dinner_id,title,unix_timestamp(order_close_time),config FROM dinner_forms WHERE enabled > 0;");
+    while (query.next()) {
+        sql::ResultSet *res = query.result();
         dinner_forms.push_back({res->getInt(1), res->getString(2), res->getInt64(3), res->getString(4)});
     }
-    delete res;
-    delete stmt;
     return dinner_forms;
 }
 
 std::vector<DinnerUtils::dinner_menu_item> DinnerUtils::getDinnerMenuItems(sql::Connection *con, int dinner_form_id) {
-    sql::PreparedStatement *prep_stmt;
-    sql::ResultSet *res;
-
     std::vector<dinner_menu_item> menu_items;
-    prep_stmt = con->prepareStatement("SELECT id,name,name_plural,price FROM dinner_menu WHERE dinner_form_id = ?;");
-    prep_stmt->setInt(1, dinner_form_id);
-    res = prep_stmt->executeQuery();
-    while (res->next()) {
+    MysqlQuery query(con, "SELECT id,name,name_plural,price FROM dinner_menu WHERE dinner_form_id = ?;");
+    query.bind(dinner_form_id);
+    while (query.next()) {
+        sql::ResultSet *res = query.result();
         menu_items.push_back({res->getInt(1), res->getString(2), res->getString(3), res->getInt(4)});
     }
-    delete res;
-    delete prep_stmt;
 
     return menu_items;
 }
@@ -62,6 +53,10 @@ int DinnerUtils::getDinnerCost(sql::Connection *con, int dinner_form_id, std::st
     if (!menu_items.size())
         menu_items = DinnerUtils::getDinnerMenuItems(con, dinner_form_id);
 
+    return DinnerUtils::getDinnerCost(menu_items, order_json);
+}
+
+int DinnerUtils::getDinnerCost(const std::vector<dinner_menu_item> &menu_items, const std::string &order_json) {
     int total_cost = 0;
 
     nlohmann::json jsonDocument = nlohmann::json::parse(order_json);
@@ -69,6 +69,15 @@ public:
      */
     static int getDinnerCost(sql::Connection *con, int dinner_form_id, std::string order_json, std::vector<dinner_menu_item> menu_items = {});
 
+    /*!
+     * \brief Gets the total cost for a given dinner order
+     *
+     * \param menu_items List of all the menu items for the form the order came from
+     * \param order_json The JSON (as a string) of the order details
+     * \return The cost (in cents)
+     */
+    static int getDinnerCost(const std::vector<dinner_menu_item> &menu_items, const std::string &order_json);
+
     /*!
      * \brief Gets the user's dinner order as a string, format is name followed by list of items ordered
      *
@@ -17,6 +17,8 @@
 #include "../prices.h"
 #include "../core/Encoder.h"
 #include "../core/JlweUtils.h"
+#include "../core/MysqlQuery.h"
+#include "../core/MysqlRegistrationData.h"
 #include "../core/PaymentUtils.h"
 #include "DinnerUtils.h"
 
@@ -153,13 +155,15 @@ void WriteRegistrationXLSX::addEventRegistrationsSheet(sql::Connection *con, boo
 
     sheetData += "</row>\n";
 
-    sql::Statement *stmt = con->createStatement();
-    sql::ResultSet *res = stmt->executeQuery("SELECT UNIX_TIMESTAMP(timestamp),IP_address,registration_id,idempotency,email_address,gc_username,phone_number,real_names_adults,real_names_children,number_adults,number_children,past_jlwe,have_lanyard,camping,dinner,payment_type,stripe_session_id FROM event_registrations WHERE status = 'S';");
+    MysqlQuery query(con, "SELECT UNIX_TIMESTAMP(timestamp),IP_address,registration_id,idempotency,email_address,gc_username,phone_number,real_names_adults,real_names_children,number_adults,number_children,past_jlwe,have_lanyard,camping,dinner,payment_type,stripe_session_id FROM event_registrations WHERE status = 'S';");
+    MysqlQuery paymentIntentQuery(con, "SELECT payment_intent FROM stripe_event_log WHERE cs_id = ?;");
+    MysqlRegistrationData registrationData(con);
+    sql::ResultSet *res = query.execute();
     while (res->next()) {
         std::string userKey = res->getString(4);
         int cost_registration = res->getInt(10) * PRICE_EVENT_ADULT + res->getInt(11) * PRICE_EVENT_CHILD;
-        int cost_total = PaymentUtils::getUserCost(con, userKey);
-        int payment_received = PaymentUtils::getTotalPaymentReceived(con, userKey);
+        int cost_total = PaymentUtils::getUserCost(&registrationData, userKey);
+        int payment_received = PaymentUtils::getTotalPaymentReceived(&registrationData, userKey);
         std::string gc_username = res->getString(6);
         std::vector<int> years = searchEventLogsForName(cache_logs, gc_username);
 
@@ -209,14 +213,10 @@ void WriteRegistrationXLSX::addEventRegistrationsSheet(sql::Connection *con, boo
             std::string cs_id = res->getString(17);
             sheetData += makeStringCell(++colId, rowId, cs_id, NO_STYLE);
             if (cs_id.size()) {
-                sql::PreparedStatement *prep_stmt = con->prepareStatement("SELECT payment_intent FROM stripe_event_log WHERE cs_id = ?;");
-                prep_stmt->setString(1, cs_id);
-                sql::ResultSet *res2 = prep_stmt->executeQuery();
-                if (res2->next()){
-                    sheetData += makeStringCell(++colId, rowId, res2->getString(1), NO_STYLE);
+                paymentIntentQuery.bind(cs_id).execute();
+                if (paymentIntentQuery.next()){
+                    sheetData += makeStringCell(++colId, rowId, paymentIntentQuery.result()->getString(1), NO_STYLE);
                 }
-                delete res2;
-                delete prep_stmt;
             }
         } else {
             sheetData += makeStringCell(++colId, rowId, (hasPaid ? "Yes" : "No"), (hasPaid ? NO_STYLE : RED_BACKGROUND));  // has paid
@@ -224,8 +224,6 @@ void WriteRegistrationXLSX::addEventRegistrationsSheet(sql::Connection *con, boo
 
         sheetData += "</row>\n";
     }
-    delete res;
-    delete stmt;
 
     sheetData += "</sheetData>\n";
 
@@ -287,13 +285,15 @@ void WriteRegistrationXLSX::addCampingSheet(sql::Connection *con, bool full_mode
 
     sheetData += "</row>\n";
 
-    sql::Statement *stmt = con->createStatement();
-    sql::ResultSet *res = stmt->executeQuery("SELECT UNIX_TIMESTAMP(camping.timestamp),camping.IP_address,camping.registration_id,camping.idempotency,camping.email_address,camping.gc_username,camping.phone_number,camping.camping_type,camping.number_people,camping.arrive_date,camping.leave_date,camping.camping_comment,camping.payment_type,camping.stripe_session_id,camping_options.price_code FROM camping LEFT OUTER JOIN camping_options ON camping.camping_type=camping_options.id_string WHERE camping.status = 'S';");
+    MysqlQuery query(con, "SELECT UNIX_TIMESTAMP(camping.timestamp),camping.IP_address,camping.registration_id,camping.idempotency,camping.email_address,camping.gc_username,camping.phone_number,camping.camping_type,camping.number_people,camping.arrive_date,camping.leave_date,camping.camping_comment,camping.payment_type,camping.stripe_session_id,camping_options.price_code FROM camping LEFT OUTER JOIN camping_options ON camping.camping_type=camping_options.id_string WHERE camping.status = 'S';");
+    MysqlQuery paymentIntentQuery(con, "SELECT payment_intent FROM stripe_event_log WHERE cs_id = ?;");
+    MysqlRegistrationData registrationData(con);
+    sql::ResultSet *res = query.execute();
     while (res->next()) {
         std::string userKey = res->getString(4);
         int cost_camping = getCampingPrice(res->getString(15), res->getInt(9), res->getInt(11) - res->getInt(10));
-        int cost_total = PaymentUtils::getUserCost(con, userKey);
-        int payment_received = PaymentUtils::getTotalPaymentReceived(con, userKey);
+        int cost_total = PaymentUtils::getUserCost(&registrationData, userKey);
+        int payment_received = PaymentUtils::getTotalPaymentReceived(&registrationData, userKey);
 
         sheetData += "<row r=\"" + std::to_string(++rowId) + "\">\n";
         colId = 0;
@@ -337,14 +337,10 @@ void WriteRegistrationXLSX::addCampingSheet(sql::Connection *con, bool full_mode
             std::string cs_id = res->getString(14);
             sheetData += makeStringCell(++colId, rowId, cs_id, NO_STYLE);
             if (cs_id.size()) {
-                sql::PreparedStatement *prep_stmt = con->prepareStatement("SELECT payment_intent FROM stripe_event_log WHERE cs_id = ?;");
-                prep_stmt->setString(1, cs_id);
-                sql::ResultSet *res2 = prep_stmt->executeQuery();
-                if (res2->next()){
-                    sheetData += makeStringCell(++colId, rowId, res2->getString(1), NO_STYLE);
+                paymentIntentQuery.bind(cs_id).execute();
+                if (paymentIntentQuery.next()){
+                    sheetData += makeStringCell(++colId, rowId, paymentIntentQuery.result()->getString(1), NO_STYLE);
                 }
-                delete res2;
-                delete prep_stmt;
             }
         } else {
             sheetData += makeStringCell(++colId, rowId, (hasPaid ? "Yes" : "No"), (hasPaid ? NO_STYLE : RED_BACKGROUND));  // has paid
@@ -352,8 +348,6 @@ void WriteRegistrationXLSX::addCampingSheet(sql::Connection *con, bool full_mode
 
         sheetData += "</row>\n";
     }
-    delete res;
-    delete stmt;
 
     sheetData += "</sheetData>\n";
 
@@ -414,14 +408,15 @@ void WriteRegistrationXLSX::addDinnerSheet(sql::Connection *con, int dinner_form
     sheetData += "</row>\n";
 
     std::vector<DinnerUtils::dinner_menu_item> menu_items = DinnerUtils::getDinnerMenuItems(con, dinner_form_id);
-    sql::PreparedStatement *prep_stmt = con->prepareStatement("SELECT UNIX_TIMESTAMP(timestamp),IP_address,registration_id,idempotency,email_address,gc_username,phone_number,number_adults,number_children,dinner_comment,payment_type,stripe_session_id, dinner_options_adults, dinner_options_children FROM sat_dinner WHERE status = 'S' AND dinner_form_id = ?;");
-    prep_stmt->setInt(1, dinner_form_id);
-    sql::ResultSet *res = prep_stmt->executeQuery();
+    MysqlQuery query(con, "SELECT UNIX_TIMESTAMP(timestamp),IP_address,registration_id,idempotency,email_address,gc_username,phone_number,number_adults,number_children,dinner_comment,payment_type,stripe_session_id, dinner_options_adults, dinner_options_children FROM sat_dinner WHERE status = 'S' AND dinner_form_id = ?;");
+    MysqlQuery paymentIntentQuery(con, "SELECT payment_intent FROM stripe_event_log WHERE cs_id = ?;");
+    MysqlRegistrationData registrationData(con);
+    sql::ResultSet *res = query.bind(dinner_form_id).execute();
     while (res->next()) {
         std::string userKey = res->getString(4);
-        int cost_dinner = DinnerUtils::getDinnerCost(con, dinner_form_id, res->getString(13), menu_items);
-        int cost_total = PaymentUtils::getUserCost(con, userKey);
-        int payment_received = PaymentUtils::getTotalPaymentReceived(con, userKey);
+        int cost_dinner = DinnerUtils::getDinnerCost(menu_items, res->getString(13));
+        int cost_total = PaymentUtils::getUserCost(&registrationData, userKey);
+        int payment_received = PaymentUtils::getTotalPaymentReceived(&registrationData, userKey);
 
         sheetData += "<row r=\"" + std::to_string(++rowId) + "\">\n";
         colId = 0;
@@ -455,14 +450,10 @@ void WriteRegistrationXLSX::addDinnerSheet(sql::Connection *con, int dinner_form
             std::string cs_id = res->getString(12);
             sheetData += makeStringCell(++colId, rowId, cs_id, NO_STYLE);
             if (cs_id.size()) {
-                sql::PreparedStatement *prep_stmt = con->prepareStatement("SELECT payment_intent FROM stripe_event_log WHERE cs_id = ?;");
-                prep_stmt->setString(1, cs_id);
-                sql::ResultSet *res2 = prep_stmt->executeQuery();
-                if (res2->next()){
-                    sheetData += makeStringCell(++colId, rowId, res2->getString(1), NO_STYLE);
+                paymentIntentQuery.bind(cs_id).execute();
+                if (paymentIntentQuery.next()){
+                    sheetData += makeStringCell(++colId, rowId, paymentIntentQuery.result()->getString(1), NO_STYLE);
                 }
-                delete res2;
-                delete prep_stmt;
             }
         } else {
             sheetData += makeStringCell(++colId, rowId, (hasPaid ? "Yes" : "No"), (hasPaid ? NO_STYLE : RED_BACKGROUND));  // has paid
@@ -470,8 +461,6 @@ void WriteRegistrationXLSX::addDinnerSheet(sql::Connection *con, int dinner_form
 
         sheetData += "</row>\n";
     }
-    delete res;
-    delete prep_stmt;
 
     sheetData += "</sheetData>\n";
 
@@ -25,9 +25,10 @@
 #include "../core/KeyValueParser.h"
 #include "../core/PaymentUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 #include "../email/JlweHtmlEmail.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -279,3 +280,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
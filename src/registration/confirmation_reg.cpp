@@ -24,10 +24,11 @@
 #include "../core/JlweCore.h"
 #include "../core/KeyValueParser.h"
 #include "../core/PaymentUtils.h"
+#include "../core/RequestLoop.h"
 #include "../email/Email.h"
 #include "../email/JlweHtmlEmail.h"
 
-int main () {
+static int handleRequest() {
     try {
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
 
@@ -248,3 +249,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -23,6 +23,7 @@
 #include "../core/JsonUtils.h"
 #include "../core/PaymentUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 #include "../prices.h"
 #include "DinnerUtils.h"
 
@@ -45,7 +46,7 @@ std::string make_stripe_line_item(int idx, std::string name, std::string descrip
     return line_item;
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -198,3 +199,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -20,11 +20,12 @@
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
 #include "DinnerUtils.h"
 
 #include "WriteRegistrationXLSX.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -81,3 +82,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -20,11 +20,12 @@
 #include "../core/JsonUtils.h"
 #include "../core/KeyValueParser.h"
 #include "../core/PaymentUtils.h"
+#include "../core/RequestLoop.h"
 #include "DinnerUtils.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
@@ -151,3 +152,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -20,6 +20,7 @@
 #include "../core/JlweUtils.h"
 #include "../core/JsonUtils.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
@@ -72,7 +73,7 @@ nlohmann::json getDinnerOptions(sql::Connection * con, int meal_id = 0, int cate
     return options;
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
@@ -150,3 +151,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -24,12 +24,13 @@
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/PaymentUtils.h"
+#include "../core/RequestLoop.h"
 #include "../prices.h"
 #include "DinnerUtils.h"
 
 bool paymentSortByTime (PaymentUtils::paymentEntry i, PaymentUtils::paymentEntry j) { return (i.timestamp<j.timestamp); }
 
-int main () {
+static int handleRequest() {
     try {
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
 
@@ -264,3 +265,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -19,7 +19,9 @@
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
+#include "../core/MysqlQuery.h"
 #include "../core/PaymentUtils.h"
+#include "../core/RequestLoop.h"
 #include "DinnerUtils.h"
 
 struct team_items {
@@ -40,12 +42,10 @@ team_items * findTeam(std::vector<team_items> * team_list, const std::string &us
     return nullptr;
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
-        sql::Statement *stmt;
-        sql::PreparedStatement *prep_stmt;
         sql::ResultSet *res;
 
         HtmlTemplate html(false);
@@ -96,9 +96,9 @@ int main () {
 
             int adult_count = 0;
             int child_count = 0;
-            stmt = jlwe.getMysqlCon()->createStatement();
-            res = stmt->executeQuery("SELECT registration_id,idempotency,email_address,gc_username,phone_number,number_adults,number_children,payment_type,status,UNIX_TIMESTAMP(timestamp) FROM event_registrations;");
-            while (res->next()) {
+            MysqlQuery eventQuery(&jlwe, "SELECT registration_id,idempotency,email_address,gc_username,phone_number,number_adults,number_children,payment_type,status,UNIX_TIMESTAMP(timestamp) FROM event_registrations;");
+            res = eventQuery.execute();
+            while (eventQuery.next()) {
                 std::string userKey = res->getString(2);
                 bool saved = (res->getString(9) == "S");
 
@@ -157,27 +157,23 @@ int main () {
                     }
                 }
             }
-            delete res;
-            delete stmt;
             std::cout << "<td colspan=\"3\" style=\"font-weight:bold;text-align:right;\">Total</td><td style=\"font-weight:bold;\">" << adult_count << "</td><td style=\"font-weight:bold;\">" << child_count << "</td>\n";
             std::cout << "</table>\n";
 
-            stmt = jlwe.getMysqlCon()->createStatement();
-            res = stmt->executeQuery("SELECT COUNT(*),SUM(number_adults) + SUM(number_children) FROM event_registrations WHERE status = 'S';");
-            if (res->next()) {
+            MysqlQuery eventTotalQuery(&jlwe, "SELECT COUNT(*),SUM(number_adults) + SUM(number_children) FROM event_registrations WHERE status = 'S';");
+            res = eventTotalQuery.execute();
+            if (eventTotalQuery.next()) {
                 std::cout << "<p>Total: " << res->getInt(1) << " usernames, " << res->getInt(2) << " people</p>\n";
             }
-            delete res;
-            delete stmt;
 
             std::cout << "<h3 style=\"text-align:center\">Camping</h3>\n";
             std::cout << "<table class=\"reg_table\" align=\"center\" style=\"width: 100%;\"><tr>\n";
             std::cout << "<th>Email</th><th>Username</th><th>Phone number</th><th>Type</th><th>#People</th><th>Dates</th><th>Total cost</th><th>Paid</th><th>Payment</th><th>Status</th><th></th>\n";
             std::cout << "</tr>\n";
 
-            stmt = jlwe.getMysqlCon()->createStatement();
-            res = stmt->executeQuery("SELECT registration_id,idempotency,email_address,gc_username,phone_number,camping_type,number_people,arrive_date,leave_date,payment_type,status FROM camping;");
-            while (res->next()) {
+            MysqlQuery campingQuery(&jlwe, "SELECT registration_id,idempotency,email_address,gc_username,phone_number,camping_type,number_people,arrive_date,leave_date,payment_type,status FROM camping;");
+            res = campingQuery.execute();
+            while (campingQuery.next()) {
                 std::string userKey = res->getString(2);
                 bool saved = (res->getString(11) == "S");
                 bool isEventInc = (res->getString(10) == "event");
@@ -230,18 +226,14 @@ int main () {
                     }
                 }
             }
-            delete res;
-            delete stmt;
             std::cout << "</table>\n";
 
             // Totals
-            stmt = jlwe.getMysqlCon()->createStatement();
-            res = stmt->executeQuery("SELECT camping.camping_type,camping_options.display_name,COUNT(*),SUM(camping.number_people) FROM camping INNER JOIN camping_options ON camping.camping_type=camping_options.id_string WHERE status = 'S' GROUP BY camping.camping_type ORDER BY camping.camping_type;");
-            while (res->next()) {
+            MysqlQuery campingTotalQuery(&jlwe, "SELECT camping.camping_type,camping_options.display_name,COUNT(*),SUM(camping.number_people) FROM camping INNER JOIN camping_options ON camping.camping_type=camping_options.id_string WHERE status = 'S' GROUP BY camping.camping_type ORDER BY camping.camping_type;");
+            res = campingTotalQuery.execute();
+            while (campingTotalQuery.next()) {
                 std::cout << "<p>Total " << Encoder::htmlEntityEncode(res->getString(2)) << ": " << res->getInt(3) << " sites, " << res->getInt(4) << " people</p>\n";
             }
-            delete res;
-            delete stmt;
 
 
             for (unsigned int i = 0; i < dinner_forms.size(); i++) {
@@ -252,10 +244,9 @@ int main () {
 
                 int dinner_adult_count = 0;
                 int dinner_child_count = 0;
-                prep_stmt = jlwe.getMysqlCon()->prepareStatement("SELECT registration_id,idempotency,email_address,gc_username,phone_number,number_adults,number_children,payment_type,status FROM sat_dinner WHERE dinner_form_id = ?;");
-                prep_stmt->setInt(1, dinner_forms.at(i).dinner_id);
-                res = prep_stmt->executeQuery();
-                while (res->next()) {
+                MysqlQuery dinnerQuery(&jlwe, "SELECT registration_id,idempotency,email_address,gc_username,phone_number,number_adults,number_children,payment_type,status FROM sat_dinner WHERE dinner_form_id = ?;");
+                res = dinnerQuery.bind(dinner_forms.at(i).dinner_id).execute();
+                while (dinnerQuery.next()) {
                     std::string userKey = res->getString(2);
                     bool saved = (res->getString(9) == "S");
                     bool isEventInc = (res->getString(8) == "event");
@@ -312,8 +303,6 @@ int main () {
                     }
 
                 }
-                delete res;
-                delete prep_stmt;
                 std::cout << "<td colspan=\"3\" style=\"font-weight:bold;text-align:right;\">Total</td><td style=\"font-weight:bold;\">" << dinner_adult_count << "</td><td style=\"font-weight:bold;\">" << dinner_child_count << "</td>\n";
                 std::cout << "</table>\n";
             }
@@ -511,3 +500,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
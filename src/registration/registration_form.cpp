@@ -26,6 +26,10 @@
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
+#include "../core/SharedCache.h"
+
+#include "../ext/nlohmann/json.hpp"
 
 struct dinner_form {
     int dinner_id;
@@ -93,18 +97,30 @@ void outputEventTab(const std::string &event_registration_html, time_t camping_c
 }
 
 void outputCampingTab(const std::string &camping_registration_html, bool camping_only, time_t camping_cutoff, time_t time_now, int saturday_date, JlweCore * jlwe) {
+    // The options are shared with other processes, as every visitor to the form needs them
+    std::string cached;
+    nlohmann::json camping_json = nlohmann::json::array();
+    if (SharedCache::get("camping_options", 0, &cached)) {
+        camping_json = nlohmann::json::parse(cached);
+    } else {
+        sql::Statement *stmt = jlwe->getMysqlCon()->createStatement();
+        sql::ResultSet *res = stmt->executeQuery("SELECT id_string,display_name,display_comment FROM camping_options WHERE active != 0;");
+        while (res->next()){
+            std::string comment = "";
+            if (!res->isNull(3))
+                comment = res->getString(3);
+            camping_json.push_back({res->getString(1), res->getString(2), comment});
+        }
+        delete res;
+        delete stmt;
+        SharedCache::put("camping_options", 0, camping_json.dump());
+    }
+
     std::vector<FormElements::radiobutton> camping_options;
-    sql::Statement *stmt = jlwe->getMysqlCon()->createStatement();
-    sql::ResultSet *res = stmt->executeQuery("SELECT id_string,display_name,display_comment FROM camping_options WHERE active != 0;");
-    while (res->next()){
-        std::string id_string = res->getString(1);
-        std::string comment = "";
-        if (!res->isNull(3))
-            comment = res->getString(3);
-        camping_options.push_back({"camping_" + id_string, Encoder::htmlEntityEncode(res->getString(2)), id_string, "setRadioClass(this.name, '');", false, false, Encoder::htmlEntityEncode(comment)});
+    for (const nlohmann::json &option : camping_json) {
+        std::string id_string = option.at(0);
+        camping_options.push_back({"camping_" + id_string, Encoder::htmlEntityEncode(option.at(1)), id_string, "setRadioClass(this.name, '');", false, false, Encoder::htmlEntityEncode(option.at(2))});
     }
-    delete res;
-    delete stmt;
 
     std::cout << "<div class=\"formTab\" id=\"campingTab\">\n";
 
@@ -223,7 +239,7 @@ void outputSummaryTab(std::vector<dinner_form> * dinner_forms) {
     std::cout << "</div>\n";
 }
 
-int main () {
+static int handleRequest() {
     try {
         // work out if the user has requested the event, camping or dinner form
         std::string page_request = CgiEnvironment::getRequestUri();
@@ -280,13 +296,22 @@ int main () {
         // get list of dinner forms
         std::vector<dinner_form> dinner_forms;
         if (!camping_form_only) { // but don't bother if we only want camping
-            stmt = jlwe.getMysqlCon()->createStatement();
-            res = stmt->executeQuery("SELECT dinner_id,title,unix_timestamp(order_close_time),html_path FROM dinner_forms WHERE enabled > 0;");
-            while (res->next()) {
-                dinner_forms.push_back({res->getInt(1), res->getString(2), res->getInt64(3), res->getString(4)});
+            std::string cached;
+            nlohmann::json dinner_json = nlohmann::json::array();
+            if (SharedCache::get("dinner_forms", 0, &cached)) {
+                dinner_json = nlohmann::json::parse(cached);
+            } else {
+                stmt = jlwe.getMysqlCon()->createStatement();
+                res = stmt->executeQuery("SELECT dinner_id,title,unix_timestamp(order_close_time),html_path FROM dinner_forms WHERE enabled > 0;");
+                while (res->next()) {
+                    dinner_json.push_back({res->getInt(1), res->getString(2), res->getInt64(3), res->getString(4)});
+                }
+                delete res;
+                delete stmt;
+                SharedCache::put("dinner_forms", 0, dinner_json.dump());
             }
-            delete res;
-            delete stmt;
+            for (const nlohmann::json &form : dinner_json)
+                dinner_forms.push_back({form.at(0), form.at(1), form.at(2), form.at(3)});
         }
 
         bool dinner_form_enabled = (dinner_forms.size() > 0);
@@ -482,3 +507,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -20,12 +20,13 @@
 #include "../core/JsonUtils.h"
 #include "../core/PaymentUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 #include "../email/Email.h"
 #include "../email/JlweHtmlEmail.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -113,3 +114,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -24,6 +24,7 @@
 #include "../core/JsonUtils.h"
 #include "../core/KeyValueParser.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 #include "../email/Email.h"
 #include "../email/EmailTemplates.h"
 #include "../prices.h"
@@ -87,7 +88,7 @@ std::string make_stripe_line_item(int idx, std::string name, std::string descrip
     return line_item;
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
@@ -630,3 +631,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
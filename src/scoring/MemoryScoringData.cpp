@@ -0,0 +1,116 @@
+/**
+  @file    MemoryScoringData.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Holds the scoring data for PointCalculator in memory, instead of reading it from the database
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "MemoryScoringData.h"
+
+#include <algorithm>
+
+MemoryScoringData::MemoryScoringData() {
+    // do nothing
+}
+
+void MemoryScoringData::loadFixture(const nlohmann::json &fixture) {
+    for (const nlohmann::json &item : fixture.value("pointSources", nlohmann::json::array())) {
+        PointCalculator::CachePoints source;
+        source.id = item.at("id");
+        source.item_name = item.value("name", "");
+        source.hide_or_find = item.value("hide_or_find", "F");
+        // The config column is JSON text, it can be given as an object or as a string in the fixture
+        if (item.contains("config"))
+            source.configJson = item.at("config").is_string() ? item.at("config").get<std::string>() : item.at("config").dump();
+        this->addPointSource(source);
+    }
+
+    for (const nlohmann::json &item : fixture.value("extrasItems", nlohmann::json::array())) {
+        std::string type = item.value("type", "O");
+        this->addExtraItem({item.at("id"), item.value("short_name", ""), item.value("long_name", ""),
+                            item.value("single_find_only", false), (type.size() ? type.at(0) : 'O'), item.value("points_value", 0)});
+    }
+
+    for (const nlohmann::json &item : fixture.value("caches", nlohmann::json::array())) {
+        PointCalculator::Cache cache;
+        cache.cache_number = item.at("cache_number");
+        cache.team_id = item.value("team_id", 0);
+        cache.latitude = item.value("latitude", 0.0);
+        cache.longitude = item.value("longitude", 0.0);
+        cache.zone_points = item.value("zone_points", 0);
+        cache.walking_distance = item.value("walking_distance", 0);
+        cache.creative = item.value("creative", false);
+        cache.returned = item.value("returned", true);
+        cache.has_coordinates = item.value("has_coordinates", true);
+        cache.handout = item.value("handout", true);
+        cache.cache_name = item.value("cache_name", "");
+        this->addCache(cache);
+    }
+
+    for (const nlohmann::json &item : fixture.value("tradFinds", nlohmann::json::array()))
+        this->addTradFind(item.at("team_id"), item.at("cache_number"), item.value("value", 1));
+
+    for (const nlohmann::json &item : fixture.value("extrasFinds", nlohmann::json::array()))
+        this->addExtrasFind(item.at("team_id"), item.at("id"), item.value("value", 1));
+}
+
+void MemoryScoringData::addPointSource(const PointCalculator::CachePoints &source) {
+    this->point_sources.push_back(source);
+    this->point_sources.back().points_list.clear();
+}
+
+void MemoryScoringData::addExtraItem(const PointCalculator::ExtraItem &item) {
+    this->extras_items.push_back(item);
+}
+
+void MemoryScoringData::addCache(const PointCalculator::Cache &cache) {
+    this->caches.push_back(cache);
+    this->caches.back().total_hide_points = 0;
+    this->caches.back().total_find_points = 0;
+}
+
+void MemoryScoringData::addTradFind(int teamId, int cacheNumber, int value) {
+    this->trad_finds.push_back({teamId, cacheNumber, value});
+}
+
+void MemoryScoringData::addExtrasFind(int teamId, int extrasId, int value) {
+    this->extras_finds.push_back({teamId, extrasId, value});
+}
+
+std::vector<PointCalculator::CachePoints> MemoryScoringData::getPointSources() {
+    return this->point_sources;
+}
+
+std::vector<PointCalculator::ExtraItem> MemoryScoringData::getExtrasItems() {
+    return this->extras_items;
+}
+
+std::vector<PointCalculator::Cache> MemoryScoringData::getCaches(int /*number_game_caches*/) {
+    std::vector<PointCalculator::Cache> result = this->caches;
+
+    // Same order as the database query
+    std::stable_sort(result.begin(), result.end(), [](const PointCalculator::Cache &a, const PointCalculator::Cache &b) {
+        return a.cache_number < b.cache_number;
+    });
+    return result;
+}
+
+std::vector<ScoringData::TradFind> MemoryScoringData::getAllTradFinds() {
+    std::vector<TradFind> result = this->trad_finds;
+    std::stable_sort(result.begin(), result.end(), [](const TradFind &a, const TradFind &b) {
+        return a.team_id < b.team_id;
+    });
+    return result;
+}
+
+std::vector<PointCalculator::ExtrasFind> MemoryScoringData::getAllExtrasFinds() {
+    std::vector<PointCalculator::ExtrasFind> result = this->extras_finds;
+    std::stable_sort(result.begin(), result.end(), [](const PointCalculator::ExtrasFind &a, const PointCalculator::ExtrasFind &b) {
+        return a.team_id < b.team_id;
+    });
+    return result;
+}
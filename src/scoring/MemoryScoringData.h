@@ -0,0 +1,68 @@
+/**
+  @file    MemoryScoringData.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Holds the scoring data for PointCalculator in memory, instead of reading it from the database
+  The data is either added one item at a time or loaded from a JSON fixture, this is used to benchmark the
+  scoring code without a MySQL server
+
+  Fixture format (all keys are optional):
+    {
+      "pointSources": [{"id": 1, "name": "Find points", "hide_or_find": "F", "config": {...}}, ...],
+      "extrasItems": [{"id": 1, "short_name": "P1", "long_name": "Puzzle 1", "single_find_only": true, "type": "P", "points_value": 5}, ...],
+      "caches": [{"cache_number": 1, "team_id": 1, "latitude": -34.9, "longitude": 138.6, "zone_points": 0, "walking_distance": 0,
+                  "creative": false, "returned": true, "has_coordinates": true, "handout": true, "cache_name": ""}, ...],
+      "tradFinds": [{"team_id": 1, "cache_number": 1, "value": 1}, ...],
+      "extrasFinds": [{"team_id": 1, "id": 1, "value": 1}, ...]
+    }
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef MEMORYSCORINGDATA_H
+#define MEMORYSCORINGDATA_H
+
+#include "ScoringData.h"
+
+#include "../ext/nlohmann/json.hpp"
+
+class MemoryScoringData : public ScoringData {
+public:
+
+    /*!
+     * \brief MemoryScoringData Constructor, makes an empty data set.
+     */
+    MemoryScoringData();
+
+    /*!
+     * \brief Adds the items in a JSON fixture to the data set (see the format at the top of this file).
+     *
+     * \param fixture The fixture JSON
+     */
+    void loadFixture(const nlohmann::json &fixture);
+
+    void addPointSource(const PointCalculator::CachePoints &source);
+    void addExtraItem(const PointCalculator::ExtraItem &item);
+    void addCache(const PointCalculator::Cache &cache);
+    void addTradFind(int teamId, int cacheNumber, int value);
+    void addExtrasFind(int teamId, int extrasId, int value);
+
+    std::vector<PointCalculator::CachePoints> getPointSources() override;
+    std::vector<PointCalculator::ExtraItem> getExtrasItems() override;
+    std::vector<PointCalculator::Cache> getCaches(int number_game_caches) override;
+    std::vector<TradFind> getAllTradFinds() override;
+    std::vector<PointCalculator::ExtrasFind> getAllExtrasFinds() override;
+
+private:
+    std::vector<PointCalculator::CachePoints> point_sources;
+    std::vector<PointCalculator::ExtraItem> extras_items;
+    std::vector<PointCalculator::Cache> caches;
+
+    // Finds for every team, in the order they were added
+    std::vector<TradFind> trad_finds;
+    std::vector<PointCalculator::ExtrasFind> extras_finds;
+};
+
+#endif // MEMORYSCORINGDATA_H
@@ -0,0 +1,91 @@
+/**
+  @file    MysqlScoringData.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Loads the scoring data for PointCalculator from the MySQL database
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "MysqlScoringData.h"
+
+#include "../core/MysqlQuery.h"
+
+// Columns of game_find_points_trads and game_find_points_extras, in the order they are selected
+template <> struct MysqlRow<PointCalculator::CachePoints> {
+    static constexpr auto fields = std::make_tuple(&PointCalculator::CachePoints::id, &PointCalculator::CachePoints::item_name,
+                                                   &PointCalculator::CachePoints::hide_or_find, &PointCalculator::CachePoints::configJson);
+};
+
+template <> struct MysqlRow<PointCalculator::ExtraItem> {
+    static constexpr auto fields = std::make_tuple(&PointCalculator::ExtraItem::id, &PointCalculator::ExtraItem::item_name_short,
+                                                   &PointCalculator::ExtraItem::item_name_long, &PointCalculator::ExtraItem::single_find_only,
+                                                   &PointCalculator::ExtraItem::type, &PointCalculator::ExtraItem::points_value);
+};
+
+template <> struct MysqlRow<PointCalculator::ExtrasFind> {
+    static constexpr auto fields = std::make_tuple(&PointCalculator::ExtrasFind::team_id, &PointCalculator::ExtrasFind::id, &PointCalculator::ExtrasFind::value);
+};
+
+template <> struct MysqlRow<ScoringData::TradFind> {
+    static constexpr auto fields = std::make_tuple(&ScoringData::TradFind::team_id, &ScoringData::TradFind::cache_number, &ScoringData::TradFind::value);
+};
+
+MysqlScoringData::MysqlScoringData(JlweCore *jlwe) {
+    this->m_jlwe = jlwe;
+}
+
+std::vector<PointCalculator::CachePoints> MysqlScoringData::getPointSources() {
+    return MysqlQuery(this->m_jlwe, "SELECT id, name, hide_or_find, config FROM game_find_points_trads WHERE enabled != 0;").fetchAll<PointCalculator::CachePoints>();
+}
+
+std::vector<PointCalculator::ExtraItem> MysqlScoringData::getExtrasItems() {
+    return MysqlQuery(this->m_jlwe, "SELECT id, short_name, long_name, single_find_only, extras_type, point_value FROM game_find_points_extras WHERE enabled > 0;").fetchAll<PointCalculator::ExtraItem>();
+}
+
+std::vector<PointCalculator::Cache> MysqlScoringData::getCaches(int number_game_caches) {
+    std::vector<PointCalculator::Cache> caches;
+
+    MysqlQuery cacheQuery(this->m_jlwe, "SELECT cache_handout.cache_number, cache_handout.team_id, caches.cache_number, IF(cache_handout.owner_name = '', 0, 1), caches.zone_bonus, caches.osm_distance, caches.actual_distance, caches.camo, cache_handout.returned, caches.latitude, caches.longitude, caches.cache_name FROM caches RIGHT OUTER JOIN cache_handout ON caches.cache_number=cache_handout.cache_number ORDER BY cache_handout.cache_number;");
+    cacheQuery.setFetchSize(static_cast<size_t>(number_game_caches));
+    caches.reserve(static_cast<size_t>(number_game_caches));
+    while (cacheQuery.next()) {
+        sql::ResultSet *res = cacheQuery.result();
+        if (res->isNull(1) || res->isNull(2)) // This means cache is in GPX list but not handout table. This shouldn't happen.
+            continue;
+
+        PointCalculator::Cache c;
+        c.cache_number = res->getInt(1);
+        c.team_id = res->getInt(2);
+        c.has_coordinates = !(res->isNull(3));
+        c.handout = (res->getInt(4) > 0);
+        c.zone_points = res->isNull(5) ? 0 : res->getInt(5);
+        if (res->isNull(6) || res->isNull(7)) {
+            c.walking_distance = 0;
+        } else {
+            c.walking_distance = res->getInt(7);
+            if (c.walking_distance < 0)
+                c.walking_distance = res->getInt(6);
+        }
+        c.creative = (!res->isNull(8)) && (res->getInt(8) > 0);
+        c.returned = (!res->isNull(9)) && (res->getInt(9) > 0);
+        c.latitude = res->getDouble(10);
+        c.longitude = res->getDouble(11);
+        c.cache_name = res->getString(12);
+        c.total_hide_points = 0;
+        c.total_find_points = 0;
+        caches.push_back(c);
+    }
+
+    return caches;
+}
+
+std::vector<ScoringData::TradFind> MysqlScoringData::getAllTradFinds() {
+    return MysqlQuery(this->m_jlwe, "SELECT team_id,trad_cache_number,find_value FROM game_find_list WHERE trad_cache_number >= 0 ORDER BY team_id;").fetchAll<TradFind>();
+}
+
+std::vector<PointCalculator::ExtrasFind> MysqlScoringData::getAllExtrasFinds() {
+    return MysqlQuery(this->m_jlwe, "SELECT team_id,extras_id_number,find_value FROM game_find_list WHERE extras_id_number IS NOT NULL ORDER BY team_id;").fetchAll<PointCalculator::ExtrasFind>();
+}
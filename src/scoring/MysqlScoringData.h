@@ -0,0 +1,39 @@
+/**
+  @file    MysqlScoringData.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Loads the scoring data for PointCalculator from the MySQL database
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef MYSQLSCORINGDATA_H
+#define MYSQLSCORINGDATA_H
+
+#include "ScoringData.h"
+
+#include "../core/JlweCore.h"
+
+class MysqlScoringData : public ScoringData {
+public:
+
+    /*!
+     * \brief MysqlScoringData Constructor.
+     *
+     * \param jlwe JlweCore object (for mysql access)
+     */
+    MysqlScoringData(JlweCore *jlwe);
+
+    std::vector<PointCalculator::CachePoints> getPointSources() override;
+    std::vector<PointCalculator::ExtraItem> getExtrasItems() override;
+    std::vector<PointCalculator::Cache> getCaches(int number_game_caches) override;
+    std::vector<TradFind> getAllTradFinds() override;
+    std::vector<PointCalculator::ExtrasFind> getAllExtrasFinds() override;
+
+private:
+    JlweCore *m_jlwe;
+};
+
+#endif // MYSQLSCORINGDATA_H
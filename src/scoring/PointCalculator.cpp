@@ -12,68 +12,43 @@
 #include "PointCalculator.h"
 #include <algorithm>
 #include <stdexcept>
-#include <cmath>
+#include <cstdint>
 
-#include "../ext/nlohmann/json.hpp"
+#include "MysqlScoringData.h"
+#include "PointRules.h"
+#include "ScoringData.h"
 
-PointCalculator::PointCalculator(JlweCore *jlwe, int number_game_caches) {
+PointCalculator::PointCalculator(JlweCore *jlwe, int number_game_caches) :
+    m_owned_data(new MysqlScoringData(jlwe))
+{
+    this->loadData(this->m_owned_data.get(), number_game_caches);
+}
+
+PointCalculator::PointCalculator(ScoringData *data, int number_game_caches) {
+    this->loadData(data, number_game_caches);
+}
+
+void PointCalculator::loadData(ScoringData *data, int number_game_caches) {
     this->m_number_game_caches = number_game_caches;
-    this->m_jlwe = jlwe;
-
-    sql::Statement *stmt;
-    sql::ResultSet *res;
-    stmt = jlwe->getMysqlCon()->createStatement();
-    res = stmt->executeQuery("SELECT id, name, hide_or_find, config FROM game_find_points_trads WHERE enabled != 0;");
-    while (res->next()) {
-        this->trad_points.push_back({res->getInt(1), res->getString(2), res->getString(3), res->getString(4), {}});
-    }
-    delete res;
-    delete stmt;
-
-    stmt = jlwe->getMysqlCon()->createStatement();
-    res = stmt->executeQuery("SELECT id, short_name, long_name, single_find_only, extras_type, point_value FROM game_find_points_extras WHERE enabled > 0;");
-    while (res->next()) {
-        char type = res->getString(5)->size() ? res->getString(5)->at(0) : 'O';
-        this->extras_items.push_back({res->getInt(1), res->getString(2), res->getString(3), (res->getInt(4) != 0), type, res->getInt(6)});
-    }
-    delete res;
-    delete stmt;
+    this->m_data = data;
+    this->m_finds_loaded = false;
+    this->no_trad_finds.assign(static_cast<size_t>(number_game_caches), 0);
 
-    stmt = jlwe->getMysqlCon()->createStatement();
-    res = stmt->executeQuery("SELECT cache_handout.cache_number, cache_handout.team_id, caches.cache_number, IF(cache_handout.owner_name = '', 0, 1), caches.zone_bonus, caches.osm_distance, caches.actual_distance, caches.camo, cache_handout.returned, caches.latitude, caches.longitude, caches.cache_name FROM caches RIGHT OUTER JOIN cache_handout ON caches.cache_number=cache_handout.cache_number ORDER BY cache_handout.cache_number;");
-    while (res->next()) {
-        if (res->isNull(1) || res->isNull(2)) // This means cache is in GPX list but not handout table. This shouldn't happen.
-            continue;
+    this->trad_points = data->getPointSources();
 
-        Cache c;
-        c.cache_number = res->getInt(1);
-        c.team_id = res->getInt(2);
-        c.has_coordinates = !(res->isNull(3));
-        c.handout = (res->getInt(4) > 0);
-        c.zone_points = res->isNull(5) ? 0 : res->getInt(5);
-        if (res->isNull(6) || res->isNull(7)) {
-            c.walking_distance = 0;
-        } else {
-            c.walking_distance = res->getInt(7);
-            if (c.walking_distance < 0)
-                c.walking_distance = res->getInt(6);
-        }
-        c.creative = (!res->isNull(8)) && (res->getInt(8) > 0);
-        c.returned = (!res->isNull(9)) && (res->getInt(9) > 0);
-        c.latitude = res->getDouble(10);
-        c.longitude = res->getDouble(11);
-        c.cache_name = res->getString(12);
-        c.total_hide_points = 0;
-        c.total_find_points = 0;
-        this->caches.push_back(c);
+    this->extras_items = data->getExtrasItems();
+    for (ExtraItem &item : this->extras_items) {
+        if (item.type == '\0')
+            item.type = 'O';
     }
-    delete res;
-    delete stmt;
+
+    this->caches = data->getCaches(number_game_caches);
 
     if (static_cast<int>(this->caches.size()) !=  number_game_caches)
         throw std::runtime_error("number_game_caches (" + std::to_string(number_game_caches) + ") does not match size of cache list (" + std::to_string(this->caches.size()) + ")");
 
     this->calculatePointsForEachPointSource();
+    this->buildIndexes();
     this->calculateTotalHideFindPoints();
 }
 
@@ -95,9 +70,11 @@ std::vector<PointCalculator::ExtraItem> * PointCalculator::getExtrasItemsList()
 
 std::vector<PointCalculator::Cache> PointCalculator::getCachesForTeam(int teamId) {
     std::vector<Cache> list;
-    for (unsigned int j = 0; j < this->caches.size(); j++) {
-        if (this->caches.at(j).team_id == teamId)
-            list.push_back(this->caches.at(j));
+    auto it = this->team_caches.find(teamId);
+    if (it != this->team_caches.end()) {
+        list.reserve(it->second.size());
+        for (size_t j : it->second)
+            list.push_back(this->caches[j]);
     }
     return list;
 }
@@ -126,7 +103,7 @@ std::vector<PointCalculator::BestScoreHides> PointCalculator::getBestScoreHidesF
                 best_caches.push_back(team_caches.at(j).cache_number);
 
         for (unsigned int i = 0; i < this->trad_points.size(); i++) {
-            if (this->trad_points.at(i).hide_or_find == "H") {
+            if (this->source_types[i] == 'H') {
                 result.push_back({this->trad_points.at(i).id, best_caches});
             }
         }
@@ -134,7 +111,7 @@ std::vector<PointCalculator::BestScoreHides> PointCalculator::getBestScoreHidesF
     } else {
 
         for (unsigned int i = 0; i < this->trad_points.size(); i++) {
-            if (this->trad_points.at(i).hide_or_find == "H") {
+            if (this->source_types[i] == 'H') {
 
                 // make a list of the points for each cache
                 std::vector<singleValue> point_list;
@@ -188,68 +165,75 @@ int PointCalculator::getTeamHideScore(int teamId) {
 
 int PointCalculator::getCachesNotReturned(int teamId) {
     int result = 0;
-    for (unsigned int j = 0; j < this->caches.size(); j++) {
-        if (this->caches.at(j).team_id == teamId)
-            if (this->caches.at(j).returned == false)
+    auto it = this->team_caches.find(teamId);
+    if (it != this->team_caches.end()) {
+        for (size_t j : it->second)
+            if (this->caches[j].returned == false)
                 result++;
     }
     return result;
 }
 
-std::vector<int> PointCalculator::getTeamTradFindList(int teamId) {
-    std::vector<int> result(static_cast<size_t>(this->m_number_game_caches), 0);
-
-    sql::PreparedStatement *prep_stmt;
-    sql::ResultSet *res;
-    prep_stmt = this->m_jlwe->getMysqlCon()->prepareStatement("SELECT trad_cache_number,find_value FROM game_find_list WHERE trad_cache_number >= 0 AND team_id = ?;");
-    prep_stmt->setInt(1, teamId);
-    res = prep_stmt->executeQuery();
-    while (res->next()) {
-        int cache_number = res->getInt(1);
-        if (cache_number > 0 && cache_number <= this->m_number_game_caches)
-            result[cache_number - 1] = res->getInt(2);
+void PointCalculator::loadAllFinds() {
+    if (this->m_finds_loaded)
+        return;
+
+    // One query for each type of find, sorted by team so each row is filled in turn
+    for (const ScoringData::TradFind &find : this->m_data->getAllTradFinds()) {
+        if (find.cache_number > 0 && find.cache_number <= this->m_number_game_caches)
+            this->trad_find_rows[this->getTeamRow(find.team_id)][static_cast<size_t>(find.cache_number - 1)] = find.value;
     }
-    delete res;
-    delete prep_stmt;
+    for (const ExtrasFind &find : this->m_data->getAllExtrasFinds())
+        this->extras_find_rows[this->getTeamRow(find.team_id)].push_back(find);
 
-    return result;
+    this->m_finds_loaded = true;
+}
+
+size_t PointCalculator::getTeamRow(int teamId) {
+    auto it = this->team_rows.find(teamId);
+    if (it != this->team_rows.end())
+        return it->second;
+
+    size_t row = this->trad_find_rows.size();
+    this->team_rows[teamId] = row;
+    this->trad_find_rows.emplace_back(static_cast<size_t>(this->m_number_game_caches), 0);
+    this->extras_find_rows.emplace_back();
+    return row;
+}
+
+const std::vector<int> &PointCalculator::getTeamTradFindList(int teamId) {
+    this->loadAllFinds();
+    auto it = this->team_rows.find(teamId);
+    if (it == this->team_rows.end())
+        return this->no_trad_finds;
+    return this->trad_find_rows[it->second];
 }
 
 int PointCalculator::getTotalTradFindScore(const std::vector<int> &find_list) {
+    // Plain arrays and no branches, so the compiler can vectorise this
+    size_t count = std::min(find_list.size(), this->find_points_column.size());
+    const int *finds = find_list.data();
+    const int32_t *points = this->find_points_column.data();
     int total = 0;
-    for (unsigned int i = 0; i < find_list.size(); i++) {
-        if (find_list.at(i))
-            if (i < this->caches.size())
-                total += this->caches.at(i).total_find_points;
-    }
+    for (size_t i = 0; i < count; i++)
+        total += (finds[i] != 0) ? points[i] : 0;
     return total;
 }
 
-std::vector<PointCalculator::ExtrasFind> PointCalculator::getTeamExtrasFindList(int teamId) {
-    std::vector<ExtrasFind> result;
-
-    sql::PreparedStatement *prep_stmt;
-    sql::ResultSet *res;
-    prep_stmt = this->m_jlwe->getMysqlCon()->prepareStatement("SELECT team_id,extras_id_number,find_value FROM game_find_list WHERE extras_id_number IS NOT NULL AND team_id = ?;");
-    prep_stmt->setInt(1, teamId);
-    res = prep_stmt->executeQuery();
-    while (res->next()) {
-        result.push_back({res->getInt(1), res->getInt(2), res->getInt(3)});
-    }
-    delete res;
-    delete prep_stmt;
-
-    return result;
+const std::vector<PointCalculator::ExtrasFind> &PointCalculator::getTeamExtrasFindList(int teamId) {
+    this->loadAllFinds();
+    auto it = this->team_rows.find(teamId);
+    if (it == this->team_rows.end())
+        return this->no_extras_finds;
+    return this->extras_find_rows[it->second];
 }
 
 int PointCalculator::getTotalExtrasFindScore(const std::vector<PointCalculator::ExtrasFind> &find_list) {
     int total = 0;
-    for (unsigned int i = 0; i < this->extras_items.size(); i++) {
-        for (unsigned int j = 0; j < find_list.size(); j++) {
-            if (this->extras_items.at(i).id == find_list.at(j).id) {
-                total += (this->extras_items.at(i).points_value * find_list.at(j).value);
-            }
-        }
+    for (const ExtrasFind &find : find_list) {
+        auto it = this->extras_index.find(find.id);
+        if (it != this->extras_index.end())
+            total += this->extras_points_column[it->second] * find.value;
     }
     return total;
 }
@@ -262,143 +246,85 @@ int PointCalculator::getMinutesLate(const std::vector<PointCalculator::ExtrasFin
 }
 
 void PointCalculator::calculatePointsForEachPointSource() {
-
-    for (unsigned int i = 0; i < this->trad_points.size(); i++) {
-        this->trad_points.at(i).points_list.clear();
+    // The rules are only compiled again if a config has changed
+    std::vector<std::shared_ptr<const PointRule>> rules;
+    for (CachePoints &source : this->trad_points) {
+        rules.push_back(PointRuleRegistry::getRule(source.id, source.configJson));
         // default 0 points
-        for (unsigned int j = 0; j < this->caches.size(); j++)
-            this->trad_points.at(i).points_list.push_back(0);
-
-        nlohmann::json configJson;
-        if (trad_points.at(i).configJson.size())
-            configJson = nlohmann::json::parse(trad_points.at(i).configJson);
-
-        if (trad_points.at(i).id == 1) { // 1 point per cache
-            for (unsigned int j = 0; j < this->caches.size(); j++)
-                if (this->caches.at(j).has_coordinates) // only give points to caches in GPX file
-                    this->trad_points.at(i).points_list[j] = 1;
-
-            if (configJson.is_array()) {
-                for (nlohmann::json::iterator it = configJson.begin(); it != configJson.end(); ++it) {
-                    nlohmann::json jsonObject = *it;
-                    int cache_number = jsonObject["cache"];
-
-                    if (cache_number > 0 && cache_number <= this->trad_points.at(i).points_list.size())
-                        this->trad_points.at(i).points_list[cache_number - 1] = jsonObject["points"];
-                }
-            }
-
-        } else if (trad_points.at(i).id == 2) { // walking points
-
-            int distance_per_point = configJson["distance"];
-            int max_points = configJson["max_points"];
-
-            for (unsigned int j = 0; j < this->caches.size(); j++) {
-                int cache_number = this->caches.at(j).cache_number;
-
-                int walking_points = this->caches.at(j).walking_distance / distance_per_point;
-                if (walking_points > max_points)
-                    walking_points = max_points;
-
-                if (cache_number > 0 && cache_number <= this->trad_points.at(i).points_list.size())
-                    this->trad_points.at(i).points_list[cache_number - 1] = walking_points;
-            }
-
-        } else if (trad_points.at(i).id == 3) { // zone points
-            for (unsigned int j = 0; j < this->caches.size(); j++) {
-                int cache_number = this->caches.at(j).cache_number;
-
-                if (cache_number > 0 && cache_number <= this->trad_points.at(i).points_list.size())
-                    this->trad_points.at(i).points_list[cache_number - 1] = this->caches.at(j).zone_points;
-            }
-
-        } else if (trad_points.at(i).id == 4) { // creative points
-
-            int points = configJson["points"];
-
-            for (unsigned int j = 0; j < this->caches.size(); j++) {
-                int cache_number = this->caches.at(j).cache_number;
-
-                if (cache_number > 0 && cache_number <= this->trad_points.at(i).points_list.size())
-                    this->trad_points.at(i).points_list[cache_number - 1] = this->caches.at(j).creative ? points : 0;
-            }
-
-        } else if (trad_points.at(i).id == 5) { // cache spacing points
-
-            int distance_per_point = configJson["distance"];
-            int max_points = configJson["max_points"];
-
-            for (unsigned int j = 0; j < this->caches.size(); j++) {
-
-                // skip caches without coordinates
-                if (!this->caches.at(j).has_coordinates)
-                    continue;
-
-                int cache_number = this->caches.at(j).cache_number;
-                double shortest_distance = 1e9;
-
-                for (unsigned int k = 0; k < this->caches.size(); k++) {
-                    // skip caches without coordinates
-                    if (!this->caches.at(k).has_coordinates)
-                        continue;
-                    // skip comparing to the same cache
-                    if (j == k)
-                        continue;
-
-                    // if the caches are owned by the same team
-                    if (this->caches.at(j).team_id == this->caches.at(k).team_id) {
-
-                        // check the distance between them
-                        double distance = this->getDistanceBetweenCaches(this->caches.at(j), this->caches.at(k));
-                        if (distance < shortest_distance)
-                            shortest_distance = distance;
-                    }
-                }
-
-                int spacing_points = static_cast<int>(shortest_distance) / distance_per_point;
-                if (spacing_points > max_points)
-                    spacing_points = max_points;
-
-                if (cache_number > 0 && cache_number <= this->trad_points.at(i).points_list.size())
-                    this->trad_points.at(i).points_list[cache_number - 1] = spacing_points;
-
-            }
+        source.points_list.assign(this->caches.size(), 0);
+        rules.back()->prepare(this->caches, &source.points_list);
+    }
 
+    // One pass over the caches, working out the points from every rule
+    for (const Cache &cache : this->caches) {
+        if (cache.cache_number < 1 || cache.cache_number > static_cast<int>(this->caches.size()))
+            continue;
+        size_t index = static_cast<size_t>(cache.cache_number - 1);
+        for (size_t i = 0; i < rules.size(); i++) {
+            int &points = this->trad_points[i].points_list[index];
+            points = rules[i]->getPoints(cache, points);
         }
     }
 }
 
-void PointCalculator::calculateTotalHideFindPoints() {
-    for (unsigned int j = 0; j < this->caches.size(); j++) {
-        int cache_number = this->caches.at(j).cache_number;
-        int total_hide = 0;
-        int total_find = 0;
-
-        for (unsigned int i = 0; i < this->trad_points.size(); i++) {
-            if (this->trad_points.at(i).hide_or_find == "H") {
-                total_hide += this->trad_points.at(i).points_list.at(cache_number - 1);
-            }
-            if (this->trad_points.at(i).hide_or_find == "F") {
-                total_find += this->trad_points.at(i).points_list.at(cache_number - 1);
-            }
+void PointCalculator::buildIndexes() {
+    this->source_types.clear();
+    for (const CachePoints &source : this->trad_points) {
+        if (source.hide_or_find == "H") {
+            this->source_types.push_back('H');
+        } else if (source.hide_or_find == "F") {
+            this->source_types.push_back('F');
+        } else {
+            this->source_types.push_back('\0');
         }
+    }
 
-        this->caches[j].total_hide_points = total_hide;
-        this->caches[j].total_find_points = total_find;
+    this->extras_index.clear();
+    this->extras_points_column.clear();
+    for (size_t i = 0; i < this->extras_items.size(); i++) {
+        this->extras_index.insert({this->extras_items[i].id, i});
+        this->extras_points_column.push_back(this->extras_items[i].points_value);
     }
+
+    this->team_caches.clear();
+    for (size_t j = 0; j < this->caches.size(); j++)
+        this->team_caches[this->caches[j].team_id].push_back(j);
 }
 
-double PointCalculator::getDistanceBetweenCaches(const PointCalculator::Cache &c1, const PointCalculator::Cache &c2) {
-    const double earth_radius = 6371e3; // metres
-    double lat1_rad = c1.latitude * M_PI / 180;
-    double lat2_rad = c2.latitude * M_PI / 180;
-    double delta_lat = (c2.latitude - c1.latitude) * M_PI / 180;
-    double delta_lon = (c2.longitude - c1.longitude) * M_PI / 180;
+void PointCalculator::calculateTotalHideFindPoints() {
+    size_t count = this->caches.size();
+    this->hide_points_column.assign(count, 0);
+    this->find_points_column.assign(count, 0);
+
+    // Normally the caches are numbered 1 to count, so the points lists are in the same order as the caches
+    bool numbered_in_order = true;
+    for (size_t j = 0; j < count && numbered_in_order; j++)
+        numbered_in_order = (this->caches[j].cache_number == static_cast<int>(j) + 1);
+
+    // Add up one point source at a time, so each loop runs along two arrays
+    for (size_t i = 0; i < this->trad_points.size(); i++) {
+        int32_t *column;
+        if (this->source_types[i] == 'H') {
+            column = this->hide_points_column.data();
+        } else if (this->source_types[i] == 'F') {
+            column = this->find_points_column.data();
+        } else {
+            continue;
+        }
 
-    double a = sin(delta_lat/2) * sin(delta_lat/2) +
-              cos(lat1_rad) * cos(lat2_rad) *
-              sin(delta_lon/2) * sin(delta_lon/2);
-    double c = 2 * atan2(sqrt(a), sqrt(1-a));
+        const std::vector<int> &points_list = this->trad_points[i].points_list;
+        if (numbered_in_order && points_list.size() >= count) {
+            const int *points = points_list.data();
+            for (size_t j = 0; j < count; j++)
+                column[j] += points[j];
+        } else {
+            for (size_t j = 0; j < count; j++)
+                column[j] += points_list.at(static_cast<size_t>(this->caches[j].cache_number - 1));
+        }
+    }
 
-    return earth_radius * c; // in metres
+    for (size_t j = 0; j < count; j++) {
+        this->caches[j].total_hide_points = this->hide_points_column[j];
+        this->caches[j].total_find_points = this->find_points_column[j];
+    }
 }
@@ -12,11 +12,16 @@
 #ifndef POINTCALCULATOR_H
 #define POINTCALCULATOR_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "../core/JlweCore.h"
 
+class ScoringData;
+
 // Number of penalty points for each cache that isn't returned
 #define CACHE_RETURN_PENALTY   -2
 
@@ -106,6 +111,14 @@ public:
      */
     PointCalculator(JlweCore *jlwe, int number_game_caches);
 
+    /*!
+     * \brief PointCalculator Constructor.
+     *
+     * \param data Where to load the caches, point sources and finds from (not owned by the PointCalculator)
+     * \param number_game_caches The total number of caches in the game (from the website settings)
+     */
+    PointCalculator(ScoringData *data, int number_game_caches);
+
     /*!
      * \brief PointCalculator Destructor.
      */
@@ -176,13 +189,20 @@ public:
      */
     int getCachesNotReturned(int teamId);
 
+    /*!
+     * \brief Loads the finds of every team, so the team find lists don't need a query for each team
+     * This is done automatically the first time a team's finds are needed
+     */
+    void loadAllFinds();
+
     /*!
      * \brief Gets a list of traditional caches found by the given team
      *
      * \param teamId The id number of the team
      * \return A list of 100 numbers (one for each cache), where 1 = found, 0 = not found by the team
+     *         (the list belongs to the PointCalculator)
      */
-    std::vector<int> getTeamTradFindList(int teamId);
+    const std::vector<int> &getTeamTradFindList(int teamId);
 
     /*!
      * \brief Gets the total number of traditional find points for a given team
@@ -197,9 +217,9 @@ public:
      * \brief Gets a list of extras items found by the given team
      *
      * \param teamId The id number of the team
-     * \return The list of extras finds (as id number and value) found by the team
+     * \return The list of extras finds (as id number and value) found by the team (the list belongs to the PointCalculator)
      */
-    std::vector<ExtrasFind> getTeamExtrasFindList(int teamId);
+    const std::vector<ExtrasFind> &getTeamExtrasFindList(int teamId);
 
     /*!
      * \brief Gets the total number of find points on extras items for a given team
@@ -221,19 +241,44 @@ public:
 
 private:
     int m_number_game_caches;
-    JlweCore *m_jlwe;
+    ScoringData *m_data;
+    // Set when the PointCalculator made its own MysqlScoringData
+    std::unique_ptr<ScoringData> m_owned_data;
 
     std::vector<Cache> caches;
     std::vector<CachePoints> trad_points;
     std::vector<ExtraItem> extras_items;
 
-    // Initialize points_list for each ExtraItem
+    // 'H' or 'F' for each point source (the same order as trad_points), so the strings aren't compared in loops
+    std::vector<char> source_types;
+    // Total hide and find points of each cache, in the same order as caches
+    std::vector<int32_t> hide_points_column;
+    std::vector<int32_t> find_points_column;
+    // Position in extras_items of each extras item id, and the points for each item
+    std::unordered_map<int, size_t> extras_index;
+    std::vector<int32_t> extras_points_column;
+    // Positions in caches of the caches hidden by each team
+    std::unordered_map<int, std::vector<size_t>> team_caches;
+
+    // The finds of every team, one row per team (each trad row has a value for every cache)
+    bool m_finds_loaded;
+    std::unordered_map<int, size_t> team_rows;
+    std::vector<std::vector<int>> trad_find_rows;
+    std::vector<std::vector<ExtrasFind>> extras_find_rows;
+    // Returned for teams that haven't found anything
+    std::vector<int> no_trad_finds;
+    std::vector<ExtrasFind> no_extras_finds;
+
+    // Loads the caches and point sources, then works out the points for each cache
+    void loadData(ScoringData *data, int number_game_caches);
+    // Initialize points_list for each point source, using the rules from PointRuleRegistry
     void calculatePointsForEachPointSource();
-    // Initialize total_hide_points and total_find_points for each Cache
+    // Initialize source_types, extras_index, extras_points_column and team_caches
+    void buildIndexes();
+    // Initialize the hide/find points columns, and total_hide_points and total_find_points for each Cache
     void calculateTotalHideFindPoints();
-
-    // Calculate the straight line distance (in metres) between two caches
-    double getDistanceBetweenCaches(const Cache &c1, const Cache &c2);
+    // Gets the row number of a team in the find lists, adding an empty row if it doesn't have one
+    size_t getTeamRow(int teamId);
 };
 
 #endif // POINTCALCULATOR_H
@@ -0,0 +1,251 @@
+/**
+  @file    PointRules.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  The rules that give points to the trad caches, one for each type of point source (find points, walking points, etc.)
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "PointRules.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+// 1 point for each cache in the GPX file, unless the config sets the points for a cache
+// Config: [{"cache": 12, "points": 3}, ...]
+class CacheOverridePointRule : public PointRule {
+public:
+    CacheOverridePointRule(const nlohmann::json &config) {
+        if (config.is_array()) {
+            for (const nlohmann::json &item : config) {
+                int cache_number = item.at("cache");
+                this->overrides[cache_number] = item.at("points");
+            }
+        }
+    }
+
+    int getPoints(const PointCalculator::Cache &cache, int prepared_points) const override {
+        (void)prepared_points;
+        auto it = this->overrides.find(cache.cache_number);
+        if (it != this->overrides.end())
+            return it->second;
+        return cache.has_coordinates ? 1 : 0;
+    }
+
+private:
+    std::unordered_map<int, int> overrides;
+};
+
+// 1 point for every "distance" metres walked to the cache, up to "max_points"
+// Config: {"distance": 100, "max_points": 5}
+class WalkingPointRule : public PointRule {
+public:
+    WalkingPointRule(const nlohmann::json &config) {
+        this->distance_per_point = config.at("distance");
+        this->max_points = config.at("max_points");
+    }
+
+    int getPoints(const PointCalculator::Cache &cache, int prepared_points) const override {
+        (void)prepared_points;
+        if (this->distance_per_point <= 0)
+            return 0;
+        return std::min(cache.walking_distance / this->distance_per_point, this->max_points);
+    }
+
+private:
+    int distance_per_point;
+    int max_points;
+};
+
+// The zone points set for each cache (from the zone it is in)
+class ZonePointRule : public PointRule {
+public:
+    int getPoints(const PointCalculator::Cache &cache, int prepared_points) const override {
+        (void)prepared_points;
+        return cache.zone_points;
+    }
+};
+
+// A fixed number of points for each creative cache
+// Config: {"points": 2}
+class CreativePointRule : public PointRule {
+public:
+    CreativePointRule(const nlohmann::json &config) {
+        this->points = config.at("points");
+    }
+
+    int getPoints(const PointCalculator::Cache &cache, int prepared_points) const override {
+        (void)prepared_points;
+        return cache.creative ? this->points : 0;
+    }
+
+private:
+    int points;
+};
+
+// 1 point for every "distance" metres to the nearest cache hidden by the same team, up to "max_points"
+// Config: {"distance": 200, "max_points": 5}
+class SpacingPointRule : public PointRule {
+public:
+    SpacingPointRule(const nlohmann::json &config) {
+        this->distance_per_point = config.at("distance");
+        this->max_points = config.at("max_points");
+    }
+
+    void prepare(const std::vector<PointCalculator::Cache> &caches, std::vector<int> *points_list) const override;
+
+    int getPoints(const PointCalculator::Cache &cache, int prepared_points) const override {
+        (void)cache;
+        return prepared_points;
+    }
+
+private:
+    int distance_per_point;
+    int max_points;
+
+    // Calculate the straight line distance (in metres) between two positions, in radians
+    static double getDistanceBetweenPositions(double lat1_rad, double lon1_rad, double cos_lat1, double lat2_rad, double lon2_rad, double cos_lat2);
+};
+
+void SpacingPointRule::prepare(const std::vector<PointCalculator::Cache> &caches, std::vector<int> *points_list) const {
+    if (this->distance_per_point <= 0)
+        return;
+
+    // Caches further than this from their nearest neighbour all get max_points,
+    // so only neighbours closer than this need to be found
+    double search_distance = static_cast<double>(this->max_points) * this->distance_per_point;
+
+    // Work out the radians and cos(latitude) once for each cache
+    struct CachePosition {
+        size_t index;
+        double lat_rad;
+        double lon_rad;
+        double cos_lat;
+    };
+    std::vector<CachePosition> positions;
+    double min_cos_lat = 1;
+    for (size_t j = 0; j < caches.size(); j++) {
+        if (!caches.at(j).has_coordinates)
+            continue;
+        double lat_rad = caches.at(j).latitude * M_PI / 180;
+        positions.push_back({j, lat_rad, caches.at(j).longitude * M_PI / 180, cos(lat_rad)});
+        min_cos_lat = std::min(min_cos_lat, positions.back().cos_lat);
+    }
+
+    // Put the caches in a grid of squares (at least search_distance wide), separately for each team,
+    // then the nearest neighbour is either in the same square or one next to it.
+    // Longitude is scaled by the smallest cos(latitude), so the squares are never narrower than search_distance
+    const double earth_radius = 6371e3; // metres
+    bool use_grid = (search_distance > 0 && min_cos_lat > 0.01);
+    double lat_cell_size = search_distance * 1.01 / earth_radius;
+    double lon_cell_size = lat_cell_size / std::max(min_cos_lat, 0.01);
+    // Two squares with the same key only means some extra caches get checked
+    auto cellKey = [](int team_id, long long x, long long y) {
+        return (static_cast<uint64_t>(team_id) * 0x9E3779B97F4A7C15ULL) ^ (static_cast<uint64_t>(x) * 0xC2B2AE3D27D4EB4FULL) ^ (static_cast<uint64_t>(y) * 0x165667B19E3779F9ULL);
+    };
+    std::unordered_map<uint64_t, std::vector<size_t>> grid;
+    if (use_grid) {
+        for (size_t p = 0; p < positions.size(); p++) {
+            long long x = static_cast<long long>(floor(positions[p].lon_rad / lon_cell_size));
+            long long y = static_cast<long long>(floor(positions[p].lat_rad / lat_cell_size));
+            grid[cellKey(caches.at(positions[p].index).team_id, x, y)].push_back(p);
+        }
+    }
+
+    for (size_t p = 0; p < positions.size(); p++) {
+        const CachePosition &c1 = positions[p];
+        int team_id = caches.at(c1.index).team_id;
+        double shortest_distance = 1e9;
+
+        auto checkNeighbour = [&](size_t q) {
+            const CachePosition &c2 = positions[q];
+            if (q == p || caches.at(c2.index).team_id != team_id)
+                return;
+            double distance = getDistanceBetweenPositions(c1.lat_rad, c1.lon_rad, c1.cos_lat, c2.lat_rad, c2.lon_rad, c2.cos_lat);
+            if (distance < shortest_distance)
+                shortest_distance = distance;
+        };
+
+        if (use_grid) {
+            long long x = static_cast<long long>(floor(c1.lon_rad / lon_cell_size));
+            long long y = static_cast<long long>(floor(c1.lat_rad / lat_cell_size));
+            for (long long dx = -1; dx <= 1; dx++) {
+                for (long long dy = -1; dy <= 1; dy++) {
+                    auto it = grid.find(cellKey(team_id, x + dx, y + dy));
+                    if (it != grid.end())
+                        for (size_t q : it->second)
+                            checkNeighbour(q);
+                }
+            }
+        } else {
+            // Every cache gets max_points (or the caches are near the poles), so compare with all of them
+            for (size_t q = 0; q < positions.size(); q++)
+                checkNeighbour(q);
+        }
+
+        int spacing_points = static_cast<int>(shortest_distance) / this->distance_per_point;
+        if (spacing_points > this->max_points)
+            spacing_points = this->max_points;
+
+        int cache_number = caches.at(c1.index).cache_number;
+        if (cache_number > 0 && cache_number <= static_cast<int>(points_list->size()))
+            (*points_list)[static_cast<size_t>(cache_number - 1)] = spacing_points;
+    }
+}
+
+double SpacingPointRule::getDistanceBetweenPositions(double lat1_rad, double lon1_rad, double cos_lat1, double lat2_rad, double lon2_rad, double cos_lat2) {
+    const double earth_radius = 6371e3; // metres
+    double sin_half_delta_lat = sin((lat2_rad - lat1_rad) / 2);
+    double sin_half_delta_lon = sin((lon2_rad - lon1_rad) / 2);
+
+    double a = sin_half_delta_lat * sin_half_delta_lat +
+              cos_lat1 * cos_lat2 * sin_half_delta_lon * sin_half_delta_lon;
+    double c = 2 * atan2(sqrt(a), sqrt(1-a));
+
+    return earth_radius * c; // in metres
+}
+
+std::unordered_map<int, PointRuleRegistry::Factory> &PointRuleRegistry::getFactories() {
+    static std::unordered_map<int, Factory> factories = {
+        {1, [](const nlohmann::json &config) { return std::make_shared<CacheOverridePointRule>(config); }},
+        {2, [](const nlohmann::json &config) { return std::make_shared<WalkingPointRule>(config); }},
+        {3, [](const nlohmann::json &) { return std::make_shared<ZonePointRule>(); }},
+        {4, [](const nlohmann::json &config) { return std::make_shared<CreativePointRule>(config); }},
+        {5, [](const nlohmann::json &config) { return std::make_shared<SpacingPointRule>(config); }}
+    };
+    return factories;
+}
+
+std::unordered_map<int, PointRuleRegistry::CompiledRule> &PointRuleRegistry::getCompiledRules() {
+    static std::unordered_map<int, CompiledRule> compiledRules;
+    return compiledRules;
+}
+
+void PointRuleRegistry::registerType(int id, Factory factory) {
+    getFactories()[id] = factory;
+    getCompiledRules().erase(id);
+}
+
+std::shared_ptr<const PointRule> PointRuleRegistry::getRule(int id, const std::string &configJson) {
+    // The same config always makes the same rule, so there is nothing to do unless it has changed
+    auto compiled = getCompiledRules().find(id);
+    if (compiled != getCompiledRules().end() && compiled->second.configJson == configJson)
+        return compiled->second.rule;
+
+    auto factory = getFactories().find(id);
+    if (factory == getFactories().end())
+        throw std::runtime_error("Unknown type of point source (id = " + std::to_string(id) + ")");
+
+    nlohmann::json config;
+    if (configJson.size())
+        config = nlohmann::json::parse(configJson);
+
+    std::shared_ptr<const PointRule> rule = factory->second(config);
+    getCompiledRules()[id] = {configJson, rule};
+    return rule;
+}
@@ -0,0 +1,93 @@
+/**
+  @file    PointRules.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  The rules that give points to the trad caches, one for each type of point source (find points, walking points, etc.)
+  Each point source is compiled into a PointRule from its config JSON, and the compiled rules are kept so the JSON
+  is only parsed again when the config changes. New types of point source are added with PointRuleRegistry::registerType()
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef POINTRULES_H
+#define POINTRULES_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PointCalculator.h"
+
+#include "../ext/nlohmann/json.hpp"
+
+class PointRule {
+public:
+
+    virtual ~PointRule() {}
+
+    /*!
+     * \brief Works out points that depend on more than one cache, before the points of each cache are found.
+     * eg. The spacing points need the distance to the other caches of the same team
+     *
+     * \param caches The list of all the caches
+     * \param points_list The points for each cache (by cache number), all 0 to start with
+     */
+    virtual void prepare(const std::vector<PointCalculator::Cache> &caches, std::vector<int> *points_list) const {
+        (void)caches;
+        (void)points_list;
+    }
+
+    /*!
+     * \brief Gets the points for a single cache.
+     *
+     * \param cache The cache
+     * \param prepared_points The points for the cache set by prepare(), or 0
+     * \return The points for the cache
+     */
+    virtual int getPoints(const PointCalculator::Cache &cache, int prepared_points) const = 0;
+};
+
+class PointRuleRegistry {
+public:
+
+    // Makes a rule from the config JSON of a point source (which is null if the source has no config)
+    typedef std::function<std::shared_ptr<const PointRule>(const nlohmann::json &config)> Factory;
+
+    /*!
+     * \brief Adds a new type of point source, or replaces an existing one.
+     *
+     * \param id The id of the point source (in the game_find_points_trads table)
+     * \param factory Makes the rule from the config of the point source
+     */
+    static void registerType(int id, Factory factory);
+
+    /*!
+     * \brief Gets the compiled rule for a point source.
+     *
+     * The rule is only compiled the first time, or if the config has changed since then.
+     *
+     * \param id The id of the point source
+     * \param configJson The config of the point source as JSON text, may be empty
+     * \return The rule for the point source
+     */
+    static std::shared_ptr<const PointRule> getRule(int id, const std::string &configJson);
+
+private:
+
+    struct CompiledRule {
+        std::string configJson;
+        std::shared_ptr<const PointRule> rule;
+    };
+
+    // The factory for each type of point source, starting with the built in ones (1 to 5)
+    static std::unordered_map<int, Factory> &getFactories();
+
+    // The last rule compiled for each point source
+    static std::unordered_map<int, CompiledRule> &getCompiledRules();
+};
+
+#endif // POINTRULES_H
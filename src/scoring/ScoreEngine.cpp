@@ -0,0 +1,133 @@
+/**
+  @file    ScoreEngine.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Keeps the hide, find, extras and penalty totals of every team saved in the game_team_scores table
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include "ScoreEngine.h"
+
+#include "PointCalculator.h"
+
+#include "../core/MysqlQuery.h"
+
+#include "../ext/nlohmann/json.hpp"
+
+// Number of times to try saving the recalculated totals, if finds are being entered at the same time
+#define SAVE_TOTALS_ATTEMPTS 3
+
+// Columns of the totals query, in the order they are selected
+template <> struct MysqlRow<ScoreEngine::TeamTotals> {
+    static constexpr auto fields = std::make_tuple(&ScoreEngine::TeamTotals::team_id, &ScoreEngine::TeamTotals::hide_points,
+                                                   &ScoreEngine::TeamTotals::find_points, &ScoreEngine::TeamTotals::extras_points,
+                                                   &ScoreEngine::TeamTotals::penalty_points, &ScoreEngine::TeamTotals::trad_find_count,
+                                                   &ScoreEngine::TeamTotals::puzzle_find_count);
+};
+
+ScoreEngine::Versions ScoreEngine::readVersions(JlweCore *jlwe) {
+    Versions versions = {0, 0, 0, 0, 0, false};
+    MysqlQuery query(jlwe, "SELECT name, version FROM data_versions WHERE name IN ('scoring_rules', 'scoring_finds', 'vars', 'scoring_totals', 'scoring_totals_vars');");
+    while (query.next()) {
+        std::string name = query.result()->getString(1);
+        unsigned long long version = query.result()->getUInt64(2);
+        if (name == "scoring_rules") {
+            versions.rules = version;
+        } else if (name == "scoring_finds") {
+            versions.finds = version;
+        } else if (name == "vars") {
+            versions.vars = version;
+        } else if (name == "scoring_totals") {
+            versions.totals = version;
+            versions.hasTotals = true;
+        } else if (name == "scoring_totals_vars") {
+            versions.totalsVars = version;
+        }
+    }
+    return versions;
+}
+
+std::vector<ScoreEngine::TeamTotals> ScoreEngine::getTeamTotals(JlweCore *jlwe, int number_game_caches) {
+    // number_game_caches is a website setting, so the totals are also out of date if the settings have changed
+    Versions versions = readVersions(jlwe);
+    if (!versions.hasTotals || versions.totals != versions.rules || versions.totalsVars != versions.vars)
+        return recalculate(jlwe, number_game_caches);
+
+    MysqlQuery query(jlwe, "SELECT game_teams.team_id, IFNULL(game_team_scores.hide_points, 0), IFNULL(game_team_scores.find_points, 0), "
+                           "IFNULL(game_team_scores.extras_points, 0), IFNULL(game_team_scores.penalty_points, 0), "
+                           "(SELECT COUNT(*) FROM game_find_list WHERE game_find_list.team_id = game_teams.team_id AND trad_cache_number BETWEEN 1 AND ? AND find_value != 0), "
+                           "(SELECT COUNT(*) FROM game_find_list INNER JOIN game_find_points_extras ON game_find_points_extras.id = game_find_list.extras_id_number "
+                           "WHERE game_find_list.team_id = game_teams.team_id AND game_find_points_extras.enabled > 0 AND game_find_points_extras.extras_type = 'P' AND find_value != 0) "
+                           "FROM game_teams LEFT JOIN game_team_scores ON game_team_scores.team_id = game_teams.team_id ORDER BY game_teams.team_id;");
+    query.bind(number_game_caches);
+    return query.fetchAll<TeamTotals>();
+}
+
+std::vector<ScoreEngine::TeamTotals> ScoreEngine::calculateTeamTotals(PointCalculator *pointCalculator, const std::vector<int> &teamIds) {
+    std::vector<PointCalculator::ExtraItem> *extras_items = pointCalculator->getExtrasItemsList();
+
+    std::vector<TeamTotals> result;
+    result.reserve(teamIds.size());
+    for (int team_id : teamIds) {
+        const std::vector<int> &trad_finds = pointCalculator->getTeamTradFindList(team_id);
+        const std::vector<PointCalculator::ExtrasFind> &extra_finds = pointCalculator->getTeamExtrasFindList(team_id);
+
+        TeamTotals totals;
+        totals.team_id = team_id;
+        totals.hide_points = pointCalculator->getTeamHideScore(team_id);
+        totals.find_points = pointCalculator->getTotalTradFindScore(trad_finds);
+        totals.extras_points = pointCalculator->getTotalExtrasFindScore(extra_finds);
+        totals.penalty_points = (pointCalculator->getCachesNotReturned(team_id) * CACHE_RETURN_PENALTY) + (PointCalculator::getMinutesLate(extra_finds) * MINUTES_LATE_PENALTY);
+
+        totals.trad_find_count = 0;
+        for (int value : trad_finds)
+            if (value)
+                totals.trad_find_count++;
+
+        totals.puzzle_find_count = 0;
+        for (const PointCalculator::ExtraItem &item : *extras_items) {
+            if (item.type == 'P') {
+                for (const PointCalculator::ExtrasFind &find : extra_finds)
+                    if (find.id == item.id && find.value)
+                        totals.puzzle_find_count++;
+            }
+        }
+
+        result.push_back(totals);
+    }
+    return result;
+}
+
+std::vector<ScoreEngine::TeamTotals> ScoreEngine::recalculate(JlweCore *jlwe, int number_game_caches) {
+    std::vector<TeamTotals> totals;
+    for (int attempt = 0; attempt < SAVE_TOTALS_ATTEMPTS; attempt++) {
+        // Read the versions first, so anything changed while calculating stops the totals being marked as up to date
+        Versions versions = readVersions(jlwe);
+
+        PointCalculator pointCalculator(jlwe, number_game_caches);
+        std::vector<int> teamIds;
+        MysqlQuery teamQuery(jlwe, "SELECT team_id FROM game_teams ORDER BY team_id;");
+        while (teamQuery.next())
+            teamIds.push_back(teamQuery.result()->getInt(1));
+        totals = calculateTeamTotals(&pointCalculator, teamIds);
+
+        nlohmann::json teamsJson = nlohmann::json::array();
+        for (const TeamTotals &team : totals)
+            teamsJson.push_back({team.team_id, team.hide_points, team.find_points, team.extras_points, team.penalty_points});
+
+        nlohmann::json cachesJson = nlohmann::json::array();
+        for (const PointCalculator::Cache &cache : *pointCalculator.getCacheList())
+            cachesJson.push_back({cache.cache_number, cache.total_hide_points, cache.total_find_points});
+
+        MysqlQuery query(jlwe, "SELECT setScoreTotals(?,?,?,?,?);");
+        query.bind(versions.rules, versions.vars, versions.finds, teamsJson.dump(), cachesJson.dump());
+        if (query.fetchValue<int>(1) == 0)
+            break;
+    }
+
+    // If the totals still couldn't be saved, the next request will try again
+    return totals;
+}
@@ -0,0 +1,86 @@
+/**
+  @file    ScoreEngine.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Keeps the hide, find, extras and penalty totals of every team saved in the game_team_scores table
+  The SQL functions that record finds and returned caches add the change to the totals themselves, using the find
+  points of each cache saved in game_cache_points. The totals are only recalculated (with PointCalculator) when the
+  point rules, caches or teams change, which is recorded as the scoring_rules version in the data_versions table
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef SCOREENGINE_H
+#define SCOREENGINE_H
+
+#include <string>
+#include <vector>
+
+#include "../core/JlweCore.h"
+
+class PointCalculator;
+
+class ScoreEngine {
+public:
+
+    /*! \struct TeamTotals
+     *  \brief Stores the points of a single team
+     */
+    struct TeamTotals {
+        int team_id;
+        int hide_points;
+        int find_points;
+        int extras_points;
+        int penalty_points;
+
+        // Number of trad caches and puzzles the team has found
+        int trad_find_count;
+        int puzzle_find_count;
+
+        int getTotal() const {
+            return this->hide_points + this->find_points + this->extras_points + this->penalty_points;
+        }
+    };
+
+    /*!
+     * \brief Gets the totals for every team in game_teams, in one query if the saved totals are up to date.
+     *
+     * If the point rules have changed since the totals were saved, they are recalculated and saved again first.
+     *
+     * \param jlwe JlweCore object (for mysql access)
+     * \param number_game_caches The total number of caches in the game (from the website settings)
+     * \return The totals, in the order of team_id
+     */
+    static std::vector<TeamTotals> getTeamTotals(JlweCore *jlwe, int number_game_caches);
+
+    /*!
+     * \brief Works out the totals for the given teams.
+     *
+     * \param pointCalculator The PointCalculator with the current caches and finds
+     * \param teamIds The teams to get the totals of
+     * \return The totals, in the same order as teamIds
+     */
+    static std::vector<TeamTotals> calculateTeamTotals(PointCalculator *pointCalculator, const std::vector<int> &teamIds);
+
+private:
+
+    // Versions from the data_versions table that the saved totals depend on
+    struct Versions {
+        unsigned long long rules;
+        unsigned long long finds;
+        unsigned long long vars;
+        unsigned long long totals;
+        unsigned long long totalsVars;
+        bool hasTotals;
+    };
+
+    // Reads all the versions in one query (JlweCore::getDataVersion() only has them in persistent workers)
+    static Versions readVersions(JlweCore *jlwe);
+
+    // Recalculates the totals and tries to save them, returns the new totals even if they couldn't be saved
+    static std::vector<TeamTotals> recalculate(JlweCore *jlwe, int number_game_caches);
+};
+
+#endif // SCOREENGINE_H
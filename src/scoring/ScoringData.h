@@ -0,0 +1,74 @@
+/**
+  @file    ScoringData.h
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Interface for loading the data that PointCalculator needs (caches, point sources, extras items and team finds)
+  MysqlScoringData reads it from the database, MemoryScoringData holds it in memory (for benchmarks)
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#ifndef SCORINGDATA_H
+#define SCORINGDATA_H
+
+#include <vector>
+
+#include "PointCalculator.h"
+
+class ScoringData {
+public:
+
+    /*! \struct TradFind
+     *  \brief Stores a single find on a traditional cache by a team
+     */
+    struct TradFind {
+        int team_id;
+        int cache_number;
+        int value;
+    };
+
+    virtual ~ScoringData() {}
+
+    /*!
+     * \brief Gets the enabled sources of points for the traditional caches
+     * The points_list of each item is left empty, PointCalculator fills it in
+     *
+     * \return The list of point sources
+     */
+    virtual std::vector<PointCalculator::CachePoints> getPointSources() = 0;
+
+    /*!
+     * \brief Gets the enabled extras items
+     *
+     * \return The list of items
+     */
+    virtual std::vector<PointCalculator::ExtraItem> getExtrasItems() = 0;
+
+    /*!
+     * \brief Gets the list of caches in the game, sorted by cache number
+     * The total_hide_points and total_find_points are left as 0, PointCalculator fills them in
+     *
+     * \param number_game_caches The total number of caches in the game (used to size the list)
+     * \return The list of caches
+     */
+    virtual std::vector<PointCalculator::Cache> getCaches(int number_game_caches) = 0;
+
+    /*!
+     * \brief Gets the finds on traditional caches for every team, sorted by team id
+     *
+     * \return The list of finds
+     */
+    virtual std::vector<TradFind> getAllTradFinds() = 0;
+
+    /*!
+     * \brief Gets the finds on extras items for every team, sorted by team id
+     *
+     * \return The list of finds
+     */
+    virtual std::vector<PointCalculator::ExtrasFind> getAllExtrasFinds() = 0;
+
+};
+
+#endif // SCORINGDATA_H
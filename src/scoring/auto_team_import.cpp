@@ -22,6 +22,7 @@
 #include "../core/JlweUtils.h"
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
@@ -43,7 +44,7 @@ int findTeamID(const std::string &name, std::vector<team> *teamList) {
     return -1;
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -184,3 +185,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
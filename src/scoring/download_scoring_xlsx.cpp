@@ -18,11 +18,12 @@
 
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
+#include "../core/RequestLoop.h"
 
 #include "WriteScoringXLSX.h"
 #include "PointCalculator.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -57,8 +58,8 @@ int main () {
             res = stmt->executeQuery("SELECT team_id, team_name FROM game_teams WHERE competing = 1 ORDER BY team_name;");
             while (res->next()) {
                 int team_id = res->getInt(1);
-                std::vector<int> trad_finds = point_calculator.getTeamTradFindList(team_id);
-                std::vector<PointCalculator::ExtrasFind> extra_finds = point_calculator.getTeamExtrasFindList(team_id);
+                const std::vector<int> &trad_finds = point_calculator.getTeamTradFindList(team_id);
+                const std::vector<PointCalculator::ExtrasFind> &extra_finds = point_calculator.getTeamExtrasFindList(team_id);
                 int hide_score = point_calculator.getTeamHideScore(team_id);
                 int caches_not_returned = point_calculator.getCachesNotReturned(team_id);
                 int late = point_calculator.getMinutesLate(extra_finds);
@@ -128,3 +129,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -19,10 +19,11 @@
 #include "../core/KeyValueParser.h"
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -113,3 +114,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -17,6 +17,7 @@
 
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
@@ -35,7 +36,7 @@ struct Team {
     bool correct_final_score;
 };
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -175,3 +176,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -19,18 +19,22 @@
 #include "../core/KeyValueParser.h"
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
+#include "../core/MysqlQuery.h"
+#include "../core/RequestLoop.h"
+#include "../core/Response.h"
 
 #include "../ext/nlohmann/json.hpp"
 
 #include "PointCalculator.h"
 
-int main () {
+static int handleRequest() {
     try {
+        Response response;
+        response.startPhase("config");
         JlweCore jlwe;
 
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
 
-        sql::Statement *stmt;
         sql::ResultSet *res;
 
         if (jlwe.getPermissionValue("perm_pptbuilder")) { //if logged in
@@ -45,6 +49,7 @@ int main () {
             if (number_game_caches < 1)
                 throw std::invalid_argument("Invalid setting for number_game_caches = " + std::to_string(number_game_caches));
 
+            response.startPhase("db");
             PointCalculator point_calculator(&jlwe, number_game_caches);
 
             std::vector<bool> caches_allocated(static_cast<size_t>(number_game_caches), false);
@@ -77,9 +82,9 @@ int main () {
             }
 
             jsonDocument["teams"] = nlohmann::json::array();
-            stmt = jlwe.getMysqlCon()->createStatement();
-            res = stmt->executeQuery("SELECT team_id, team_name, team_members, competing, final_score FROM game_teams" + std::string(include_non_compete ? ";" : " WHERE competing = 1;"));
-            while (res->next()) {
+            MysqlQuery teamQuery(&jlwe, "SELECT team_id, team_name, team_members, competing, final_score FROM game_teams" + std::string(include_non_compete ? ";" : " WHERE competing = 1;"));
+            res = teamQuery.execute();
+            while (teamQuery.next()) {
 
                 nlohmann::json jsonObject;
 
@@ -117,13 +122,13 @@ int main () {
 
                 jsonObject["hide_points"] = point_calculator.getTeamHideScore(best_cache_numbers);
 
-                std::vector<int> trad_finds = point_calculator.getTeamTradFindList(team_id);
+                const std::vector<int> &trad_finds = point_calculator.getTeamTradFindList(team_id);
                 jsonObject["trad_find_points"] = point_calculator.getTotalTradFindScore(trad_finds);
                 jsonObject["trad_finds"] = nlohmann::json::array();
                 for (unsigned int i = 0; i < trad_finds.size(); i++)
                     jsonObject["trad_finds"].push_back(trad_finds.at(i));
 
-                std::vector<PointCalculator::ExtrasFind> extra_finds = point_calculator.getTeamExtrasFindList(team_id);
+                const std::vector<PointCalculator::ExtrasFind> &extra_finds = point_calculator.getTeamExtrasFindList(team_id);
                 jsonObject["extra_find_points"] = point_calculator.getTotalExtrasFindScore(extra_finds);
                 jsonObject["extra_finds"] = nlohmann::json::object();
                 for (unsigned int i = 0; i < extra_finds.size(); i++) {
@@ -139,8 +144,6 @@ int main () {
 
                 jsonDocument["teams"].push_back(jsonObject);
             }
-            delete res;
-            delete stmt;
 
             std::vector<PointCalculator::CachePoints> * trad_points = point_calculator.getPointSourceList();
             jsonDocument["trad_points"] = nlohmann::json::array();
@@ -178,9 +181,14 @@ int main () {
                     jsonDocument["unallocated_caches"].push_back(i + 1);
             }
 
-            std::cout << JsonUtils::makeJsonHeader() << jsonDocument.dump();
+            response.startPhase("render");
+            response.setContentType("application/json");
+            response.setHeader("Cache-Control", "no-store");
+            std::cout << jsonDocument.dump();
+            response.flush();
 
         } else {
+            response.discard();
             std::cout << JsonUtils::makeJsonError("You do not have permission to view this area");
         }
     } catch (sql::SQLException &e) {
@@ -191,3 +199,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
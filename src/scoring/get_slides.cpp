@@ -19,6 +19,7 @@
 #include "../core/KeyValueParser.h"
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
+#include "../core/RequestLoop.h"
 #include "PowerPoint.h"
 
 #include "../ext/nlohmann/json.hpp"
@@ -48,7 +49,7 @@ nlohmann::json getBestCachesJson(JlweCore *jlwe) {
     return jsonArray;
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -146,3 +147,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -14,6 +14,7 @@
 #include <iostream>
 #include <cmath>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "../core/CgiEnvironment.h"
@@ -23,8 +24,11 @@
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/KeyValueParser.h"
+#include "../core/RequestLoop.h"
+#include "../core/Response.h"
 
 #include "PointCalculator.h"
+#include "ScoreEngine.h"
 
 std::string scoreToText(int score) {
     if (score == -1000)
@@ -34,8 +38,10 @@ std::string scoreToText(int score) {
     return std::to_string(score / 10) + "." + std::to_string(std::abs(score % 10));
 }
 
-int main () {
+static int handleRequest() {
     try {
+        Response response;
+        response.startPhase("config");
         JlweCore jlwe;
 
         KeyValueParser urlQueries(CgiEnvironment::getQueryString(), true);
@@ -44,10 +50,13 @@ int main () {
         sql::Statement *stmt;
         sql::ResultSet *res;
 
+        response.startPhase("render");
+        response.setContentType("text/html");
         HtmlTemplate html(true);
-        html.outputHttpHtmlHeader();
-        if (!html.outputHeader(&jlwe, "JLWE Game Results", false))
+        if (!html.outputHeader(&jlwe, "JLWE Game Results", false)) {
+            response.flush();
             return 0;
+        }
 
         if (jlwe.getPermissionValue("perm_pptbuilder")) { //if logged in
             if (jlwe.getGlobalVar("public_results_enabled") != "1") {
@@ -57,6 +66,7 @@ int main () {
             if (jlwe.getGlobalVar("public_results_enabled") != "1") {
                 std::cout << "<p style=\"text-align:center;font-weight:bold;\">Game results are not yet public. Check back here after the winner is announced.</p>\n";
                 html.outputFooter();
+                response.flush();
                 return 0;
             }
         }
@@ -116,9 +126,11 @@ int main () {
                     if (!has_final_score)
                         std::cout << "<p style=\"text-align:center;font-weight:bold;\">Note: there is no final score set for this team. Please see event organisers for further details.</p>\n";
 
+                    response.startPhase("db");
                     PointCalculator point_calculator(&jlwe, number_game_caches);
+                    response.startPhase("render");
                     std::vector<PointCalculator::Cache> * cache_list = point_calculator.getCacheList();
-                    std::vector<int> trad_finds = point_calculator.getTeamTradFindList(team_id);
+                    const std::vector<int> &trad_finds = point_calculator.getTeamTradFindList(team_id);
 
                     std::cout << "<h3 style=\"text-align:center;\">Traditional cache finds</h3>\n";
                     std::cout << "<p style=\"text-align:center;\">Caches in green were found by " << Encoder::htmlEntityEncode(team_name) << ". Bonus points for &quot;hide &amp; find&quot; items are included here (hide points are shown in blue, these caches were hidden by " << Encoder::htmlEntityEncode(team_name) << ").</p>\n";
@@ -172,7 +184,7 @@ int main () {
 
                     std::cout << "<h3 style=\"text-align:center;\">Other finds</h3>\n";
                     std::vector<PointCalculator::ExtraItem> * extras_items = point_calculator.getExtrasItemsList();
-                    std::vector<PointCalculator::ExtrasFind> extra_finds = point_calculator.getTeamExtrasFindList(team_id);
+                    const std::vector<PointCalculator::ExtrasFind> &extra_finds = point_calculator.getTeamExtrasFindList(team_id);
 
                     std::cout << "<table align=\"center\" class=\"grey_table_border\">\n";
                     std::cout << "<tr><th>Item</th><th>Value</th><th>Status</th><th>Points</th></tr>\n";
@@ -289,7 +301,9 @@ int main () {
 
             std::cout << "<h2 style=\"text-align:center\">Traditional cache points</h2>\n";
 
+            response.startPhase("db");
             PointCalculator point_calculator(&jlwe, number_game_caches);
+            response.startPhase("render");
             std::vector<PointCalculator::Cache> * cache_list = point_calculator.getCacheList();
             std::vector<PointCalculator::CachePoints> * trad_points = point_calculator.getPointSourceList();
             std::vector<PointCalculator::CachePoints> trad_find_points;
@@ -341,7 +355,11 @@ int main () {
             std::cout << "<table align=\"center\">\n";
             std::cout << "<tr><th>Position</th><th>Team Name</th><th>Caches found</th><th>Points</th></tr>\n";
 
-            PointCalculator point_calculator(&jlwe, number_game_caches);
+            response.startPhase("db");
+            std::unordered_map<int, ScoreEngine::TeamTotals> team_totals;
+            for (const ScoreEngine::TeamTotals &totals : ScoreEngine::getTeamTotals(&jlwe, number_game_caches))
+                team_totals[totals.team_id] = totals;
+            response.startPhase("render");
 
             stmt = jlwe.getMysqlCon()->createStatement();
             res = stmt->executeQuery("SELECT team_id, team_name, final_score FROM game_teams WHERE competing = 1 ORDER BY final_score DESC;");
@@ -361,33 +379,10 @@ int main () {
                 }
                 std::cout << "<td><a href=\"?team_id=" << team_id << "\">" << Encoder::htmlEntityEncode(res->getString(2).substr(0, 30)) << "</a></td>\n";
 
-                std::vector<int> trad_finds = point_calculator.getTeamTradFindList(team_id);
-                int trad_find_count = 0;
-                for (unsigned int i = 0; i < trad_finds.size(); i++)
-                    if (trad_finds.at(i))
-                        trad_find_count++;
-                int total_find_points = point_calculator.getTotalTradFindScore(trad_finds);
-
-                std::vector<PointCalculator::ExtraItem> * extras_items = point_calculator.getExtrasItemsList();
-                std::vector<PointCalculator::ExtrasFind> extra_finds = point_calculator.getTeamExtrasFindList(team_id);
-                int puzzle_find_count = 0;
-                for (unsigned int i = 0; i < extras_items->size(); i++) {
-                    if (extras_items->at(i).type == 'P') {
-                        for (unsigned int j = 0; j < extra_finds.size(); j++) {
-                            if (extras_items->at(i).id == extra_finds.at(j).id)
-                                if (extra_finds.at(j).value)
-                                    puzzle_find_count++;
-                        }
-                    }
-                }
-
-                int total_extras_points = point_calculator.getTotalExtrasFindScore(extra_finds);
-                int total_hide_points = point_calculator.getTeamHideScore(team_id);
-                int total_penalty_points = (point_calculator.getCachesNotReturned(team_id) * CACHE_RETURN_PENALTY) + (point_calculator.getMinutesLate(extra_finds) * MINUTES_LATE_PENALTY);
-                int grand_total = total_find_points + total_extras_points + total_hide_points + total_penalty_points;
-
-                if (grand_total * 10 == score) {
-                    std::cout << "<td>" << trad_find_count << " + " << puzzle_find_count << "P</td>\n";
+                // Only show the finds if the final score matches the calculated one
+                auto totals = team_totals.find(team_id);
+                if (totals != team_totals.end() && totals->second.getTotal() * 10 == score) {
+                    std::cout << "<td>" << totals->second.trad_find_count << " + " << totals->second.puzzle_find_count << "P</td>\n";
                 } else {
                     std::cout << "<td></td>\n";
                 }
@@ -448,6 +443,7 @@ int main () {
 
 
         html.outputFooter();
+        response.flush();
 
     } catch (const sql::SQLException &e) {
         HtmlTemplate::outputHttpHtmlHeader();
@@ -459,3 +455,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
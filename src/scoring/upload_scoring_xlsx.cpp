@@ -22,6 +22,7 @@
 #include "../core/JlweCore.h"
 #include "../core/JlweUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 
 #include "PointCalculator.h"
 #include "../ext/nlohmann/json.hpp"
@@ -48,7 +49,7 @@ void add_parse_result_message(nlohmann::json * jsonObject, const std::string &me
     jsonObject->push_back(object);
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -79,13 +80,9 @@ int main () {
             std::string tmp_filename = std::string(dir_name) + "/scoring.xlsx";
 
             // make temp file
-            FILE* temp_file = fopen(tmp_filename.c_str(), "wb");
-            if (!temp_file)
+            if (!PostDataParser::saveFile(postData.getFiles()->at(0), tmp_filename))
                 throw std::runtime_error("Unable to create temporary file");
 
-            fwrite(postData.getFiles()->at(0).data.c_str(), 1, postData.getFiles()->at(0).data.size(), temp_file);
-            fclose(temp_file);
-
             // Check that number_game_caches is set to a valid value
             int number_game_caches = 0;
             try {
@@ -550,3 +547,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
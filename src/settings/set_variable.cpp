@@ -18,10 +18,11 @@
 #include "../core/PostDataParser.h"
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -51,6 +52,7 @@ int main () {
             res = prep_stmt->executeQuery();
             if (res->next()) {
                 if (res->getInt(1) == 0) {
+                    jlwe.invalidateGlobalVars();
                     std::cout << JsonUtils::makeJsonSuccess("Variable updated");
                 } else {
                     std::cout << JsonUtils::makeJsonError("Unable to write to variable");
@@ -71,3 +73,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
@@ -15,11 +15,12 @@
 
 #include "core/Encoder.h"
 #include "core/JlweCore.h"
+#include "core/RequestLoop.h"
 #include "prices.h"
 
 #include "ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -95,3 +96,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
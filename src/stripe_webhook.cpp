@@ -20,12 +20,13 @@
 #include "core/JlweUtils.h"
 #include "core/JsonUtils.h"
 #include "core/PostDataParser.h"
+#include "core/RequestLoop.h"
 
 #include "ext/nlohmann/json.hpp"
 #include "ext/hash_library/hmac.h"
 #include "ext/hash_library/sha256.h"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -201,3 +202,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
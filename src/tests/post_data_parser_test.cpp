@@ -0,0 +1,80 @@
+/**
+  @file    post_data_parser_test.cpp
+  @author  Ben <admin@laighside.com>
+  @version 1.0
+
+  @section DESCRIPTION
+  Checks PostDataParser with multipart bodies that are read in more than one chunk
+  The second part is moved across the end of the first 64KB chunk one byte at a time, so every place the chunk can
+  end (in the separator, the headers or the blank line after them) is tested
+
+  This file is part of the SA Geocaching JLWE website, full details (including licence) can be found on Github.
+  https://github.com/laighside/SAGeocachingJuneLWE
+ */
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../core/PostDataParser.h"
+
+#define BOUNDARY "jlweTestBoundary"
+
+// Same as READ_CHUNK_SIZE in PostDataParser.cpp
+#define CHUNK_SIZE 65536
+
+// Parses body as a multipart POST, returns false (and prints why) if the file or field is wrong
+static bool checkBody(const std::string &body, size_t fileSize, const std::string &description) {
+    setenv("REQUEST_METHOD", "POST", 1);
+    setenv("CONTENT_TYPE", "multipart/form-data; boundary=" BOUNDARY, 1);
+    setenv("CONTENT_LENGTH", std::to_string(body.size()).c_str(), 1);
+
+    std::istringstream input(body);
+    std::streambuf *oldBuffer = std::cin.rdbuf(input.rdbuf());
+    bool ok;
+    {
+        PostDataParser postData(10000000);
+        std::vector<PostDataParser::FormFile> *files = postData.getFiles();
+        ok = !postData.hasError() && files->size() == 1 && files->at(0).size == fileSize && postData.getValue("a") == "value-a";
+        if (!ok)
+            std::cerr << description << ": " << (postData.hasError() ? postData.errorText() : "wrong file or field") << std::endl;
+    }
+    std::cin.rdbuf(oldBuffer);
+    std::cin.clear();
+    return ok;
+}
+
+// A file field followed by a text field "a"
+static std::string makeBody(size_t fileSize, std::string *secondPartStart) {
+    std::string body = "--" BOUNDARY "\r\n"
+                       "Content-Disposition: form-data; name=\"f\"; filename=\"test.bin\"\r\n"
+                       "Content-Type: application/octet-stream\r\n\r\n";
+    body.append(fileSize, 'x');
+    body += "\r\n--" BOUNDARY "\r\n";
+    *secondPartStart = std::to_string(body.size());
+    body += "Content-Disposition: form-data; name=\"a\"\r\n\r\nvalue-a\r\n--" BOUNDARY "--\r\n";
+    return body;
+}
+
+int main() {
+    int failures = 0;
+    std::string secondPartStart;
+
+    if (!checkBody(makeBody(100, &secondPartStart), 100, "single chunk"))
+        failures++;
+
+    // The parser adds 2 bytes to the start of the body, so the first chunk ends at CHUNK_SIZE - 2 in the body
+    size_t headerSize = makeBody(0, &secondPartStart).size() - std::stoul(secondPartStart);
+    size_t fileSizeAtChunkEnd = CHUNK_SIZE - 2 - std::stoul(secondPartStart);
+    for (size_t fileSize = fileSizeAtChunkEnd - headerSize - 24; fileSize <= fileSizeAtChunkEnd + 24; fileSize++) {
+        std::string body = makeBody(fileSize, &secondPartStart);
+        if (!checkBody(body, fileSize, "second part at byte " + secondPartStart + " of " + std::to_string(body.size())))
+            failures++;
+    }
+
+    if (failures) {
+        std::cerr << failures << " failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
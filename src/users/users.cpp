@@ -17,6 +17,7 @@
 #include "../core/Encoder.h"
 #include "../core/HtmlTemplate.h"
 #include "../core/JlweCore.h"
+#include "../core/RequestLoop.h"
 
 static inline std::string boolToChecked(bool checked) {
     if (checked) {
@@ -26,7 +27,7 @@ static inline std::string boolToChecked(bool checked) {
     }
 }
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -279,3 +280,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
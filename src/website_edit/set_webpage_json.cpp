@@ -18,10 +18,12 @@
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
+#include "../core/StaticPages.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -60,10 +62,20 @@ int main () {
                 prep_stmt->setString(6, jlwe.getCurrentUsername());
                 res = prep_stmt->executeQuery();
                 if (res->next()) {
+                    // Drafts aren't public, so only saving the public version changes the pre-rendered pages
+                    std::string publishError;
+                    if (res->getInt(1) >= 0 && draft_page == 0) {
+                        try {
+                            StaticPages::publish(&jlwe);
+                        } catch (const std::exception &e) {
+                            publishError = std::string(" (but the static copy of the website could not be updated: ") + e.what() + ")";
+                        }
+                    }
+
                     if (res->getInt(1) == 1) {
-                        std::cout << JsonUtils::makeJsonSuccess("Webpage updated");
+                        std::cout << JsonUtils::makeJsonSuccess("Webpage updated" + publishError);
                     } else if (res->getInt(1) == 0) {
-                        std::cout << JsonUtils::makeJsonSuccess("New webpage created");
+                        std::cout << JsonUtils::makeJsonSuccess("New webpage created" + publishError);
                     } else {
                         std::cout << JsonUtils::makeJsonError("Unable to save changes");
                     }
@@ -86,3 +98,7 @@ int main () {
 
     return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}
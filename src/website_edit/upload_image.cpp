@@ -20,10 +20,11 @@
 #include "../core/JlweCore.h"
 #include "../core/JsonUtils.h"
 #include "../core/PostDataParser.h"
+#include "../core/RequestLoop.h"
 
 #include "../ext/nlohmann/json.hpp"
 
-int main () {
+static int handleRequest() {
     try {
         JlweCore jlwe;
 
@@ -61,14 +62,11 @@ int main () {
                             std::cout << JsonUtils::makeJsonError("The file \"" + filename + "\" already exists");
                         } else {
                             std::string file_dir = CgiEnvironment::getDocumentRoot() + std::string(jlwe.config.at("files").at("imagePrefix")) + "/";
-                            FILE *file = fopen(std::string(file_dir + filename).c_str(), "wb");
-                            if (file){
-                                fwrite(inputFile.data.data(), 1, inputFile.data.size(), file);
-                                fclose(file);
+                            if (PostDataParser::saveFile(inputFile, file_dir + filename)) {
 
                                 prep_stmt = jlwe.getMysqlCon()->prepareStatement("SELECT createWebpageImage(?,?,?,?);");
                                 prep_stmt->setString(1, filename);
-                                prep_stmt->setUInt(2, inputFile.data.size());
+                                prep_stmt->setUInt(2, inputFile.size);
                                 prep_stmt->setString(3, jlwe.getCurrentUsername());
                                 prep_stmt->setString(4, jlwe.getCurrentUserIP());
                                 res = prep_stmt->executeQuery();
@@ -108,3 +106,7 @@ int main () {
 
    return 0;
 }
+
+int main () {
+    return RequestLoop::run(handleRequest);
+}